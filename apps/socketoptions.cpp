@@ -22,6 +22,17 @@ extern const std::map<std::string, int> enummap_transtype = {
     { "file", SRTT_FILE }
 };
 
+extern const std::map<std::string, int> enummap_bufalloc = {
+    { "default", SRT_BUFALLOC_DEFAULT },
+    { "hugepages", SRT_BUFALLOC_HUGEPAGES },
+    { "numa", SRT_BUFALLOC_HUGEPAGES_NUMA }
+};
+
+extern const std::map<std::string, int> enummap_sndsched = {
+    { "heap", SRT_SNDSCHED_HEAP },
+    { "wheel", SRT_SNDSCHED_WHEEL }
+};
+
 
 const char* const SocketOption::mode_names[3] = {
     "listener", "caller", "rendezvous"
@@ -205,6 +205,8 @@ inline bool SocketOption::apply(Object socket, std::string value) const
 }
 
 extern const std::map<std::string, int> enummap_transtype;
+extern const std::map<std::string, int> enummap_bufalloc;
+extern const std::map<std::string, int> enummap_sndsched;
 
 namespace {
 const SocketOption srt_options [] {
@@ -245,7 +247,22 @@ const SocketOption srt_options [] {
     { "packetfilter", 0, SRTO_PACKETFILTER, SocketOption::PRE, SocketOption::STRING, nullptr },
     { "groupconnect", 0, SRTO_GROUPCONNECT, SocketOption::PRE, SocketOption::INT, nullptr},
     { "groupstabtimeo", 0, SRTO_GROUPSTABTIMEO, SocketOption::PRE, SocketOption::INT, nullptr},
-    { "rexmitalgo", 0, SRTO_RETRANSMISSION_ALGORITHM, SocketOption::PRE, SocketOption::INT, nullptr }
+    { "rexmitalgo", 0, SRTO_RETRANSMISSION_ALGORITHM, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "udpsndbatch", 0, SRTO_UDP_SNDBATCH, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "udprcvbatch", 0, SRTO_UDP_RCVBATCH, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "udpgso", 0, SRTO_UDP_GSO, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udpgro", 0, SRTO_UDP_GRO, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udprcvshards", 0, SRTO_UDP_RCVSHARDS, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "udpsndshards", 0, SRTO_UDP_SNDSHARDS, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "udpiouring", 0, SRTO_UDP_IOURING, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udptxtime", 0, SRTO_UDP_TXTIME, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udptimestamp", 0, SRTO_UDP_TIMESTAMP, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udprcvpoolhold", 0, SRTO_UDP_RCVPOOLHOLD, SocketOption::PRE, SocketOption::INT, nullptr },
+    { "bufalloc", 0, SRTO_BUFALLOC, SocketOption::PRE, SocketOption::ENUM, &enummap_bufalloc },
+    { "udpsndsched", 0, SRTO_UDP_SNDSCHED, SocketOption::PRE, SocketOption::ENUM, &enummap_sndsched },
+    { "udpsinglethread", 0, SRTO_UDP_SINGLETHREAD, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "udpnothreads", 0, SRTO_UDP_NOTHREADS, SocketOption::PRE, SocketOption::BOOL, nullptr },
+    { "rcvloans", 0, SRTO_RCVLOANS, SocketOption::POST, SocketOption::INT, nullptr }
 };
 }
 
@@ -43,6 +43,7 @@ set cmake_options {
     enable-logging "Should logging be enabled (default: ON)"
     enable-debug=<0,1,2> "Enable debug mode (0=disabled, 1=debug, 2=rel-with-debug)"
     enable-haicrypt-logging "Should logging in haicrypt be enabled (default: OFF)"
+    enable-iouring "Should the io_uring backend for the UDP channel be built, Linux only (default: OFF)"
     enable-inet-pton "Set to OFF to prevent usage of inet_pton when building against modern SDKs (default: ON)"
     enable-code-coverage "Enable code coverage reporting (default: OFF)"
     enable-monotonic-clock "Enforced clock_gettime with monotonic clock on GC CV /temporary fix for #729/ (default: OFF)"
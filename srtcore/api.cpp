@@ -464,7 +464,7 @@ SRTSOCKET CUDTUnited::newSocket(CUDTSocket** pps)
 }
 
 int CUDTUnited::newConnection(const SRTSOCKET listen, const sockaddr_any& peer, const CPacket& hspkt,
-        CHandShake& w_hs, int& w_error)
+        CRcvQueue* rcvq, CHandShake& w_hs, int& w_error)
 {
    CUDTSocket* ns = NULL;
 
@@ -599,7 +599,7 @@ int CUDTUnited::newConnection(const SRTSOCKET listen, const sockaddr_any& peer,
 
        // bind to the same addr of listening socket
        ns->m_pUDT->open();
-       updateListenerMux(ns, ls);
+       updateListenerMux(ns, ls, rcvq);
        if (ls->m_pUDT->m_cbAcceptHook)
        {
            if (!ls->m_pUDT->runAcceptHook(ns->m_pUDT, peer.get(), w_hs, hspkt))
@@ -943,6 +943,8 @@ int CUDTUnited::listen(const SRTSOCKET u, int backlog)
 
    // [[using assert(s->m_Status == OPENED)]]; // (still, unchanged)
 
+   openRcvShards(s);
+
    s->m_pUDT->setListenState();  // propagates CUDTException,
                                  // if thrown, remains in OPENED state if so.
    s->m_Status = SRTS_LISTENING;
@@ -1598,6 +1600,16 @@ int CUDTUnited::connectIn(CUDTSocket* s, const sockaddr_any& target_addr, int32_
    else if (s->m_Status != SRTS_OPENED)
       throw CUDTException(MJ_NOTSUP, MN_ISCONNECTED, 0);
 
+   {
+       // The packets from the peer may be delivered to any of the receiving
+       // sockets of a listener's multiplexer, while a connecting socket can
+       // be only served by one of them.
+       ScopedLock cg(m_GlobControlLock);
+       map<int, CMultiplexer>::iterator m = m_mMultiplexer.find(s->m_iMuxID);
+       if (m != m_mMultiplexer.end() && !m->second.m_vRcvShards.empty())
+           throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+   }
+
    // connect_complete() may be called before connect() returns.
    // So we need to update the status before connect() is called,
    // otherwise the status may be overwritten with wrong value
@@ -2317,12 +2329,14 @@ void CUDTUnited::checkBrokenSockets()
       }
 
       // timeout 1 second to destroy a socket AND it has been removed from
-      // RcvUList
+      // RcvUList (by the GC itself if no worker thread would do it)
       const steady_clock::time_point now = steady_clock::now();
       const steady_clock::duration closed_ago = now - j->second->m_tsClosureTimeStamp;
+      CUDT* u = j->second->m_pUDT;
       if ((closed_ago > seconds_from(1))
-         && ((!j->second->m_pUDT->m_pRNode)
-            || !j->second->m_pUDT->m_pRNode->m_bOnList))
+         && ((!u->m_pRNode)
+            || !u->m_pRNode->m_bOnList
+            || (u->m_pRcvQueue && u->m_pRcvQueue->removePolled(u))))
       {
          HLOGC(mglog.Debug, log << "checkBrokenSockets: @" << j->second->m_SocketID << " closed "
                  << FormatDuration(closed_ago) << " ago and removed from RcvQ - will remove");
@@ -2353,6 +2367,7 @@ void CUDTUnited::removeSocket(const SRTSOCKET u)
 
    // decrease multiplexer reference count, and remove it if necessary
    const int mid = s->m_iMuxID;
+   CSndQueue* const sndq = s->m_pUDT->m_pSndQueue;
 
    if (s->m_pQueuedSockets)
    {
@@ -2420,6 +2435,9 @@ void CUDTUnited::removeSocket(const SRTSOCKET u)
 
    CMultiplexer& mx = m->second;
 
+   if (sndq)
+      sndq->updateSocketCount(-1);
+
    mx.m_iRefCount --;
    // HLOGF(mglog.Debug, "unrefing underlying socket for %u: %u\n",
    //    u, mx.m_iRefCount);
@@ -2434,9 +2452,25 @@ void CUDTUnited::removeSocket(const SRTSOCKET u)
       // because this will cause error to be returned in any operation
       // being currently done in the queues, if any.
       mx.m_pSndQueue->setClosing();
+      for (size_t i = 0; i < mx.m_vSndShards.size(); ++ i)
+         mx.m_vSndShards[i]->setClosing();
       mx.m_pRcvQueue->setClosing();
-      delete mx.m_pSndQueue;
+      for (size_t i = 0; i < mx.m_vRcvShards.size(); ++ i)
+         mx.m_vRcvShards[i]->setClosing();
+      // The receiving worker may be sending through the sending queue.
       delete mx.m_pRcvQueue;
+      for (size_t i = 0; i < mx.m_vRcvShards.size(); ++ i)
+      {
+         delete mx.m_vRcvShards[i];
+         mx.m_vShardChannels[i]->close();
+         delete mx.m_vShardChannels[i];
+      }
+      delete mx.m_pSndQueue;
+      for (size_t i = 0; i < mx.m_vSndShards.size(); ++ i)
+      {
+         delete mx.m_vSndShards[i];
+         delete mx.m_vSndShardTimers[i];
+      }
       mx.m_pChannel->close();
       delete mx.m_pTimer;
       delete mx.m_pChannel;
@@ -2469,6 +2503,20 @@ void CUDTUnited::updateMux(
                   &&  (i->second.m_iIpTTL == s->m_pUDT->m_iIpTTL)
                   && (i->second.m_iIpToS == s->m_pUDT->m_iIpToS)
                   && (i->second.m_iIpV6Only == s->m_pUDT->m_iIpV6Only)
+                  && (i->second.m_iSndBatch == s->m_pUDT->m_iUDPSndBatch)
+                  && (i->second.m_iRcvBatch == s->m_pUDT->m_iUDPRcvBatch)
+                  && (i->second.m_bGSO == s->m_pUDT->m_bUDPGSO)
+                  && (i->second.m_bGRO == s->m_pUDT->m_bUDPGRO)
+                  && (i->second.m_iRcvShards == s->m_pUDT->m_iUDPRcvShards)
+                  && (i->second.m_iSndShards == s->m_pUDT->m_iUDPSndShards)
+                  && (i->second.m_bIOUring == s->m_pUDT->m_bUDPIOUring)
+                  && (i->second.m_bTxTime == s->m_pUDT->m_bUDPTxTime)
+                  && (i->second.m_bTimestamp == s->m_pUDT->m_bUDPTimestamp)
+                  && (i->second.m_iRcvPoolHold == s->m_pUDT->m_iUDPRcvPoolHold)
+                  && (i->second.m_iBufAlloc == s->m_pUDT->m_iBufAlloc)
+                  && (i->second.m_iSndSched == s->m_pUDT->m_iUDPSndSched)
+                  && (i->second.m_bSingleThread == s->m_pUDT->m_bUDPSingleThread)
+                  && (i->second.m_bNoThreads == s->m_pUDT->m_bUDPNoThreads)
                   &&  i->second.m_bReusable)
           {
             if (i->second.m_iPort == port)
@@ -2477,7 +2525,7 @@ void CUDTUnited::updateMux(
                // %hd\n", port);
                // reuse the existing multiplexer
                ++ i->second.m_iRefCount;
-               s->m_pUDT->m_pSndQueue = i->second.m_pSndQueue;
+               s->m_pUDT->m_pSndQueue = assignSndQueue(i->second);
                s->m_pUDT->m_pRcvQueue = i->second.m_pRcvQueue;
                s->m_iMuxID = i->second.m_iID;
                return;
@@ -2486,6 +2534,18 @@ void CUDTUnited::updateMux(
       }
    }
 
+   // With SO_REUSEPORT the binding would succeed and the new socket would
+   // take over a part of the traffic of another multiplexer on that port.
+   if (!udpsock && s->m_pUDT->m_iUDPRcvShards > 1 && addr.hport() != 0)
+   {
+      for (map<int, CMultiplexer>::iterator i = m_mMultiplexer.begin();
+         i != m_mMultiplexer.end(); ++ i)
+      {
+         if (i->second.m_iIPversion == addr.family() && i->second.m_iPort == addr.hport())
+            throw CUDTException(MJ_SETUP, MN_NORES, EADDRINUSE);
+      }
+   }
+
    // a new multiplexer is needed
    CMultiplexer m;
    m.m_iMSS = s->m_pUDT->m_iMSS;
@@ -2494,16 +2554,28 @@ void CUDTUnited::updateMux(
    m.m_iIpToS = s->m_pUDT->m_iIpToS;
    m.m_iRefCount = 1;
    m.m_iIpV6Only = s->m_pUDT->m_iIpV6Only;
+   m.m_iSndBatch = s->m_pUDT->m_iUDPSndBatch;
+   m.m_iRcvBatch = s->m_pUDT->m_iUDPRcvBatch;
+   m.m_bGSO = s->m_pUDT->m_bUDPGSO;
+   m.m_bGRO = s->m_pUDT->m_bUDPGRO;
    m.m_bReusable = s->m_pUDT->m_bReuseAddr;
+   m.m_iRcvShards = s->m_pUDT->m_iUDPRcvShards;
+   m.m_bRcvSteering = false;
+   m.m_iSndShards = s->m_pUDT->m_iUDPSndShards;
+   m.m_bIOUring = s->m_pUDT->m_bUDPIOUring;
+   m.m_bTxTime = s->m_pUDT->m_bUDPTxTime;
+   m.m_bTimestamp = s->m_pUDT->m_bUDPTimestamp;
+   m.m_iRcvPoolHold = s->m_pUDT->m_iUDPRcvPoolHold;
+   m.m_iBufAlloc = s->m_pUDT->m_iBufAlloc;
+   m.m_iSndSched = s->m_pUDT->m_iUDPSndSched;
+   m.m_bSingleThread = s->m_pUDT->m_bUDPSingleThread;
+   m.m_bNoThreads = s->m_pUDT->m_bUDPNoThreads;
    m.m_iID = s->m_SocketID;
 
-   m.m_pChannel = new CChannel();
-   m.m_pChannel->setIpTTL(s->m_pUDT->m_iIpTTL);
-   m.m_pChannel->setIpToS(s->m_pUDT->m_iIpToS);
-   m.m_pChannel->setSndBufSize(s->m_pUDT->m_iUDPSndBufSize);
-   m.m_pChannel->setRcvBufSize(s->m_pUDT->m_iUDPRcvBufSize);
-   if (s->m_pUDT->m_iIpV6Only != -1)
-      m.m_pChannel->setIpV6Only(s->m_pUDT->m_iIpV6Only);
+   m.m_pChannel = createChannel(m, s->m_pUDT);
+
+   // The receiving worker waits also for the packets to be sent.
+   m.m_pChannel->setWakeup(m.m_bSingleThread && !m.m_bNoThreads);
 
    try
    {
@@ -2543,16 +2615,30 @@ void CUDTUnited::updateMux(
 
    m.m_pTimer = new CTimer;
 
+   // Without threads the receiving queue sends the packets as in the single-thread mode.
+   const bool sndthread = !m.m_bSingleThread && !m.m_bNoThreads;
    m.m_pSndQueue = new CSndQueue;
-   m.m_pSndQueue->init(m.m_pChannel, m.m_pTimer);
+   m.m_pSndQueue->init(m.m_pChannel, m.m_pTimer, m.m_iSndBatch, m.m_iSndSched, sndthread);
+   for (int n = 1; n < m.m_iSndShards && sndthread; ++ n)
+   {
+      // Every sending worker sleeps on its own timer.
+      CTimer* t = new CTimer;
+      CSndQueue* q = new CSndQueue;
+      q->m_iShard = n;
+      q->init(m.m_pChannel, t, m.m_iSndBatch, m.m_iSndSched);
+      m.m_vSndShardTimers.push_back(t);
+      m.m_vSndShards.push_back(q);
+   }
    m.m_pRcvQueue = new CRcvQueue;
+   m.m_pRcvQueue->m_UnitQueue.setHoldDown(milliseconds_from(m.m_iRcvPoolHold));
+   m.m_pRcvQueue->m_UnitQueue.setAllocPolicy(m.m_iBufAlloc);
    m.m_pRcvQueue->init(
       32, s->m_pUDT->maxPayloadSize(), m.m_iIPversion, 1024,
-      m.m_pChannel, m.m_pTimer);
+      m.m_pChannel, m.m_pTimer, m.m_iRcvBatch, sndthread ? NULL : m.m_pSndQueue, !m.m_bNoThreads);
 
    m_mMultiplexer[m.m_iID] = m;
 
-   s->m_pUDT->m_pSndQueue = m.m_pSndQueue;
+   s->m_pUDT->m_pSndQueue = assignSndQueue(m);
    s->m_pUDT->m_pRcvQueue = m.m_pRcvQueue;
    s->m_iMuxID = m.m_iID;
 
@@ -2604,7 +2690,118 @@ void CUDTUnited::updateMux(
 // When deleting, you simply "unsubscribe" yourself from the multiplexer, which
 // will unref it and remove the list element by the iterator kept by the
 // socket.
-void CUDTUnited::updateListenerMux(CUDTSocket* s, const CUDTSocket* ls)
+// Returns the sending queue of the multiplexer that serves the least sockets.
+CSndQueue* CUDTUnited::assignSndQueue(CMultiplexer& m)
+{
+   CSndQueue* q = m.m_pSndQueue;
+   int count = q->getSocketCount();
+   for (size_t i = 0; i < m.m_vSndShards.size(); ++ i)
+   {
+      const int c = m.m_vSndShards[i]->getSocketCount();
+      if (c < count)
+      {
+         q = m.m_vSndShards[i];
+         count = c;
+      }
+   }
+
+   q->updateSocketCount(1);
+   return q;
+}
+
+CChannel* CUDTUnited::createChannel(const CMultiplexer& m, const CUDT* u)
+{
+   CChannel* c = new CChannel();
+   c->setIpTTL(u->m_iIpTTL);
+   c->setIpToS(u->m_iIpToS);
+   c->setSndBufSize(u->m_iUDPSndBufSize);
+   c->setRcvBufSize(u->m_iUDPRcvBufSize);
+   c->setGSO(m.m_bGSO);
+   c->setGRO(m.m_bGRO);
+   c->setReusePort(m.m_iRcvShards > 1);
+   c->setIOUring(m.m_bIOUring && !m.m_bNoThreads);
+   c->setTxTime(m.m_bTxTime);
+   // The packets read in one batch need the arrival time from the system
+   // to take part in the arrival speed measurement.
+   c->setTimestamp(m.m_bTimestamp || m.m_iRcvBatch > 1 || m.m_bGRO || m.m_bIOUring);
+   if (u->m_iIpV6Only != -1)
+      c->setIpV6Only(u->m_iIpV6Only);
+   return c;
+}
+
+// Opens the additional receiving sockets on the port of the listener, as
+// requested by SRTO_UDP_RCVSHARDS. Where possible, the system is then told
+// to deliver the packets to the sockets by their destination socket ID,
+// otherwise it distributes them by the source address and every connection
+// is served by the receive queue that got its handshake.
+void CUDTUnited::openRcvShards(CUDTSocket* s)
+{
+   ScopedLock cg(m_GlobControlLock);
+
+   map<int, CMultiplexer>::iterator i = m_mMultiplexer.find(s->m_iMuxID);
+   if (i == m_mMultiplexer.end())
+      return;
+
+   CMultiplexer& m = i->second;
+   if (m.m_iRcvShards <= 1 || !m.m_vRcvShards.empty() || m.m_bNoThreads)
+      return;
+
+   if (!m.m_pChannel->getReusePort())
+   {
+      LOGC(mglog.Warn, log << "listen: port sharing not available, using one receiving socket");
+      return;
+   }
+
+   // Other sockets already bound to this multiplexer might get their
+   // packets through another receiving socket than their own.
+   if (m.m_iRefCount > 1)
+   {
+      LOGC(mglog.Warn, log << "listen: multiplexer for port " << m.m_iPort
+            << " is shared with other sockets, using one receiving socket");
+      return;
+   }
+
+   sockaddr_any sa;
+   m.m_pChannel->getSockAddr((sa));
+
+   CRcvQueue* last = m.m_pRcvQueue;
+   for (int n = 1; n < m.m_iRcvShards; ++ n)
+   {
+      CChannel* c = createChannel(m, s->m_pUDT);
+      try
+      {
+         c->open(sa);
+      }
+      catch (CUDTException& e)
+      {
+         LOGC(mglog.Error, log << "listen: failed to open receiving socket " << (n + 1) << " of "
+               << m.m_iRcvShards << " for port " << m.m_iPort << ": " << e.getErrorMessage());
+         c->close();
+         delete c;
+         break;
+      }
+
+      CRcvQueue* q = new CRcvQueue;
+      q->m_iShard = n;
+      q->m_UnitQueue.setHoldDown(milliseconds_from(m.m_iRcvPoolHold));
+      q->m_UnitQueue.setAllocPolicy(m.m_iBufAlloc);
+      q->init(32, s->m_pUDT->maxPayloadSize(), m.m_iIPversion, 1024, c, m.m_pTimer, m.m_iRcvBatch);
+
+      m.m_vShardChannels.push_back(c);
+      m.m_vRcvShards.push_back(q);
+      last->m_pNextShard = q;
+      last = q;
+   }
+
+   if (!m.m_vRcvShards.empty())
+      m.m_bRcvSteering = m.m_pChannel->setReusePortSteering(int(m.m_vRcvShards.size()) + 1);
+
+   HLOGC(mglog.Debug, log << "listen: port " << m.m_iPort << " served by "
+         << (m.m_vRcvShards.size() + 1) << " receiving sockets"
+         << (m.m_bRcvSteering ? ", steered by socket ID" : ""));
+}
+
+void CUDTUnited::updateListenerMux(CUDTSocket* s, const CUDTSocket* ls, CRcvQueue* rcvq)
 {
    ScopedLock cg(m_GlobControlLock);
    const int port = ls->m_SelfAddr.hport();
@@ -2619,8 +2816,14 @@ void CUDTUnited::updateListenerMux(CUDTSocket* s, const CUDTSocket* ls)
             "updateMux: reusing multiplexer for port %i\n", port);
          // reuse the existing multiplexer
          ++ i->second.m_iRefCount;
-         s->m_pUDT->m_pSndQueue = i->second.m_pSndQueue;
-         s->m_pUDT->m_pRcvQueue = i->second.m_pRcvQueue;
+         s->m_pUDT->m_pSndQueue = assignSndQueue(i->second);
+         // Stay with the receiving socket that the peer's packets come to.
+         if (i->second.m_bRcvSteering)
+         {
+            const size_t shard = size_t(s->m_SocketID) % (i->second.m_vRcvShards.size() + 1);
+            rcvq = shard == 0 ? i->second.m_pRcvQueue : i->second.m_vRcvShards[shard - 1];
+         }
+         s->m_pUDT->m_pRcvQueue = rcvq ? rcvq : i->second.m_pRcvQueue;
          s->m_iMuxID = i->second.m_iID;
          return;
       }
@@ -3274,6 +3477,60 @@ int CUDT::sendmsg2(
    }
 }
 
+int CUDT::sendmsg_zc(
+   SRTSOCKET u, const char* buf, int len, SRT_MSGCTRL& w_m,
+   srt_send_release_fn* release, void* release_opaque)
+{
+   try
+   {
+       // The group sending may need the data after the member
+       // sockets have released them, so only sockets are supported.
+       if (!release || (u & SRTGROUP_MASK))
+           throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+       return s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().sendmsg2(buf, len, (w_m), release, release_opaque);
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (bad_alloc&)
+   {
+      return APIError(MJ_SYSTEMRES, MN_MEMORY, 0);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "sendmsg_zc: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
+int CUDT::sendmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count)
+{
+   try
+   {
+       if (!msgs || (u & SRTGROUP_MASK))
+           throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+       return s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().sendmmsg(msgs, count);
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (bad_alloc&)
+   {
+      return APIError(MJ_SYSTEMRES, MN_MEMORY, 0);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "sendmmsg: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
 int CUDT::recv(SRTSOCKET u, char* buf, int len, int)
 {
     SRT_MSGCTRL mctrl = srt_msgctrl_default;
@@ -3312,6 +3569,91 @@ int CUDT::recvmsg2(SRTSOCKET u, char* buf, int len, SRT_MSGCTRL& w_m)
    }
 }
 
+int CUDT::recvmsgv(SRTSOCKET u, const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_m)
+{
+   try
+   {
+      if (!iov || iovcnt <= 0 || (u & SRTGROUP_MASK))
+         throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+      return s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().recvmsgv(iov, iovcnt, (w_m));
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "recvmsgv: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
+int CUDT::recvmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count)
+{
+   try
+   {
+      if (!msgs || (u & SRTGROUP_MASK))
+         throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+      return s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().recvmmsg(msgs, count);
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "recvmmsg: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
+int CUDT::recvmsg_loan(SRTSOCKET u, SRT_LOAN& w_loan, SRT_MSGCTRL& w_m)
+{
+   try
+   {
+      if (u & SRTGROUP_MASK)
+         throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+      return s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().recvmsgLoan((w_loan), (w_m));
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "recvmsg_loan: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
+int CUDT::loan_return(SRTSOCKET u, SRT_LOAN& w_loan)
+{
+   try
+   {
+      if (u & SRTGROUP_MASK)
+         throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+      s_UDTUnited.locateSocket(u, CUDTUnited::ERH_THROW)->core().returnLoan((w_loan));
+      return 0;
+   }
+   catch (const CUDTException& e)
+   {
+      return APIError(e);
+   }
+   catch (const std::exception& ee)
+   {
+      LOGC(mglog.Fatal, log << "loan_return: UNEXPECTED EXCEPTION: "
+         << typeid(ee).name() << ": " << ee.what());
+      return APIError(MJ_UNKNOWN, MN_NONE, 0);
+   }
+}
+
 int64_t CUDT::sendfile(
    SRTSOCKET u, fstream& ifs, int64_t& offset, int64_t size, int block)
 {
@@ -202,11 +202,12 @@ public:
       /// Create a new UDT connection.
       /// @param [in] listen the listening UDT socket;
       /// @param [in] peer peer address.
+      /// @param [in] rcvq the receive queue that got the handshake; it will serve the new connection.
       /// @param [in,out] hs handshake information from peer side (in), negotiated value (out);
       /// @return If the new connection is successfully created: 1 success, 0 already exist, -1 error.
 
    int newConnection(const SRTSOCKET listen, const sockaddr_any& peer, const CPacket& hspkt,
-           CHandShake& w_hs, int& w_error);
+           CRcvQueue* rcvq, CHandShake& w_hs, int& w_error);
 
    int installAcceptHook(const SRTSOCKET lsn, srt_listen_callback_fn* hook, void* opaq);
 
@@ -345,7 +346,10 @@ private:
    CUDTSocket* locatePeer(const sockaddr_any& peer, const SRTSOCKET id, int32_t isn);
    CUDTGroup* locateGroup(SRTSOCKET u, ErrorHandling erh = ERH_RETURN);
    void updateMux(CUDTSocket* s, const sockaddr_any& addr, const UDPSOCKET* = NULL);
-   void updateListenerMux(CUDTSocket* s, const CUDTSocket* ls);
+   void updateListenerMux(CUDTSocket* s, const CUDTSocket* ls, CRcvQueue* rcvq);
+   void openRcvShards(CUDTSocket* s);
+   CChannel* createChannel(const CMultiplexer& m, const CUDT* u);
+   CSndQueue* assignSndQueue(CMultiplexer& m);
 
 private:
    std::map<int, CMultiplexer> m_mMultiplexer;		// UDP multiplexer
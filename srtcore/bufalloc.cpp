@@ -0,0 +1,139 @@
+/*
+ * SRT - Secure, Reliable, Transport
+ * Copyright (c) 2020 Haivision Systems Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include "platform_sys.h"
+
+#include <new>
+#include "srt.h"
+#include "bufalloc.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
+
+#if defined(__linux__) && defined(MAP_HUGETLB) && defined(MADV_HUGEPAGE)
+#define SRT_ENABLE_HUGEPAGES 1
+#endif
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+int srt::currentNumaNode()
+{
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+        return int(node);
+#endif
+    return -1;
+}
+
+int srt::roundPayloadCount(int count, int size, int policy)
+{
+#ifdef SRT_ENABLE_HUGEPAGES
+    if (policy != SRT_BUFALLOC_DEFAULT)
+    {
+        const size_t pages = (size_t(count) * size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE;
+        return int(pages * HUGE_PAGE_SIZE / size);
+    }
+#else
+    (void)size;
+    (void)policy;
+#endif
+    return count;
+}
+
+#ifdef SRT_ENABLE_HUGEPAGES
+static size_t roundHugePages(size_t size)
+{
+    return (size + srt::HUGE_PAGE_SIZE - 1) & ~(srt::HUGE_PAGE_SIZE - 1);
+}
+
+static char* mapHugePages(size_t size)
+{
+    // Reserved huge pages of the 2 MB size, if the system has any.
+    void* p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+    if (p != MAP_FAILED)
+        return (char*)p;
+
+    // Otherwise regular memory, aligned to the huge page size, so that
+    // the kernel can back it with transparent huge pages.
+    const size_t span = size + srt::HUGE_PAGE_SIZE;
+    p = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    char* const start   = (char*)p;
+    char* const aligned = (char*)(((uintptr_t)start + srt::HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(srt::HUGE_PAGE_SIZE - 1));
+    if (aligned != start)
+        munmap(start, aligned - start);
+    if (aligned + size != start + span)
+        munmap(aligned + size, (start + span) - (aligned + size));
+
+    madvise(aligned, size, MADV_HUGEPAGE);
+    return aligned;
+}
+#endif
+
+char* srt::allocPayloadBuffer(size_t size, int policy, int node)
+{
+#ifdef SRT_ENABLE_HUGEPAGES
+    if (policy != SRT_BUFALLOC_DEFAULT)
+    {
+        size = roundHugePages(size);
+        char* buf = mapHugePages(size);
+        if (!buf)
+            return NULL;
+
+#ifdef SYS_mbind
+        // The pages are not allocated until they are written to, so the
+        // policy applies to all of them. The node is only preferred, so
+        // that running out of memory on it doesn't kill the process.
+        if (policy == SRT_BUFALLOC_HUGEPAGES_NUMA && node >= 0 && node < 63)
+        {
+            const unsigned long mask = 1UL << node;
+            syscall(SYS_mbind, buf, size, MPOL_PREFERRED, &mask, 64UL, 0U);
+        }
+#else
+        (void)node;
+#endif
+        return buf;
+    }
+#else
+    (void)policy;
+    (void)node;
+#endif
+
+    return new (std::nothrow) char[size];
+}
+
+void srt::freePayloadBuffer(char* buf, size_t size, int policy)
+{
+    if (!buf)
+        return;
+
+#ifdef SRT_ENABLE_HUGEPAGES
+    if (policy != SRT_BUFALLOC_DEFAULT)
+    {
+        munmap(buf, roundHugePages(size));
+        return;
+    }
+#else
+    (void)size;
+    (void)policy;
+#endif
+
+    delete[] buf;
+}
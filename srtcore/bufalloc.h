@@ -0,0 +1,59 @@
+/*
+ * SRT - Secure, Reliable, Transport
+ * Copyright (c) 2020 Haivision Systems Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ */
+#pragma once
+#ifndef INC_SRT_BUFALLOC_H
+#define INC_SRT_BUFALLOC_H
+
+// Allocation of the memory that holds the packet payloads: the receiver
+// units of a multiplexer and the sender buffer of a socket. The policy is
+// one of the SRT_BUFALLOC values (see SRTO_BUFALLOC). With huge pages, the
+// memory is taken from the reserved huge pages if there are any, otherwise
+// from transparent huge pages. Where huge pages are not supported, the
+// memory is allocated the regular way whatever the policy.
+
+#include <cstddef>
+
+namespace srt
+{
+
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+   /// Get the NUMA node of the CPU on which the calling thread runs.
+   /// @return Node number, or -1 if it can't be determined.
+
+int currentNumaNode();
+
+   /// Round up the number of payloads in one buffer so that the buffer
+   /// takes whole pages of the given policy.
+   /// @param [in] count requested number of payloads
+   /// @param [in] size size of one payload
+   /// @param [in] policy allocation policy
+   /// @return Number of payloads to allocate, not less than count.
+
+int roundPayloadCount(int count, int size, int policy);
+
+   /// Allocate a buffer for packet payloads.
+   /// @param [in] size buffer size in bytes, any; with huge pages it's rounded up to HUGE_PAGE_SIZE
+   /// @param [in] policy allocation policy
+   /// @param [in] node NUMA node to place the buffer on with SRT_BUFALLOC_HUGEPAGES_NUMA (-1: any)
+   /// @return Pointer to the buffer, NULL on failure.
+
+char* allocPayloadBuffer(size_t size, int policy, int node);
+
+   /// Release a buffer returned by allocPayloadBuffer().
+   /// @param [in] buf buffer (may be NULL)
+   /// @param [in] size buffer size, as given when allocating
+   /// @param [in] policy allocation policy, as given when allocating
+
+void freePayloadBuffer(char* buf, size_t size, int policy);
+
+}
+
+#endif
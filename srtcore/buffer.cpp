@@ -54,10 +54,12 @@ modified by
 
 #include <cstring>
 #include <cmath>
+#include <new>
 #include "buffer.h"
 #include "packet.h"
 #include "core.h" // provides some constants
 #include "logging.h"
+#include "bufalloc.h"
 
 using namespace std;
 using namespace srt_logging;
@@ -108,16 +110,20 @@ int round_val(double val)
     return static_cast<int>(round(val));
 }
 
-CSndBuffer::CSndBuffer(int size, int mss)
+CSndBuffer::CSndBuffer(int size, int mss, int alloc, int node)
     : m_BufLock()
-    , m_pBlock(NULL)
-    , m_pFirstBlock(NULL)
-    , m_pCurrBlock(NULL)
-    , m_pLastBlock(NULL)
+    , m_pBlocks(NULL)
+    , m_iFirstPos(0)
+    , m_iCurrPos(0)
+    , m_iLastPos(0)
+    , m_ullBytesAdded(0)
+    , m_ullBytesAcked(0)
     , m_pBuffer(NULL)
     , m_iNextMsgNo(1)
-    , m_iSize(size)
+    , m_iSize(srt::roundPayloadCount(size, mss, alloc))
     , m_iMSS(mss)
+    , m_iBufAlloc(alloc)
+    , m_iNumaNode(node)
     , m_iCount(0)
     , m_iBytesCount(0)
     , m_iInRatePktsCount(0)
@@ -127,58 +133,51 @@ CSndBuffer::CSndBuffer(int size, int mss)
 {
     // initial physical buffer of "size"
     m_pBuffer           = new Buffer;
-    m_pBuffer->m_pcData = new char[m_iSize * m_iMSS];
-    m_pBuffer->m_iSize  = m_iSize;
-    m_pBuffer->m_pNext  = NULL;
-
-    // circular linked list for out bound packets
-    m_pBlock  = new Block;
-    Block* pb = m_pBlock;
-    for (int i = 1; i < m_iSize; ++i)
+    m_pBuffer->m_pcData = srt::allocPayloadBuffer(size_t(m_iSize) * m_iMSS, m_iBufAlloc, m_iNumaNode);
+    if (!m_pBuffer->m_pcData)
     {
-        pb->m_pNext        = new Block;
-        pb->m_iMsgNoBitset = 0;
-        pb                 = pb->m_pNext;
+        delete m_pBuffer;
+        throw std::bad_alloc();
     }
-    pb->m_pNext = m_pBlock;
+    m_pBuffer->m_iSize  = m_iSize;
+    m_pBuffer->m_pNext  = NULL;
 
-    pb       = m_pBlock;
-    char* pc = m_pBuffer->m_pcData;
+    // ring of blocks for out bound packets
+    m_pBlocks = new Block[m_iSize];
+    char* pc  = m_pBuffer->m_pcData;
     for (int i = 0; i < m_iSize; ++i)
     {
-        pb->m_pcData = pc;
-        pb           = pb->m_pNext;
+        m_pBlocks[i].m_pcData       = pc;
+        m_pBlocks[i].m_pcBuffer     = pc;
+        m_pBlocks[i].m_iMsgNoBitset = 0;
+        m_pBlocks[i].m_ullBytesSum  = 0;
         pc += m_iMSS;
     }
 
-    m_pFirstBlock = m_pCurrBlock = m_pLastBlock = m_pBlock;
-
     setupMutex(m_BufLock, "Buf");
 }
 
 CSndBuffer::~CSndBuffer()
 {
-    Block* pb = m_pBlock->m_pNext;
-    while (pb != m_pBlock)
-    {
-        Block* temp = pb;
-        pb          = pb->m_pNext;
-        delete temp;
-    }
-    delete m_pBlock;
+    // The user data blocks still referenced are not needed anymore.
+    for (std::deque<Release>::iterator i = m_Releases.begin(); i != m_Releases.end(); ++i)
+        i->m_Block.call();
+
+    delete[] m_pBlocks;
 
     while (m_pBuffer != NULL)
     {
         Buffer* temp = m_pBuffer;
         m_pBuffer    = m_pBuffer->m_pNext;
-        delete[] temp->m_pcData;
+        srt::freePayloadBuffer(temp->m_pcData, size_t(temp->m_iSize) * m_iMSS, m_iBufAlloc);
         delete temp;
     }
 
     releaseMutex(m_BufLock);
 }
 
-void CSndBuffer::addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl)
+void CSndBuffer::addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl,
+                           srt_send_release_fn* release, void* opaque)
 {
     int32_t&  w_msgno   = w_mctrl.msgno;
     int32_t&  w_seqno   = w_mctrl.pktseq;
@@ -211,7 +210,8 @@ void CSndBuffer::addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl)
     // If there's more than one packet, this function must increase it by itself
     // and then return the accordingly modified sequence number in the reference.
 
-    Block* s = m_pLastBlock;
+    // The blocks after the last one are not accessed by other threads.
+    int pos = m_iLastPos;
 
     if (w_msgno == SRT_MSGNO_NONE) // DEFAULT-UNCHANGED msgno supplied
     {
@@ -230,11 +230,23 @@ void CSndBuffer::addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl)
         if (pktlen > m_iMSS)
             pktlen = m_iMSS;
 
+        Block* s = &m_pBlocks[pos];
+        if (release)
+        {
+            // The packet is sent right from the user data block.
+            s->m_pcData = const_cast<char*>(data + i * m_iMSS);
+        }
+        else
+        {
+            s->m_pcData = s->m_pcBuffer;
+            memcpy((s->m_pcData), data + i * m_iMSS, pktlen);
+        }
         HLOGC(dlog.Debug,
               log << "addBuffer: %" << w_seqno << " #" << w_msgno << " spreading from=" << (i * m_iMSS)
                   << " size=" << pktlen << " TO BUFFER:" << (void*)s->m_pcData);
-        memcpy((s->m_pcData), data + i * m_iMSS, pktlen);
         s->m_iLength = pktlen;
+        m_ullBytesAdded += pktlen;
+        s->m_ullBytesSum = m_ullBytesAdded;
 
         s->m_iSeqNo = w_seqno;
         w_seqno     = CSeqNo::incseq(w_seqno);
@@ -256,16 +268,19 @@ void CSndBuffer::addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl)
         s->m_tsRexmitTime = time_point();
         s->m_iTTL = w_ttl;
 
-        // XXX unchecked condition: s->m_pNext == NULL.
-        // Should never happen, as the call to increase() should ensure enough buffers.
-        SRT_ASSERT(s->m_pNext);
-        s = s->m_pNext;
+        pos = shiftPos(pos, 1);
     }
-    m_pLastBlock = s;
 
     enterCS(m_BufLock);
+    m_iLastPos = pos;
     m_iCount += size;
 
+    if (release)
+    {
+        const Release r = {m_ullBytesAdded, {release, opaque, data, len}};
+        m_Releases.push_back(r);
+    }
+
     m_iBytesCount += len;
     m_tsLastOriginTime = time;
 
@@ -348,13 +363,16 @@ int CSndBuffer::addBufferFromFile(fstream& ifs, int len)
           log << CONID() << "addBufferFromFile: adding " << size << " packets (" << len
               << " bytes) to send, msgno=" << m_iNextMsgNo);
 
-    Block* s     = m_pLastBlock;
-    int    total = 0;
+    int pos   = m_iLastPos;
+    int total = 0;
     for (int i = 0; i < size; ++i)
     {
         if (ifs.bad() || ifs.fail() || ifs.eof())
             break;
 
+        Block* s    = &m_pBlocks[pos];
+        s->m_pcData = s->m_pcBuffer;
+
         int pktlen = len - i * m_iMSS;
         if (pktlen > m_iMSS)
             pktlen = m_iMSS;
@@ -377,13 +395,15 @@ int CSndBuffer::addBufferFromFile(fstream& ifs, int len)
 
         s->m_iLength = pktlen;
         s->m_iTTL    = SRT_MSGTTL_INF;
-        s            = s->m_pNext;
+        m_ullBytesAdded += pktlen;
+        s->m_ullBytesSum = m_ullBytesAdded;
+        pos = shiftPos(pos, 1);
 
         total += pktlen;
     }
-    m_pLastBlock = s;
 
     enterCS(m_BufLock);
+    m_iLastPos = pos;
     m_iCount += size;
     m_iBytesCount += total;
 
@@ -410,15 +430,20 @@ steady_clock::time_point CSndBuffer::getSourceTime(const CSndBuffer::Block& bloc
 
 int CSndBuffer::readData(CPacket& w_packet, steady_clock::time_point& w_srctime, int kflgs)
 {
+    // The ring may be reallocated by increase() in the meantime.
+    ScopedLock bufferguard(m_BufLock);
+
     // No data to read
-    if (m_pCurrBlock == m_pLastBlock)
+    if (m_iCurrPos == m_iLastPos)
         return 0;
 
+    Block* p = &m_pBlocks[m_iCurrPos];
+
     // Make the packet REFLECT the data stored in the buffer.
-    w_packet.m_pcData = m_pCurrBlock->m_pcData;
-    int readlen       = m_pCurrBlock->m_iLength;
+    w_packet.m_pcData = p->m_pcData;
+    int readlen       = p->m_iLength;
     w_packet.setLength(readlen);
-    w_packet.m_iSeqNo = m_pCurrBlock->m_iSeqNo;
+    w_packet.m_iSeqNo = p->m_iSeqNo;
 
     // XXX This is probably done because the encryption should happen
     // just once, and so this sets the encryption flags to both msgno bitset
@@ -451,12 +476,12 @@ int CSndBuffer::readData(CPacket& w_packet, steady_clock::time_point& w_srctime,
     }
     else
     {
-        m_pCurrBlock->m_iMsgNoBitset |= MSGNO_ENCKEYSPEC::wrap(kflgs);
+        p->m_iMsgNoBitset |= MSGNO_ENCKEYSPEC::wrap(kflgs);
     }
 
-    w_packet.m_iMsgNo = m_pCurrBlock->m_iMsgNoBitset;
-    w_srctime         = getSourceTime(*m_pCurrBlock);
-    m_pCurrBlock      = m_pCurrBlock->m_pNext;
+    w_packet.m_iMsgNo = p->m_iMsgNoBitset;
+    w_srctime         = getSourceTime(*p);
+    m_iCurrPos        = shiftPos(m_iCurrPos, 1);
 
     HLOGC(dlog.Debug, log << CONID() << "CSndBuffer: extracting packet size=" << readlen << " to send");
 
@@ -467,16 +492,7 @@ int32_t CSndBuffer::getMsgNoAt(const int offset)
 {
     ScopedLock bufferguard(m_BufLock);
 
-    Block* p = m_pFirstBlock;
-
-    if (p)
-    {
-        HLOGC(dlog.Debug,
-              log << "CSndBuffer::getMsgNoAt: FIRST MSG: size=" << p->m_iLength << " %" << p->m_iSeqNo << " #"
-                  << p->getMsgSeq() << " !" << BufferStamp(p->m_pcData, p->m_iLength));
-    }
-
-    if (offset >= m_iCount)
+    if (offset < 0 || offset >= m_iCount)
     {
         // Prevent accessing the last "marker" block
         LOGC(dlog.Error,
@@ -484,23 +500,7 @@ int32_t CSndBuffer::getMsgNoAt(const int offset)
         return SRT_MSGNO_CONTROL;
     }
 
-    // XXX Suboptimal procedure to keep the blocks identifiable
-    // by sequence number. Consider using some circular buffer.
-    int       i;
-    Block* ee SRT_ATR_UNUSED = 0;
-    for (i = 0; i < offset && p; ++i)
-    {
-        ee = p;
-        p  = p->m_pNext;
-    }
-
-    if (!p)
-    {
-        LOGC(dlog.Error,
-             log << "CSndBuffer::getMsgNoAt: IPE: offset=" << offset << " not found, stopped at " << i << " with #"
-                 << (ee ? ee->getMsgSeq() : SRT_MSGNO_NONE));
-        return SRT_MSGNO_CONTROL;
-    }
+    const Block* p = &m_pBlocks[shiftPos(m_iFirstPos, offset)];
 
     HLOGC(dlog.Debug,
           log << "CSndBuffer::getMsgNoAt: offset=" << offset << " found, size=" << p->m_iLength << " %" << p->m_iSeqNo
@@ -515,17 +515,13 @@ int CSndBuffer::readData(const int offset, CPacket& w_packet, steady_clock::time
 
     ScopedLock bufferguard(m_BufLock);
 
-    Block* p = m_pFirstBlock;
-
-    // XXX Suboptimal procedure to keep the blocks identifiable
-    // by sequence number. Consider using some circular buffer.
-    for (int i = 0; i < offset; ++i)
-        p = p->m_pNext;
+    int    pos = shiftPos(m_iFirstPos, offset);
+    Block* p   = &m_pBlocks[pos];
 
-    // Check if the block that is the next candidate to send (m_pCurrBlock pointing) is stale.
+    // Check if the block that is the next candidate to send (at m_iCurrPos) is stale.
 
     // If so, then inform the caller that it should first take care of the whole
-    // message (all blocks with that message id). Shift the m_pCurrBlock pointer
+    // message (all blocks with that message id). Shift the m_iCurrPos position
     // to the position past the last of them. Then return -1 and set the
     // msgno_bitset return reference to the message id that should be dropped as
     // a whole.
@@ -540,15 +536,15 @@ int CSndBuffer::readData(const int offset, CPacket& w_packet, steady_clock::time
     {
         int32_t msgno = p->getMsgSeq();
         w_msglen      = 1;
-        p             = p->m_pNext;
+        pos           = shiftPos(pos, 1);
         bool move     = false;
-        while (msgno == p->getMsgSeq())
+        while (pos != m_iLastPos && msgno == m_pBlocks[pos].getMsgSeq())
         {
-            if (p == m_pCurrBlock)
+            if (pos == m_iCurrPos)
                 move = true;
-            p = p->m_pNext;
+            pos = shiftPos(pos, 1);
             if (move)
-                m_pCurrBlock = p;
+                m_iCurrPos = pos;
             w_msglen++;
         }
 
@@ -591,38 +587,44 @@ int CSndBuffer::readData(const int offset, CPacket& w_packet, steady_clock::time
 srt::sync::steady_clock::time_point CSndBuffer::getPacketRexmitTime(const int offset)
 {
     ScopedLock bufferguard(m_BufLock);
-    const Block* p = m_pFirstBlock;
+    SRT_ASSERT(offset >= 0 && offset < m_iSize);
 
-    // XXX Suboptimal procedure to keep the blocks identifiable
-    // by sequence number. Consider using some circular buffer.
-    for (int i = 0; i < offset; ++i)
-    {
-        SRT_ASSERT(p);
-        p = p->m_pNext;
-    }
-
-    SRT_ASSERT(p);
-    return p->m_tsRexmitTime;
+    return m_pBlocks[shiftPos(m_iFirstPos, offset)].m_tsRexmitTime;
 }
 
-void CSndBuffer::ackData(int offset)
+void CSndBuffer::ackData(int offset, std::vector<CSndRelease>& w_released)
 {
-    ScopedLock bufferguard(m_BufLock);
+    enterCS(m_BufLock);
 
-    bool move = false;
-    for (int i = 0; i < offset; ++i)
+    if (offset > 0)
     {
-        m_iBytesCount -= m_pFirstBlock->m_iLength;
-        if (m_pFirstBlock == m_pCurrBlock)
-            move = true;
-        m_pFirstBlock = m_pFirstBlock->m_pNext;
+        // The payload bytes of the released blocks are known from
+        // the running sum, without visiting every one of them.
+        const uint64_t bytes_sum = m_pBlocks[shiftPos(m_iFirstPos, offset - 1)].m_ullBytesSum;
+        m_iBytesCount -= int(bytes_sum - m_ullBytesAcked);
+        m_ullBytesAcked = bytes_sum;
+
+        const bool move = posDiff(m_iFirstPos, m_iCurrPos) < offset;
+        m_iFirstPos = shiftPos(m_iFirstPos, offset);
+        if (move)
+            m_iCurrPos = m_iFirstPos;
+
+        takeReleases((w_released));
     }
-    if (move)
-        m_pCurrBlock = m_pFirstBlock;
 
     m_iCount -= offset;
 
     updAvgBufSize(steady_clock::now());
+    leaveCS(m_BufLock);
+}
+
+void CSndBuffer::takeReleases(std::vector<CSndRelease>& w_done)
+{
+    while (!m_Releases.empty() && m_Releases.front().m_ullBytesEnd <= m_ullBytesAcked)
+    {
+        w_done.push_back(m_Releases.front().m_Block);
+        m_Releases.pop_front();
+    }
 }
 
 int CSndBuffer::getCurrBufSize() const
@@ -653,11 +655,17 @@ void CSndBuffer::updAvgBufSize(const steady_clock::time_point& now)
 
     int       bytes       = 0;
     int       timespan_ms = 0;
-    const int pkts        = getCurrBufSize((bytes), (timespan_ms));
+    const int pkts        = getCurrBufSize_((bytes), (timespan_ms));
     m_mavg.update(now, pkts, bytes, timespan_ms);
 }
 
 int CSndBuffer::getCurrBufSize(int& w_bytes, int& w_timespan)
+{
+    ScopedLock bufferguard(m_BufLock);
+    return getCurrBufSize_((w_bytes), (w_timespan));
+}
+
+int CSndBuffer::getCurrBufSize_(int& w_bytes, int& w_timespan)
 {
     w_bytes = m_iBytesCount;
     /*
@@ -665,33 +673,36 @@ int CSndBuffer::getCurrBufSize(int& w_bytes, int& w_timespan)
      * Also, if there is only one pkt in buffer, the time difference will be 0.
      * Therefore, always add 1 ms if not empty.
      */
-    w_timespan = 0 < m_iCount ? count_milliseconds(m_tsLastOriginTime - m_pFirstBlock->m_tsOriginTime) + 1 : 0;
+    w_timespan = 0 < m_iCount ? count_milliseconds(m_tsLastOriginTime - m_pBlocks[m_iFirstPos].m_tsOriginTime) + 1 : 0;
 
     return m_iCount;
 }
 
-int CSndBuffer::dropLateData(int& w_bytes, int32_t& w_first_msgno, const steady_clock::time_point& too_late_time)
+int CSndBuffer::dropLateData(int& w_bytes, int32_t& w_first_msgno, const steady_clock::time_point& too_late_time,
+                             std::vector<CSndRelease>& w_released)
 {
     int     dpkts  = 0;
     int     dbytes = 0;
     bool    move   = false;
     int32_t msgno  = 0;
 
-    ScopedLock bufferguard(m_BufLock);
-    for (int i = 0; i < m_iCount && m_pFirstBlock->m_tsOriginTime < too_late_time; ++i)
+    enterCS(m_BufLock);
+    for (int i = 0; i < m_iCount && m_pBlocks[m_iFirstPos].m_tsOriginTime < too_late_time; ++i)
     {
+        const Block& b = m_pBlocks[m_iFirstPos];
         dpkts++;
-        dbytes += m_pFirstBlock->m_iLength;
-        msgno = m_pFirstBlock->getMsgSeq();
+        dbytes += b.m_iLength;
+        msgno = b.getMsgSeq();
+        m_ullBytesAcked = b.m_ullBytesSum;
 
-        if (m_pFirstBlock == m_pCurrBlock)
+        if (m_iFirstPos == m_iCurrPos)
             move = true;
-        m_pFirstBlock = m_pFirstBlock->m_pNext;
+        m_iFirstPos = shiftPos(m_iFirstPos, 1);
     }
 
     if (move)
     {
-        m_pCurrBlock = m_pFirstBlock;
+        m_iCurrPos = m_iFirstPos;
     }
     m_iCount -= dpkts;
 
@@ -703,7 +714,9 @@ int CSndBuffer::dropLateData(int& w_bytes, int32_t& w_first_msgno, const steady_
     // (even if "should remain") is the first after the last removed one.
     w_first_msgno = ++MsgNo(msgno);
 
+    takeReleases((w_released));
     updAvgBufSize(steady_clock::now());
+    leaveCS(m_BufLock);
 
     return (dpkts);
 }
@@ -717,7 +730,9 @@ void CSndBuffer::increase()
     try
     {
         nbuf           = new Buffer;
-        nbuf->m_pcData = new char[unitsize * m_iMSS];
+        nbuf->m_pcData = srt::allocPayloadBuffer(size_t(unitsize) * m_iMSS, m_iBufAlloc, m_iNumaNode);
+        if (!nbuf->m_pcData)
+            throw std::bad_alloc();
     }
     catch (...)
     {
@@ -727,43 +742,48 @@ void CSndBuffer::increase()
     nbuf->m_iSize = unitsize;
     nbuf->m_pNext = NULL;
 
-    // insert the buffer at the end of the buffer list
-    Buffer* p = m_pBuffer;
-    while (p->m_pNext != NULL)
-        p = p->m_pNext;
-    p->m_pNext = nbuf;
-
-    // new packet blocks
+    // new ring of packet blocks
     Block* nblk = NULL;
     try
     {
-        nblk = new Block;
+        nblk = new Block[m_iSize + unitsize];
     }
     catch (...)
     {
-        delete nblk;
+        srt::freePayloadBuffer(nbuf->m_pcData, size_t(unitsize) * m_iMSS, m_iBufAlloc);
+        delete nbuf;
         throw CUDTException(MJ_SYSTEMRES, MN_MEMORY, 0);
     }
-    Block* pb = nblk;
-    for (int i = 1; i < unitsize; ++i)
-    {
-        pb->m_pNext = new Block;
-        pb          = pb->m_pNext;
-    }
 
-    // insert the new blocks onto the existing one
-    pb->m_pNext           = m_pLastBlock->m_pNext;
-    m_pLastBlock->m_pNext = nblk;
+    // insert the buffer at the end of the buffer list
+    Buffer* p = m_pBuffer;
+    while (p->m_pNext != NULL)
+        p = p->m_pNext;
+    p->m_pNext = nbuf;
+
+    // The new ring begins with the first block in use, the blocks
+    // of the new physical buffer are appended after the old ones.
+    ScopedLock bufferguard(m_BufLock);
+
+    for (int i = 0; i < m_iSize; ++i)
+        nblk[i] = m_pBlocks[shiftPos(m_iFirstPos, i)];
 
-    pb       = nblk;
     char* pc = nbuf->m_pcData;
-    for (int i = 0; i < unitsize; ++i)
+    for (int i = m_iSize; i < m_iSize + unitsize; ++i)
     {
-        pb->m_pcData = pc;
-        pb           = pb->m_pNext;
+        nblk[i].m_pcData       = pc;
+        nblk[i].m_pcBuffer     = pc;
+        nblk[i].m_iMsgNoBitset = 0;
+        nblk[i].m_ullBytesSum  = 0;
         pc += m_iMSS;
     }
 
+    m_iCurrPos  = posDiff(m_iFirstPos, m_iCurrPos);
+    m_iLastPos  = posDiff(m_iFirstPos, m_iLastPos);
+    m_iFirstPos = 0;
+
+    delete[] m_pBlocks;
+    m_pBlocks = nblk;
     m_iSize += unitsize;
 
     HLOGC(dlog.Debug,
@@ -843,6 +863,10 @@ CRcvBuffer::~CRcvBuffer()
         }
     }
 
+    // Loans not returned until now end with the buffer.
+    for (set<CUnit*>::iterator i = m_Loans.begin(); i != m_Loans.end(); ++i)
+        m_pUnitQueue->makeUnitFree(*i);
+
     delete[] m_pUnit;
 
     releaseMutex(m_BytesCountLock);
@@ -1969,6 +1993,7 @@ void CRcvBuffer::printDriftOffset(int tsbPdOffset, int tsbPdDriftAvg)
 #endif /* SRT_DEBUG_TSBPD_DRIFT */
 
 bool CRcvBuffer::addRcvTsbPdDriftSample(uint32_t                  timestamp_us,
+                                        const steady_clock::time_point& arrival,
                                         Mutex&                    mutex_to_lock,
                                         steady_clock::duration&   w_udrift,
                                         steady_clock::time_point& w_newtimebase)
@@ -1994,7 +2019,7 @@ bool CRcvBuffer::addRcvTsbPdDriftSample(uint32_t                  timestamp_us,
     // either schedule time or a time supplied by the application).
 
     const steady_clock::duration iDrift =
-        steady_clock::now() - (getTsbPdTimeBase(timestamp_us) + microseconds_from(timestamp_us));
+        arrival - (getTsbPdTimeBase(timestamp_us) + microseconds_from(timestamp_us));
 
     enterCS(mutex_to_lock);
 
@@ -2043,6 +2068,12 @@ int CRcvBuffer::readMsg(char* data, int len)
 // - data and len shall be close to one another
 // - upto is last because it's a kind of unusual argument that has a default value
 int CRcvBuffer::readMsg(char* data, int len, SRT_MSGCTRL& w_msgctl, int upto)
+{
+    const SRT_IOVEC seg = {data, len};
+    return readMsg(&seg, 1, (w_msgctl), upto);
+}
+
+int CRcvBuffer::readMsg(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_msgctl, int upto)
 {
     int  p = -1, q = -1;
     bool passack;
@@ -2060,7 +2091,48 @@ int CRcvBuffer::readMsg(char* data, int len, SRT_MSGCTRL& w_msgctl, int upto)
     w_msgctl.pktseq = pkt1.getSeqNo();
     w_msgctl.msgno  = pkt1.getMsgSeq();
 
-    return extractData((data), len, p, q, passack);
+    return extractData(iov, iovcnt, p, q, passack);
+}
+
+CUnit* CRcvBuffer::loanMsg(SRT_MSGCTRL& w_msgctl, int upto)
+{
+    if (!m_bTsbPdMode)
+        return NULL;
+
+    int  p = -1, q = -1;
+    bool passack;
+
+    bool empty = accessMsg((p), (q), (passack), (w_msgctl.srctime), upto);
+    if (empty)
+        return NULL;
+
+    // In TSBPD mode p == q and the unit is always removed
+    // from the buffer, as in extractData.
+    CUnit*         u   = m_pUnit[p];
+    const CPacket& pkt = u->m_Packet;
+
+    w_msgctl.pktseq = pkt.getSeqNo();
+    w_msgctl.msgno  = pkt.getMsgSeq();
+
+    if (pkt.getLength() > 0)
+        countBytes(-1, -(int)pkt.getLength(), true);
+
+    IF_HEAVY_LOGGING(readMsgHeavyLogging(p));
+    HLOGC(dlog.Debug, log << CONID() << "loanMsg: LOANING UNIT POS=" << p);
+
+    m_pUnit[p] = NULL;
+    m_iStartPos = shiftFwd(p);
+    m_Loans.insert(u);
+    return u;
+}
+
+bool CRcvBuffer::returnLoan(CUnit* u)
+{
+    if (m_Loans.erase(u) == 0)
+        return false;
+
+    m_pUnitQueue->makeUnitFree(u);
+    return true;
 }
 
 #ifdef SRT_DEBUG_TSBPD_OUTJITTER
@@ -2118,10 +2190,16 @@ bool CRcvBuffer::accessMsg(int& w_p, int& w_q, bool& w_passack, int64_t& w_playt
     return empty;
 }
 
-int CRcvBuffer::extractData(char* data, int len, int p, int q, bool passack)
+int CRcvBuffer::extractData(const SRT_IOVEC* iov, int iovcnt, int p, int q, bool passack)
 {
+    int len = 0;
+    for (int i = 0; i < iovcnt; ++i)
+        len += iov[i].len;
+
     SRT_ASSERT(len > 0);
     int       rs     = len > 0 ? len : 0;
+    int       seg    = 0; // the segment being filled
+    int       segpos = 0; // position in this segment
     const int past_q = shiftFwd(q);
     while (p != past_q)
     {
@@ -2137,8 +2215,21 @@ int CRcvBuffer::extractData(char* data, int len, int p, int q, bool passack)
 
         if (unitsize > 0)
         {
-            memcpy((data), m_pUnit[p]->m_Packet.m_pcData, unitsize);
-            data += unitsize;
+            const char* src  = m_pUnit[p]->m_Packet.m_pcData;
+            int         left = unitsize;
+            while (left > 0)
+            {
+                const int chunk = std::min(left, iov[seg].len - segpos);
+                memcpy(iov[seg].buf + segpos, src, chunk);
+                src += chunk;
+                left -= chunk;
+                segpos += chunk;
+                if (segpos == iov[seg].len)
+                {
+                    ++seg;
+                    segpos = 0;
+                }
+            }
             rs -= unitsize;
             IF_HEAVY_LOGGING(readMsgHeavyLogging(p));
         }
@@ -58,7 +58,9 @@ modified by
 #include "list.h"
 #include "queue.h"
 #include "utilities.h"
+#include <deque>
 #include <fstream>
+#include <set>
 
 // The notation used for "circular numbers" in comments:
 // The "cicrular numbers" are numbers that when increased up to the
@@ -114,7 +116,12 @@ public:
    // Currently just "unimplemented".
    std::string CONID() const { return ""; }
 
-   CSndBuffer(int size = 32, int mss = 1500);
+      /// @param [in] size initial number of packets, rounded up to fill whole huge pages with these
+      /// @param [in] mss maximum packet size
+      /// @param [in] alloc allocation policy for the packet payloads (SRT_BUFALLOC)
+      /// @param [in] node NUMA node for the packet payloads with SRT_BUFALLOC_HUGEPAGES_NUMA
+
+   CSndBuffer(int size = 32, int mss = 1500, int alloc = SRT_BUFALLOC_DEFAULT, int node = -1);
    ~CSndBuffer();
 
 public:
@@ -133,7 +140,11 @@ public:
       /// @param [in] data pointer to the user data block.
       /// @param [in] len size of the block.
       /// @param [inout] r_mctrl Message control data
-   void addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl);
+      /// @param [in] release if not NULL, the user data block is referenced instead of copied
+      ///             and this function is called when its last packet is released
+      /// @param [in] opaque first argument of the release function
+   void addBuffer(const char* data, int len, SRT_MSGCTRL& w_mctrl,
+                  srt_send_release_fn* release = NULL, void* opaque = NULL);
 
       /// Read a block of data from file and insert it into the sending list.
       /// @param [in] ifs input file stream.
@@ -168,19 +179,22 @@ public:
 
    time_point getPacketRexmitTime(const int offset);
 
+   int32_t getMsgNoAt(const int offset);
+
       /// Update the ACK point and may release/unmap/return the user data according to the flag.
       /// @param [in] offset number of packets acknowledged.
+      /// @param [out] w_released user data blocks no longer referenced, to be given back
+      ///              when no packet being sent points to them (see CSndQueue::release).
 
-   int32_t getMsgNoAt(const int offset);
-
-   void ackData(int offset);
+   void ackData(int offset, std::vector<CSndRelease>& w_released);
 
       /// Read size of data still in the sending list.
       /// @return Current size of the data in the sending list.
 
    int getCurrBufSize() const;
 
-   int dropLateData(int& bytes, int32_t& w_first_msgno, const time_point& too_late_time);
+   int dropLateData(int& bytes, int32_t& w_first_msgno, const time_point& too_late_time,
+                    std::vector<CSndRelease>& w_released);
 
    void updAvgBufSize(const time_point& time);
    int getAvgBufSize(int& bytes, int& timespan);
@@ -208,6 +222,17 @@ public:
 private:
    void increase();
    void setInputRateSmpPeriod(int period);
+   int getCurrBufSize_(int& bytes, int& timespan);
+
+   void takeReleases(std::vector<CSndRelease>& w_done);
+
+      /// Position of the block some blocks (less than m_iSize) after the given one.
+
+   int shiftPos(int pos, int n) const { pos += n; return pos >= m_iSize ? pos - m_iSize : pos; }
+
+      /// Number of blocks from one position up to another.
+
+   int posDiff(int from, int to) const { return to >= from ? to - from : to - from + m_iSize; }
 
    struct Block; // Defined below
    static time_point getSourceTime(const CSndBuffer::Block& block);
@@ -225,6 +250,7 @@ private:
    struct Block
    {
       char* m_pcData;                   // pointer to the data block
+      char* m_pcBuffer;                 // the block's own space in the physical buffer
       int m_iLength;                    // length of the block
 
       int32_t m_iMsgNoBitset;           // message number
@@ -233,10 +259,9 @@ private:
       time_point m_tsRexmitTime;        // packet retransmission time
       uint64_t m_llSourceTime_us;
       int m_iTTL;                       // time to live (milliseconds)
+      uint64_t m_ullBytesSum;           // payload bytes added to the buffer up to and including this block
 
-      Block* m_pNext;                   // next block
-
-      int32_t getMsgSeq()
+      int32_t getMsgSeq() const
       {
           // NOTE: this extracts message ID with regard to REXMIT flag.
           // This is valid only for message ID that IS GENERATED in this instance,
@@ -245,12 +270,23 @@ private:
           return m_iMsgNoBitset & MSGNO_SEQ::mask;
       }
 
-   } *m_pBlock, *m_pFirstBlock, *m_pCurrBlock, *m_pLastBlock;
+   } *m_pBlocks;                        // ring of m_iSize blocks
 
-   // m_pBlock:         The head pointer
-   // m_pFirstBlock:    The first block
-   // m_pCurrBlock:	The current block
-   // m_pLastBlock:     The last block (if first == last, buffer is empty)
+   // The blocks in use are found by their offset from the first one,
+   // so that a packet to retransmit doesn't have to be searched for.
+   // There's always at least one block not in use.
+   int m_iFirstPos;                     // the first block, the oldest one not acknowledged
+   int m_iCurrPos;                      // the next block to send
+   int m_iLastPos;                      // the block after the last one in use (if first == last, buffer is empty)
+   uint64_t m_ullBytesAdded;            // payload bytes ever added to the buffer
+   uint64_t m_ullBytesAcked;            // payload bytes ever released from the buffer
+
+   struct Release
+   {
+      uint64_t m_ullBytesEnd;           // m_ullBytesSum of the last block of the message
+      CSndRelease m_Block;              // the user data block and its release function
+   };
+   std::deque<Release> m_Releases;      // the referenced user data blocks, in the order of adding
 
    struct Buffer
    {
@@ -263,6 +299,8 @@ private:
 
    int m_iSize;                         // buffer size (number of packets)
    int m_iMSS;                          // maximum seqment/packet size
+   int m_iBufAlloc;                     // allocation policy for the physical buffer (SRT_BUFALLOC)
+   int m_iNumaNode;                     // NUMA node for the physical buffer, -1 if none
 
    int m_iCount;                        // number of used blocks
 
@@ -400,6 +438,35 @@ public:
       /// @return actuall size of data read.
 
    int readMsg(char* data, int len, SRT_MSGCTRL& w_mctrl, int upto);
+
+      /// read a message scattered over several segments.
+      /// @param [in] iov segments to write the message into, in order.
+      /// @param [in] iovcnt number of segments.
+      /// @param [out] w_mctrl message control data of the message read.
+      /// @param [in] upto as in readMsg.
+      /// @return actual size of data read.
+
+   int readMsg(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl, int upto);
+
+      /// Take the next ready message out of the buffer without copying it.
+      /// The unit holding it is not given back to the unit queue until
+      /// returnLoan() is called for it. Works only in TSBPD mode, where a
+      /// message always fits in one unit.
+      /// @param [out] w_mctrl message control data of the message loaned.
+      /// @param [in] upto as in readMsg.
+      /// @return the unit with the message or NULL if none is ready.
+
+   CUnit* loanMsg(SRT_MSGCTRL& w_mctrl, int upto);
+
+      /// Give back a unit loaned by loanMsg() to the unit queue.
+      /// @param [in] u the loaned unit.
+      /// @return false if the unit is not loaned from this buffer.
+
+   bool returnLoan(CUnit* u);
+
+      /// @return number of units currently loaned.
+
+   int getLoanCount() const { return (int) m_Loans.size(); }
       /// Query if data is ready to read (tsbpdtime <= now if TsbPD is active).
       /// @param [out] tsbpdtime localtime-based (uSec) packet time stamp including buffering delay
       ///                        of next packet in recv buffer, ready or not.
@@ -431,9 +498,10 @@ public:
 
       /// Add packet timestamp for drift caclculation and compensation
       /// @param [in] timestamp packet time stamp
+      /// @param [in] arrival time when the packet was received
       /// @param [ref] lock Mutex that should be locked for the operation
 
-   bool addRcvTsbPdDriftSample(uint32_t timestamp, srt::sync::Mutex& mutex_to_lock,
+   bool addRcvTsbPdDriftSample(uint32_t timestamp, const time_point& arrival, srt::sync::Mutex& mutex_to_lock,
            duration& w_udrift, time_point& w_newtimebase);
 
 #ifdef SRT_DEBUG_TSBPD_DRIFT
@@ -532,7 +600,7 @@ public:
    }
 
 private:
-   int extractData(char *data, int len, int p, int q, bool passack);
+   int extractData(const SRT_IOVEC* iov, int iovcnt, int p, int q, bool passack);
    bool accessMsg(int& w_p, int& w_q, bool& w_passack, int64_t& w_playtime, int upto);
 
    /// Describes the state of the first N packets
@@ -572,6 +640,7 @@ private:
    CUnit** m_pUnit;                     // Array of pointed units collected in the buffer
    const int m_iSize;                   // Size of the internal array of CUnit* items
    CUnitQueue* m_pUnitQueue;            // the shared unit queue
+   std::set<CUnit*> m_Loans;            // units taken out by loanMsg() and not yet returned
 
    int m_iStartPos;                     // HEAD: first packet available for reading
    int m_iLastAckPos;                   // the last ACKed position (exclusive), follows the last readable
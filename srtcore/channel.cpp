@@ -66,6 +66,106 @@ modified by
 
 #ifdef _WIN32
     typedef int socklen_t;
+#else
+#include <poll.h>
+#endif
+
+#if defined(__linux__)
+#include <netinet/udp.h> // UDP_SEGMENT, UDP_GRO
+#include <linux/filter.h> // sock_filter, sock_fprog
+#endif
+
+// UDP segmentation offload is only used together with sendmmsg().
+#if defined(HAVE_SENDMMSG) && defined(UDP_SEGMENT) && !defined(SRT_TEST_FAKE_LOSS)
+#define SRT_ENABLE_GSO 1
+#endif
+
+#if defined(UDP_GRO)
+#define SRT_ENABLE_GRO 1
+#endif
+
+// The departure times are only given to the packets sent with sendmmsg().
+#if defined(__linux__) && defined(HAVE_SENDMMSG) && defined(SO_TXTIME) && !defined(SRT_TEST_FAKE_LOSS)
+#include <linux/net_tstamp.h> // sock_txtime
+#define SRT_ENABLE_TXTIME 1
+#endif
+
+#if defined(__linux__) && defined(SO_TIMESTAMPNS)
+#define SRT_ENABLE_RCVTSTAMP 1
+#endif
+
+#ifdef SRT_ENABLE_RCVTSTAMP
+// Space for the control message with the time when the system received
+// a packet.
+#define RCVTSTAMP_CONTROL_SIZE CMSG_SPACE(sizeof(timespec))
+
+// Converts the times when the system received the packets (SO_TIMESTAMPNS,
+// in CLOCK_REALTIME) to steady_clock. Both clocks are read once, when the
+// packets have been received.
+class CArrivalClock
+{
+public:
+    CArrivalClock()
+    {
+        ::clock_gettime(CLOCK_REALTIME, &m_RealNow);
+        m_SteadyNow = srt::sync::steady_clock::now();
+    }
+
+    // Returns the time when the packet of the given message was received,
+    // or zero time if the message doesn't carry it.
+    srt::sync::steady_clock::time_point arrival(msghdr& mh) const
+    {
+        for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm != NULL; cm = CMSG_NXTHDR(&mh, cm))
+        {
+            if (cm->cmsg_level != SOL_SOCKET || cm->cmsg_type != SCM_TIMESTAMPNS)
+                continue;
+
+            timespec ts;
+            memcpy(&ts, CMSG_DATA(cm), sizeof ts);
+            const int64_t age_ns = (int64_t(m_RealNow.tv_sec) - ts.tv_sec) * 1000000000
+                + (m_RealNow.tv_nsec - ts.tv_nsec);
+
+            // The system clock may have been set in the meantime.
+            if (age_ns < 0 || age_ns > MAX_AGE_NS)
+                return m_SteadyNow;
+
+            return m_SteadyNow - srt::sync::microseconds_from(age_ns / 1000);
+        }
+
+        return srt::sync::steady_clock::time_point();
+    }
+
+private:
+    static const int64_t MAX_AGE_NS = 1000000000;
+
+    timespec m_RealNow;
+    srt::sync::steady_clock::time_point m_SteadyNow;
+};
+#endif
+
+#ifdef SRT_ENABLE_IOURING
+#include "uring.h"
+
+// A receive posted to the ring. The message header refers to the buffers
+// of the packet and to the address here, so it stays in place until the
+// receive completes.
+struct CChannel::PostedRecv
+{
+    msghdr mh;
+    sockaddr_any addr;
+    CPacket* packet;   // NULL if no receive is in progress in this slot
+#ifdef SRT_ENABLE_RCVTSTAMP
+    union
+    {
+        cmsghdr hdr;
+        char buf[RCVTSTAMP_CONTROL_SIZE];
+    } control;
+#endif
+};
+
+// Marks the completions of cancellation requests, as opposed to the
+// completions of receives, which carry the slot number.
+static const uint64_t CANCEL_DATA = uint64_t(-1);
 #endif
 
 using namespace std;
@@ -77,12 +177,32 @@ m_iIpTTL(-1),   /* IPv4 TTL or IPv6 HOPs [1..255] (-1:undefined) */
 m_iIpToS(-1),   /* IPv4 Type of Service or IPv6 Traffic Class [0x00..0xff] (-1:undefined) */
 m_iSndBufSize(65536),
 m_iRcvBufSize(65536),
-m_iIpV6Only(-1)
+m_iIpV6Only(-1),
+m_bGSO(false),
+m_bGRO(false),
+m_pGROBuffer(NULL),
+m_bReusePort(false),
+m_bTxTime(false),
+m_bTimestamp(false),
+m_bIOUring(false),
+m_pRecvRing(NULL),
+m_pPostedRecv(NULL),
+m_bWakeup(false),
+m_bWaiting(false),
+m_iRecvTimeoutUs(DEF_RECV_TIMEOUT_US)
 {
+   m_aWakeupPipe[0] = m_aWakeupPipe[1] = -1;
 }
 
 CChannel::~CChannel()
 {
+   delete [] m_pGROBuffer;
+#ifdef SRT_ENABLE_IOURING
+   delete m_pRecvRing;
+   delete [] m_pPostedRecv;
+   for (size_t i = 0; i < m_vSendRings.size(); ++ i)
+      delete m_vSendRings[i];
+#endif
 }
 
 void CChannel::createSocket(int family)
@@ -111,6 +231,19 @@ void CChannel::createSocket(int family)
         }
     }
 
+    if (m_bReusePort)
+    {
+#ifdef SO_REUSEPORT
+        const int yes = 1;
+        if (-1 == ::setsockopt(m_iSocket, SOL_SOCKET, SO_REUSEPORT, (const char*)&yes, sizeof yes))
+        {
+            LOGC(mglog.Warn, log << "CHANNEL: SO_REUSEPORT not supported by the system, port sharing turned off");
+            m_bReusePort = false;
+        }
+#else
+        m_bReusePort = false;
+#endif
+    }
 }
 
 void CChannel::open(const sockaddr_any& addr)
@@ -258,6 +391,113 @@ void CChannel::setUDPSockOpt()
       }
 
 
+#ifdef SRT_ENABLE_GSO
+   if (m_bGSO)
+   {
+       // The segment size is given with every datagram, so just check
+       // if the kernel knows this option at all.
+       int segsize = 0;
+       socklen_t len = sizeof segsize;
+       if (-1 == ::getsockopt(m_iSocket, SOL_UDP, UDP_SEGMENT, (char*)&segsize, &len))
+       {
+           LOGC(mglog.Warn, log << "CHANNEL: UDP_SEGMENT not supported by the system, segmentation offload turned off");
+           m_bGSO = false;
+       }
+   }
+#else
+   m_bGSO = false;
+#endif
+
+#ifdef SRT_ENABLE_GRO
+   if (m_bGRO)
+   {
+       const int yes = 1;
+       if (-1 == ::setsockopt(m_iSocket, SOL_UDP, UDP_GRO, (const char*)&yes, sizeof yes))
+       {
+           LOGC(mglog.Warn, log << "CHANNEL: UDP_GRO not supported by the system, receive offload turned off");
+           m_bGRO = false;
+       }
+       else if (!m_pGROBuffer)
+       {
+           m_pGROBuffer = new char[MAX_GRO_SIZE];
+       }
+   }
+#else
+   m_bGRO = false;
+#endif
+
+#ifdef SRT_ENABLE_TXTIME
+   if (m_bTxTime)
+   {
+       // The departure times are given in CLOCK_MONOTONIC, which is
+       // the clock of the fq qdisc.
+       sock_txtime cfg;
+       cfg.clockid = CLOCK_MONOTONIC;
+       cfg.flags = 0;
+       if (-1 == ::setsockopt(m_iSocket, SOL_SOCKET, SO_TXTIME, (const char*)&cfg, sizeof cfg))
+       {
+           LOGC(mglog.Warn, log << "CHANNEL: SO_TXTIME not supported by the system, kernel pacing turned off");
+           m_bTxTime = false;
+       }
+   }
+#else
+   m_bTxTime = false;
+#endif
+
+#ifdef SRT_ENABLE_RCVTSTAMP
+   if (m_bTimestamp)
+   {
+       const int yes = 1;
+       if (-1 == ::setsockopt(m_iSocket, SOL_SOCKET, SO_TIMESTAMPNS, (const char*)&yes, sizeof yes))
+       {
+           LOGC(mglog.Warn, log << "CHANNEL: SO_TIMESTAMPNS not supported by the system, arrival time from the system turned off");
+           m_bTimestamp = false;
+       }
+   }
+#else
+   m_bTimestamp = false;
+#endif
+
+#ifndef _WIN32
+   if (m_bWakeup && m_aWakeupPipe[0] == -1)
+   {
+       if (-1 == ::pipe(m_aWakeupPipe))
+           throw CUDTException(MJ_SETUP, MN_NORES, NET_ERROR);
+
+       for (int i = 0; i < 2; ++ i)
+       {
+           const int opts = ::fcntl(m_aWakeupPipe[i], F_GETFL);
+           ::fcntl(m_aWakeupPipe[i], F_SETFL, opts | O_NONBLOCK);
+       }
+   }
+#endif
+
+#ifdef SRT_ENABLE_IOURING
+   // The coalesced datagrams of the receive offload are read with recvmsg(),
+   // so then only the sending goes through the rings. A wait in the ring
+   // can't be woken up, so then neither are the receives.
+   if (m_bIOUring && !m_bGRO && !m_bWakeup && !m_pRecvRing)
+   {
+       // Room for a receive and its cancellation in every slot.
+       m_pRecvRing = new CIOUring;
+       if (!m_pRecvRing->open(2 * MAX_RECV_BATCH, m_iSocket))
+       {
+           LOGC(mglog.Warn, log << "CHANNEL: io_uring not supported by the system, turned off");
+           delete m_pRecvRing;
+           m_pRecvRing = NULL;
+           m_bIOUring = false;
+       }
+       else
+       {
+           m_pPostedRecv = new PostedRecv[MAX_RECV_BATCH];
+           for (int i = 0; i < MAX_RECV_BATCH; ++ i)
+               m_pPostedRecv[i].packet = NULL;
+       }
+   }
+#else
+   m_bIOUring = false;
+#endif
+
 #ifdef UNIX
    // Set non-blocking I/O
    // UNIX does not support SO_RCVTIMEO
@@ -284,10 +524,24 @@ void CChannel::setUDPSockOpt()
 #endif
 }
 
-void CChannel::close() const
+void CChannel::close()
 {
+#ifdef SRT_ENABLE_IOURING
+   // The socket is registered with the rings, which keep it open.
+   if (m_pRecvRing)
+      m_pRecvRing->close();
+   for (size_t i = 0; i < m_vSendRings.size(); ++ i)
+      m_vSendRings[i]->close();
+#endif
+
    #ifndef _WIN32
       ::close(m_iSocket);
+      for (int i = 0; i < 2; ++ i)
+      {
+         if (m_aWakeupPipe[i] != -1)
+            ::close(m_aWakeupPipe[i]);
+         m_aWakeupPipe[i] = -1;
+      }
    #else
       ::closesocket(m_iSocket);
    #endif
@@ -364,6 +618,88 @@ int CChannel::getIpToS() const
    return m_iIpToS;
 }
 
+void CChannel::setGSO(bool enable)
+{
+   m_bGSO = enable;
+}
+
+void CChannel::setGRO(bool enable)
+{
+   m_bGRO = enable;
+}
+
+void CChannel::setTxTime(bool enable)
+{
+   m_bTxTime = enable;
+}
+
+void CChannel::setTimestamp(bool enable)
+{
+   m_bTimestamp = enable;
+}
+
+void CChannel::setIOUring(bool enable)
+{
+   m_bIOUring = enable;
+}
+
+void CChannel::setWakeup(bool enable)
+{
+   m_bWakeup = enable;
+}
+
+void CChannel::wakeup() const
+{
+#ifndef _WIN32
+   // The pipe being full already means a pending wakeup.
+   if (m_bWaiting && m_aWakeupPipe[1] != -1)
+   {
+      const char c = 0;
+      if (::write(m_aWakeupPipe[1], &c, 1) == -1)
+      {
+         HLOGC(mglog.Debug, log << CONID() << "(sys)write to wakeup pipe: " << SysStrError(errno));
+      }
+   }
+#endif
+}
+
+void CChannel::setReusePort(bool enable)
+{
+   m_bReusePort = enable;
+}
+
+bool CChannel::setReusePortSteering(int members)
+{
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+   // The program gets the UDP payload, that is, the SRT header. A packet
+   // addressed to a socket goes to the member (socket ID % members). For
+   // connection requests, with the socket ID 0, it returns an out of range
+   // index, which makes the system fall back to its own hash.
+   sock_filter code[] = {
+      { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, SRT_PH_ID * sizeof (uint32_t) },
+      { BPF_JMP | BPF_JEQ | BPF_K,   0, 1, 0 },
+      { BPF_RET | BPF_K,             0, 0, 0xFFFFFFFF },
+      { BPF_ALU | BPF_MOD | BPF_K,   0, 0, uint32_t(members) },
+      { BPF_RET | BPF_A,             0, 0, 0 }
+   };
+
+   sock_fprog prog;
+   prog.len = sizeof code / sizeof code[0];
+   prog.filter = code;
+
+   if (-1 == ::setsockopt(m_iSocket, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (const char*)&prog, sizeof prog))
+   {
+      LOGC(mglog.Warn, log << "CHANNEL: SO_ATTACH_REUSEPORT_CBPF failed: " << SysStrError(NET_ERROR)
+            << " - steering by socket ID turned off");
+      return false;
+   }
+   return true;
+#else
+   (void)members;
+   return false;
+#endif
+}
+
 void CChannel::setIpTTL(int ttl)
 {
    m_iIpTTL = ttl;
@@ -511,22 +847,238 @@ int CChannel::sendto(const sockaddr_any& addr, CPacket& packet) const
    return res;
 }
 
+#ifdef SRT_ENABLE_GSO
+// Returns the number of packets, starting from the first one, that can be
+// sent as one segmented datagram: all of them go to the same address, have
+// the same size and the same departure time. The datagram must not exceed
+// the maximum UDP size.
+static int segmentSpan(const sockaddr_any* addr, const CPacket* packets, const uint64_t* txtime, int size)
+{
+    const size_t segsize = CPacket::HDR_SIZE + packets[0].getLength();
+    const int maxseg = std::min(size, int(CChannel::MAX_GSO_SIZE / segsize));
+
+    int n = 1;
+    while (n < maxseg && packets[n].getLength() == packets[0].getLength() && addr[n] == addr[0]
+            && txtime[n] == txtime[0])
+        ++ n;
+
+    return n;
+}
+#endif
+
+#ifdef SRT_ENABLE_TXTIME
+// Converts the departure times to CLOCK_MONOTONIC nanoseconds for SCM_TXTIME
+// (steady_clock may be based on another clock). The packets that are due
+// already get 0 and are sent without a departure time.
+static void departureTimes(const srt::sync::steady_clock::time_point* departure, int size, uint64_t* w_txtime)
+{
+    using namespace srt::sync;
+
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    const steady_clock::time_point now = steady_clock::now();
+    const uint64_t mono_now = uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+
+    for (int i = 0; i < size; ++ i)
+    {
+        w_txtime[i] = departure[i] > now
+            ? mono_now + uint64_t(count_microseconds(departure[i] - now)) * 1000
+            : 0;
+    }
+}
+#endif
+
+int CChannel::sendmmsg(const sockaddr_any* addr, CPacket* packets,
+        const srt::sync::steady_clock::time_point* departure SRT_ATR_UNUSED, int size, int& w_segmented, int& w_timed)
+{
+    w_segmented = 0;
+    w_timed = 0;
+
+#if defined(HAVE_SENDMMSG) && !defined(SRT_TEST_FAKE_LOSS)
+    for (int i = 0; i < size; ++ i)
+    {
+        HLOGC(mglog.Debug, log << "CChannel::sendmmsg: SENDING NOW DST=" << SockaddrToString(addr[i])
+            << " target=@" << packets[i].m_iID
+            << " size=" << packets[i].getLength()
+            << " pkt.ts=" << packets[i].m_iTimeStamp
+            << " " << packets[i].Info());
+
+        // convert control information into network order
+        packets[i].toNL();
+    }
+
+    int ncalls = 0;
+    int begin = 0;
+    while (begin < size)
+    {
+        const int count = std::min(size - begin, int(MAX_SEND_BATCH));
+        mmsghdr mh[MAX_SEND_BATCH];
+        int first[MAX_SEND_BATCH + 1]; // index of the first packet (from 'begin') of every message
+        uint64_t txtime[MAX_SEND_BATCH]; // departure time of every packet (0: now)
+#ifdef SRT_ENABLE_GSO
+        iovec iov[2 * MAX_SEND_BATCH];
+#endif
+#if defined(SRT_ENABLE_GSO) || defined(SRT_ENABLE_TXTIME)
+        union
+        {
+            cmsghdr hdr;
+            char buf[CMSG_SPACE(sizeof(uint16_t)) + CMSG_SPACE(sizeof(uint64_t))];
+        } control[MAX_SEND_BATCH];
+#endif
+
+#ifdef SRT_ENABLE_TXTIME
+        if (m_bTxTime && departure)
+            departureTimes(departure + begin, count, (txtime));
+        else
+#endif
+            memset(txtime, 0, sizeof txtime);
+
+        int nmsg = 0;
+        for (int i = 0; i < count; ++ nmsg)
+        {
+            CPacket* pkts = packets + begin + i;
+            int n = 1;
+
+            msghdr& h = mh[nmsg].msg_hdr;
+            h.msg_name = (sockaddr*)&addr[begin + i];
+            h.msg_namelen = addr[begin + i].size();
+            h.msg_iov = (iovec*)pkts[0].m_PacketVector;
+            h.msg_iovlen = 2;
+            h.msg_control = NULL;
+            h.msg_controllen = 0;
+            h.msg_flags = 0;
+            mh[nmsg].msg_len = 0;
+
+#if defined(SRT_ENABLE_GSO) || defined(SRT_ENABLE_TXTIME)
+            h.msg_control = control[nmsg].buf;
+            h.msg_controllen = sizeof control[nmsg].buf;
+            cmsghdr* cm = CMSG_FIRSTHDR(&h);
+            size_t controllen = 0;
+#endif
+
+#ifdef SRT_ENABLE_GSO
+            if (m_bGSO)
+                n = segmentSpan(addr + begin + i, pkts, txtime + i, count - i);
+
+            if (n > 1)
+            {
+                // The kernel splits the whole buffer into segments of the
+                // given size, so the header and payload of every packet
+                // simply follow one another.
+                for (int k = 0; k < n; ++ k)
+                {
+                    iov[2 * (i + k)]     = pkts[k].m_PacketVector[CPacket::PV_HEADER];
+                    iov[2 * (i + k) + 1] = pkts[k].m_PacketVector[CPacket::PV_DATA];
+                }
+                h.msg_iov = iov + 2 * i;
+                h.msg_iovlen = 2 * n;
+
+                cm->cmsg_level = SOL_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                const uint16_t segsize = uint16_t(CPacket::HDR_SIZE + pkts[0].getLength());
+                memcpy(CMSG_DATA(cm), &segsize, sizeof segsize);
+                controllen += CMSG_SPACE(sizeof(uint16_t));
+                cm = CMSG_NXTHDR(&h, cm);
+            }
+#endif
+
+#ifdef SRT_ENABLE_TXTIME
+            if (txtime[i] != 0)
+            {
+                cm->cmsg_level = SOL_SOCKET;
+                cm->cmsg_type = SCM_TXTIME;
+                cm->cmsg_len = CMSG_LEN(sizeof(uint64_t));
+                memcpy(CMSG_DATA(cm), &txtime[i], sizeof txtime[i]);
+                controllen += CMSG_SPACE(sizeof(uint64_t));
+            }
+#endif
+
+#if defined(SRT_ENABLE_GSO) || defined(SRT_ENABLE_TXTIME)
+            h.msg_controllen = controllen;
+            if (controllen == 0)
+                h.msg_control = NULL;
+#endif
+
+            first[nmsg] = i;
+            i += n;
+        }
+        first[nmsg] = count;
+
+        int sent = 0;
+        while (sent < nmsg)
+        {
+            ++ ncalls;
+            const int res = ::sendmmsg(m_iSocket, mh + sent, nmsg - sent, 0);
+            if (res > 0)
+            {
+                for (int m = sent; m < sent + res; ++ m)
+                {
+                    const int n = first[m + 1] - first[m];
+                    if (n > 1)
+                        w_segmented += n;
+                    if (txtime[first[m]] != 0)
+                        w_timed += n;
+                }
+                sent += res;
+                continue;
+            }
+
+            const int err = NET_ERROR;
+            if (err == EINTR)
+                continue;
+
+#ifdef SRT_ENABLE_GSO
+            if (first[sent + 1] - first[sent] > 1
+                    && (err == EIO || err == EINVAL || err == EOPNOTSUPP || err == ENOPROTOOPT))
+            {
+                // The kernel or the network device can't do the segmentation
+                // (EIO is reported when checksum offload isn't available).
+                // Turn it off and send the rest of the packets separately.
+                LOGC(mglog.Warn, log << CONID() << "(sys)sendmmsg: UDP_SEGMENT rejected: " << SysStrError(err)
+                    << " - segmentation offload turned off");
+                m_bGSO = false;
+                break;
+            }
+#endif
+
+            // The first message in the remaining range has failed. Same as with
+            // sendto(), the failure of a single packet is not reported to the
+            // caller (the packet will be treated as lost), so skip it and
+            // continue with the rest.
+            HLOGC(mglog.Debug, log << CONID() << "(sys)sendmmsg: " << SysStrError(err) << " [" << err << "]");
+            ++ sent;
+        }
+
+        begin += first[sent];
+    }
+
+    for (int i = 0; i < size; ++ i)
+        packets[i].toHL();
+
+    return ncalls;
+#else
+    for (int i = 0; i < size; ++ i)
+        sendto(addr[i], packets[i]);
+
+    return size;
+#endif
+}
+
 EReadStatus CChannel::recvfrom(sockaddr_any& w_addr, CPacket& w_packet) const
 {
     EReadStatus status = RST_OK;
     int msg_flags = 0;
     int recv_size = -1;
 
+    w_packet.m_tsArrival = srt::sync::steady_clock::time_point();
+
 #if defined(UNIX) || defined(_WIN32)
-    fd_set set;
-    timeval tv;
-    FD_ZERO(&set);
-    FD_SET(m_iSocket, &set);
-    tv.tv_sec  = 0;
-    tv.tv_usec = 10000;
-    const int select_ret = ::select((int) m_iSocket + 1, &set, NULL, &set, &tv);
+    const int select_ret = waitReadable();
 #else
-    const int select_ret = 1;   // the socket is expected to be in the blocking mode itself
+    // The socket is expected to be in the blocking mode itself, unless
+    // the wait has to be woken up or to take other time than by default.
+    const int select_ret = (m_bWakeup || m_iRecvTimeoutUs != DEF_RECV_TIMEOUT_US) ? waitReadable() : 1;
 #endif
 
     if (select_ret == 0)   // timeout
@@ -547,8 +1099,26 @@ EReadStatus CChannel::recvfrom(sockaddr_any& w_addr, CPacket& w_packet) const
         mh.msg_controllen = 0;
         mh.msg_flags = 0;
 
+#ifdef SRT_ENABLE_RCVTSTAMP
+        union
+        {
+            cmsghdr hdr;
+            char buf[RCVTSTAMP_CONTROL_SIZE];
+        } control;
+        if (m_bTimestamp)
+        {
+            mh.msg_control = control.buf;
+            mh.msg_controllen = sizeof control.buf;
+        }
+#endif
+
         recv_size = ::recvmsg(m_iSocket, (&mh), 0);
         msg_flags = mh.msg_flags;
+
+#ifdef SRT_ENABLE_RCVTSTAMP
+        if (recv_size != -1 && m_bTimestamp)
+            w_packet.m_tsArrival = CArrivalClock().arrival(mh);
+#endif
     }
 
     // Note that there are exactly four groups of possible errors
@@ -658,13 +1228,508 @@ EReadStatus CChannel::recvfrom(sockaddr_any& w_addr, CPacket& w_packet) const
         msg_flags = 1;
 #endif
 
+    return checkReceived((w_packet), recv_size, msg_flags);
 
+Return_error:
+    w_packet.setLength(-1);
+    return status;
+}
+
+EReadStatus CChannel::recvmmsg(sockaddr_any* w_addr, CPacket* const* w_packets, EReadStatus* w_status, int size,
+        int& w_count) const
+{
+    w_count = 0;
+
+#ifdef SRT_ENABLE_GRO
+    if (m_bGRO)
+        return recvCoalesced(w_addr, w_packets, w_status, size, (w_count));
+#endif
+
+#if defined(HAVE_RECVMMSG)
+    size = std::min(size, int(MAX_RECV_BATCH));
+
+    mmsghdr mh[MAX_RECV_BATCH];
+#ifdef SRT_ENABLE_RCVTSTAMP
+    union
+    {
+        cmsghdr hdr;
+        char buf[RCVTSTAMP_CONTROL_SIZE];
+    } control[MAX_RECV_BATCH];
+#endif
+    for (int i = 0; i < size; ++ i)
+    {
+        msghdr& h = mh[i].msg_hdr;
+        h.msg_name = w_addr[i].get();
+        h.msg_namelen = w_addr[i].size();
+        h.msg_iov = w_packets[i]->m_PacketVector;
+        h.msg_iovlen = 2;
+        h.msg_control = NULL;
+        h.msg_controllen = 0;
+        h.msg_flags = 0;
+        mh[i].msg_len = 0;
+#ifdef SRT_ENABLE_RCVTSTAMP
+        if (m_bTimestamp)
+        {
+            h.msg_control = control[i].buf;
+            h.msg_controllen = sizeof control[i].buf;
+        }
+#endif
+    }
+
+    // Take all packets that are already waiting, but don't wait for more.
+    // Only if there are none, wait for the first one the same way as
+    // recvfrom() does. Under load this saves the poll() call.
+    int recv_count = ::recvmmsg(m_iSocket, mh, size, MSG_DONTWAIT, NULL);
+    int select_ret = 1;
+    if (recv_count == -1 && (NET_ERROR == EAGAIN || NET_ERROR == EWOULDBLOCK))
+    {
+        select_ret = waitReadable();
+
+        if (select_ret == 0)   // timeout
+            return RST_AGAIN;
+
+        if (select_ret > 0)
+            recv_count = ::recvmmsg(m_iSocket, mh, size, MSG_DONTWAIT, NULL);
+    }
+
+    // Errors are classified the same way as in recvfrom().
+    if (select_ret == -1 || recv_count == -1)
+    {
+        const int err = NET_ERROR;
+        if (err == EAGAIN || err == EINTR || err == ECONNREFUSED)
+            return RST_AGAIN;
+
+        HLOGC(mglog.Debug, log << CONID() << "(sys)recvmmsg: " << SysStrError(err) << " [" << err << "]");
+        return RST_ERROR;
+    }
+
+    if (recv_count == 0)
+        return RST_AGAIN;
+
+#ifdef SRT_ENABLE_RCVTSTAMP
+    const CArrivalClock clock;
+#endif
+    for (int i = 0; i < recv_count; ++ i)
+    {
+        w_status[i] = checkReceived((*w_packets[i]), mh[i].msg_len, mh[i].msg_hdr.msg_flags);
+#ifdef SRT_ENABLE_RCVTSTAMP
+        w_packets[i]->m_tsArrival = m_bTimestamp ? clock.arrival(mh[i].msg_hdr) : srt::sync::steady_clock::time_point();
+#else
+        w_packets[i]->m_tsArrival = srt::sync::steady_clock::time_point();
+#endif
+    }
+
+    w_count = recv_count;
+    return RST_OK;
+#else
+    (void)size;
+    w_status[0] = recvfrom((w_addr[0]), (*w_packets[0]));
+    if (w_status[0] == RST_OK)
+        w_count = 1;
+
+    return w_status[0];
+#endif
+}
+
+// Waits until the socket is readable, for at most the receive timeout, or
+// until wakeup(). Returns a positive value when the socket is readable,
+// 0 on timeout (also on a wakeup when it isn't) and -1 on error.
+int CChannel::waitReadable() const
+{
+#ifdef _WIN32
+    fd_set set;
+    timeval tv;
+    FD_ZERO(&set);
+    FD_SET(m_iSocket, &set);
+    fd_set errset = set;
+    tv.tv_sec  = m_iRecvTimeoutUs / 1000000;
+    tv.tv_usec = m_iRecvTimeoutUs % 1000000;
+    return ::select((int) m_iSocket + 1, &set, NULL, &errset, &tv);
+#else
+    // Not select(): a process with many sockets easily gets
+    // descriptors beyond FD_SETSIZE.
+    pollfd fds[2];
+    fds[0].fd = m_iSocket;
+    fds[0].events = POLLIN;
+    fds[0].revents = 0;
+    fds[1].fd = m_aWakeupPipe[0]; // ignored by poll() if -1
+    fds[1].events = POLLIN;
+    fds[1].revents = 0;
+
+    // Rounded up, so that a short timeout doesn't turn into busy polling.
+    const int timeout_ms = (m_iRecvTimeoutUs + 999) / 1000;
+    int poll_ret = ::poll(fds, 2, timeout_ms);
+
+    if (poll_ret > 0 && fds[1].revents != 0)
+    {
+        char buf[64];
+        while (::read(fds[1].fd, buf, sizeof buf) > 0)
+            ;
+        if (fds[0].revents == 0)
+            poll_ret = 0;
+    }
+    return poll_ret;
+#endif
+}
+
+#ifdef SRT_ENABLE_GRO
+// Reads one datagram, which the kernel might have coalesced from several
+// packets of the same flow (UDP_GRO), and splits it into the given packets,
+// one per segment. Segments that don't fit in the given packets are dropped.
+EReadStatus CChannel::recvCoalesced(sockaddr_any* w_addr, CPacket* const* w_packets, EReadStatus* w_status, int size,
+        int& w_count) const
+{
+    union
+    {
+        cmsghdr hdr;
+#ifdef SRT_ENABLE_RCVTSTAMP
+        char buf[CMSG_SPACE(sizeof(int)) + RCVTSTAMP_CONTROL_SIZE];
+#else
+        char buf[CMSG_SPACE(sizeof(int))];
+#endif
+    } control;
+
+    iovec iov;
+    iov.iov_base = m_pGROBuffer;
+    iov.iov_len = MAX_GRO_SIZE;
+
+    msghdr mh;
+    mh.msg_name = w_addr[0].get();
+    mh.msg_namelen = w_addr[0].size();
+    mh.msg_iov = &iov;
+    mh.msg_iovlen = 1;
+    mh.msg_control = control.buf;
+    mh.msg_controllen = sizeof control.buf;
+    mh.msg_flags = 0;
+
+    int recv_size = ::recvmsg(m_iSocket, &mh, MSG_DONTWAIT);
+    int select_ret = 1;
+    if (recv_size == -1 && (NET_ERROR == EAGAIN || NET_ERROR == EWOULDBLOCK))
+    {
+        select_ret = waitReadable();
+
+        if (select_ret == 0)   // timeout
+            return RST_AGAIN;
+
+        if (select_ret > 0)
+            recv_size = ::recvmsg(m_iSocket, &mh, MSG_DONTWAIT);
+    }
+
+    // Errors are classified the same way as in recvfrom().
+    if (select_ret == -1 || recv_size == -1)
+    {
+        const int err = NET_ERROR;
+        if (err == EAGAIN || err == EINTR || err == ECONNREFUSED)
+            return RST_AGAIN;
+
+        HLOGC(mglog.Debug, log << CONID() << "(sys)recvmsg: " << SysStrError(err) << " [" << err << "]");
+        return RST_ERROR;
+    }
+
+    // Without the segment size the datagram has not been coalesced.
+    int segsize = 0;
+    for (cmsghdr* cm = CMSG_FIRSTHDR(&mh); cm != NULL; cm = CMSG_NXTHDR(&mh, cm))
+    {
+        if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+            memcpy(&segsize, CMSG_DATA(cm), sizeof segsize);
+    }
+    if (segsize <= 0 || segsize > recv_size)
+        segsize = recv_size;
+
+    // The segments of a coalesced datagram have arrived together, so they
+    // all get the arrival time reported for the datagram.
+    srt::sync::steady_clock::time_point arrival;
+#ifdef SRT_ENABLE_RCVTSTAMP
+    if (m_bTimestamp)
+        arrival = CArrivalClock().arrival(mh);
+#endif
+
+    int offset = 0;
+    int n = 0;
+    do
+    {
+        CPacket& packet = *w_packets[n];
+        const int seglen = std::min(segsize, recv_size - offset);
+        const int hdrlen = std::min(seglen, int(CPacket::HDR_SIZE));
+        int datalen = seglen - hdrlen;
+
+        // Reported as truncated, if it doesn't fit in the packet.
+        int msg_flags = mh.msg_flags;
+        if (datalen > int(packet.getLength()))
+        {
+            datalen = packet.getLength();
+            msg_flags |= MSG_TRUNC;
+        }
+
+        memcpy(packet.m_PacketVector[CPacket::PV_HEADER].data(), m_pGROBuffer + offset, hdrlen);
+        memcpy(packet.m_pcData, m_pGROBuffer + offset + hdrlen, datalen);
+        if (n > 0)
+            w_addr[n] = w_addr[0];
+
+        w_status[n] = checkReceived((packet), seglen, msg_flags);
+        packet.m_tsArrival = arrival;
+        offset += segsize;
+        ++ n;
+    }
+    while (offset < recv_size && n < size);
+
+    if (offset < recv_size)
+    {
+        LOGC(mglog.Error, log << CONID() << "LOCAL STORAGE DEPLETED. Dropping "
+            << ((recv_size - offset + segsize - 1) / segsize) << " packets of a coalesced datagram");
+    }
+
+    w_count = n;
+    return RST_OK;
+}
+#endif
+
+#ifdef SRT_ENABLE_IOURING
+void CChannel::postRecv(int slot, CPacket& packet)
+{
+    PostedRecv& r = m_pPostedRecv[slot];
+    r.packet = &packet;
+    r.addr = sockaddr_any(m_BindAddr.family());
+    r.mh.msg_name = r.addr.get();
+    r.mh.msg_namelen = r.addr.size();
+    r.mh.msg_iov = packet.m_PacketVector;
+    r.mh.msg_iovlen = 2;
+    r.mh.msg_control = NULL;
+    r.mh.msg_controllen = 0;
+    r.mh.msg_flags = 0;
+#ifdef SRT_ENABLE_RCVTSTAMP
+    if (m_bTimestamp)
+    {
+        r.mh.msg_control = r.control.buf;
+        r.mh.msg_controllen = sizeof r.control.buf;
+    }
+#endif
+
+    // There's room for a receive in every slot, so this can't fail.
+    m_pRecvRing->prepRecvmsg(&r.mh, uint64_t(slot));
+}
+
+EReadStatus CChannel::recvPosted(int* w_slot, sockaddr_any* w_addr, EReadStatus* w_status, int size,
+        int& w_count)
+{
+    w_count = 0;
+
+    // Submit the new receives and take the completed ones, but only if
+    // none has completed, wait for the first one.
+    int res = m_pRecvRing->submit();
+    if (res >= 0 && !m_pRecvRing->peekCompletion())
+    {
+        res = m_pRecvRing->submit(1, m_iRecvTimeoutUs);
+    }
+
+#ifdef SRT_ENABLE_RCVTSTAMP
+    const CArrivalClock clock;
+#endif
+    while (w_count < size)
+    {
+        const io_uring_cqe* cqe = m_pRecvRing->peekCompletion();
+        if (!cqe)
+            break;
+
+        const uint64_t data = cqe->user_data;
+        const int result = cqe->res;
+        m_pRecvRing->seenCompletion();
+        if (data >= uint64_t(MAX_RECV_BATCH))
+            continue;
+
+        PostedRecv& r = m_pPostedRecv[data];
+        w_slot[w_count] = int(data);
+        if (result < 0)
+        {
+            // Errors of a single receive are classified the same way as in
+            // recvfrom(), but the other receives continue anyway.
+            HLOGC(mglog.Debug, log << CONID() << "(sys)io_uring recvmsg: " << SysStrError(-result) << " [" << (-result) << "]");
+            r.packet->setLength(-1);
+            w_status[w_count] = RST_AGAIN;
+        }
+        else
+        {
+            w_addr[w_count] = r.addr;
+            w_status[w_count] = checkReceived((*r.packet), result, r.mh.msg_flags);
+        }
+#ifdef SRT_ENABLE_RCVTSTAMP
+        r.packet->m_tsArrival = (m_bTimestamp && result >= 0) ? clock.arrival(r.mh) : srt::sync::steady_clock::time_point();
+#else
+        r.packet->m_tsArrival = srt::sync::steady_clock::time_point();
+#endif
+        r.packet = NULL;
+        ++ w_count;
+    }
+
+    if (w_count > 0)
+        return RST_OK;
+
+    if (res < 0 && res != -ETIME && res != -EINTR && res != -EAGAIN && res != -EBUSY)
+    {
+        HLOGC(mglog.Debug, log << CONID() << "(sys)io_uring_enter: " << SysStrError(-res) << " [" << (-res) << "]");
+        return RST_ERROR;
+    }
+
+    return RST_AGAIN;
+}
+
+void CChannel::cancelPosted()
+{
+    if (!m_pRecvRing)
+        return;
+
+    int pending = 0;
+    for (int i = 0; i < MAX_RECV_BATCH; ++ i)
+    {
+        if (m_pPostedRecv[i].packet)
+        {
+            m_pRecvRing->prepCancel(uint64_t(i), CANCEL_DATA);
+            ++ pending;
+        }
+    }
+
+    // Every cancelled receive gets completed (possibly with a packet that
+    // has just arrived), and then the system doesn't use its packet anymore.
+    for (int attempt = 0; pending > 0 && attempt < 100; ++ attempt)
+    {
+        m_pRecvRing->submit(1, 10000);
+        while (const io_uring_cqe* cqe = m_pRecvRing->peekCompletion())
+        {
+            const uint64_t data = cqe->user_data;
+            m_pRecvRing->seenCompletion();
+            if (data < uint64_t(MAX_RECV_BATCH) && m_pPostedRecv[data].packet)
+            {
+                m_pPostedRecv[data].packet = NULL;
+                -- pending;
+            }
+        }
+    }
+
+    if (pending > 0)
+        LOGC(mglog.Error, log << CONID() << "io_uring: " << pending << " posted receives could not be cancelled");
+}
+
+CIOUring* CChannel::createSendRing()
+{
+    if (!m_bIOUring)
+        return NULL;
+
+    CIOUring* ring = new CIOUring;
+    if (!ring->open(MAX_SEND_BATCH, m_iSocket))
+    {
+        LOGC(mglog.Warn, log << "CHANNEL: io_uring ring for sending could not be created");
+        delete ring;
+        return NULL;
+    }
+
+    m_vSendRings.push_back(ring);
+    return ring;
+}
+
+int CChannel::sendRing(CIOUring& ring, const sockaddr_any* addr, CPacket* packets, int size)
+{
+    for (int i = 0; i < size; ++ i)
+    {
+        HLOGC(mglog.Debug, log << "CChannel::sendRing: SENDING NOW DST=" << SockaddrToString(addr[i])
+            << " target=@" << packets[i].m_iID
+            << " size=" << packets[i].getLength()
+            << " pkt.ts=" << packets[i].m_iTimeStamp
+            << " " << packets[i].Info());
+
+        // convert control information into network order
+        packets[i].toNL();
+    }
+
+    int ncalls = 0;
+    for (int begin = 0; begin < size; )
+    {
+        const int count = std::min(size - begin, int(MAX_SEND_BATCH));
+        msghdr mh[MAX_SEND_BATCH];
+        for (int i = 0; i < count; ++ i)
+        {
+            msghdr& h = mh[i];
+            h.msg_name = (sockaddr*)&addr[begin + i];
+            h.msg_namelen = addr[begin + i].size();
+            h.msg_iov = (iovec*)packets[begin + i].m_PacketVector;
+            h.msg_iovlen = 2;
+            h.msg_control = NULL;
+            h.msg_controllen = 0;
+            h.msg_flags = 0;
+            ring.prepSendmsg(&h, uint64_t(i));
+        }
+
+        // The socket is non-blocking and so are the sends, hence they
+        // complete right away. Wait for all of them, as the headers are
+        // released afterwards. Same as with sendto(), the failure of a
+        // single packet is not reported to the caller.
+        int completed = 0;
+        while (completed < count)
+        {
+            ++ ncalls;
+            const int res = ring.submit(count - completed);
+            while (const io_uring_cqe* cqe = ring.peekCompletion())
+            {
+                if (cqe->res < 0)
+                {
+                    HLOGC(mglog.Debug, log << CONID() << "(sys)io_uring sendmsg: " << SysStrError(-cqe->res)
+                        << " [" << (-cqe->res) << "]");
+                }
+                ring.seenCompletion();
+                ++ completed;
+            }
+
+            if (res < 0 && res != -EINTR && res != -EAGAIN && res != -EBUSY)
+            {
+                LOGC(mglog.Error, log << CONID() << "(sys)io_uring_enter: " << SysStrError(-res));
+                break;
+            }
+        }
+
+        begin += count;
+    }
+
+    for (int i = 0; i < size; ++ i)
+        packets[i].toHL();
+
+    return ncalls;
+}
+#else
+void CChannel::postRecv(int, CPacket&)
+{
+}
+
+EReadStatus CChannel::recvPosted(int*, sockaddr_any*, EReadStatus*, int, int& w_count)
+{
+    w_count = 0;
+    return RST_ERROR;
+}
+
+void CChannel::cancelPosted()
+{
+}
+
+CIOUring* CChannel::createSendRing()
+{
+    return NULL;
+}
+
+int CChannel::sendRing(CIOUring&, const sockaddr_any* addr, CPacket* packets, int size)
+{
+    int segmented = 0, timed = 0;
+    return sendmmsg(addr, packets, NULL, size, (segmented), (timed));
+}
+#endif
+
+// Completes the reading of a single packet: checks the size and flags
+// reported by the system and converts the header to the host order.
+EReadStatus CChannel::checkReceived(CPacket& w_packet, int recv_size, int msg_flags) const
+{
     // Sanity check for a case when it didn't fill in even the header
     if (size_t(recv_size) < CPacket::HDR_SIZE)
     {
-        status = RST_AGAIN;
         HLOGC(mglog.Debug, log << CONID() << "POSSIBLE ATTACK: received too short packet with " << recv_size << " bytes");
-        goto Return_error;
+        w_packet.setLength(-1);
+        return RST_AGAIN;
     }
 
     // Fix for an issue with Linux Kernel found during tests at Tencent.
@@ -688,8 +1753,8 @@ EReadStatus CChannel::recvfrom(sockaddr_any& w_addr, CPacket& w_packet) const
     {
         HLOGC(mglog.Debug, log << CONID() << "NET ERROR: packet size=" << recv_size
             << " msg_flags=0x" << hex << msg_flags << ", possibly MSG_TRUNC (0x" << hex << int(MSG_TRUNC) << ")");
-        status = RST_AGAIN;
-        goto Return_error;
+        w_packet.setLength(-1);
+        return RST_AGAIN;
     }
 
     w_packet.setLength(recv_size - CPacket::HDR_SIZE);
@@ -714,8 +1779,4 @@ EReadStatus CChannel::recvfrom(sockaddr_any& w_addr, CPacket& w_packet) const
     }
 
     return RST_OK;
-
-Return_error:
-    w_packet.setLength(-1);
-    return status;
 }
@@ -58,6 +58,8 @@ modified by
 #include "packet.h"
 #include "netinet_any.h"
 
+class CIOUring;
+
 class CChannel
 {
    void createSocket(int family);
@@ -86,7 +88,11 @@ public:
 
       /// Disconnect and close the UDP entity.
 
-   void close() const;
+   void close();
+
+      /// Get the UDP socket descriptor.
+
+   UDPSOCKET getSocket() const { return m_iSocket; }
 
       /// Get the UDP sending buffer size.
       /// @return Current UDP sending buffer size.
@@ -130,6 +136,33 @@ public:
 
    int sendto(const sockaddr_any& addr, CPacket& packet) const;
 
+      /// Send a series of packets, each to its own address, with as few
+      /// system calls as possible (sendmmsg() where available). With UDP
+      /// segmentation offload enabled, consecutive packets of the same size
+      /// sent to the same address are passed to the system as one datagram
+      /// that the kernel splits into packets. With kernel pacing (see
+      /// setTxTime()), every packet is given its departure time.
+      /// @param [in] addr array of destination addresses, one per packet.
+      /// @param [in] packets array of packets to be sent.
+      /// @param [in] departure array of departure times, one per packet (NULL: send now).
+      /// @param [in] size number of packets in the arrays.
+      /// @param [out] w_segmented number of packets sent with segmentation offload.
+      /// @param [out] w_timed number of packets sent with a departure time.
+      /// @return Number of system calls used to send the packets.
+
+   int sendmmsg(const sockaddr_any* addr, CPacket* packets, const srt::sync::steady_clock::time_point* departure,
+           int size, int& w_segmented, int& w_timed);
+
+   // Maximum number of packets passed to a single sendmmsg()/recvmmsg() call.
+   static const int MAX_SEND_BATCH = 64;
+   static const int MAX_RECV_BATCH = 64;
+
+   // Maximum size of a datagram passed for segmentation offload (UDP payload limit over IPv4).
+   static const int MAX_GSO_SIZE = 65507;
+
+   // Size of the buffer for a datagram coalesced by receive offload.
+   static const int MAX_GRO_SIZE = 65536;
+
       /// Receive a packet from the channel and record the source address.
       /// @param [in] addr pointer to the source address.
       /// @param [in] packet reference to a CPacket entity.
@@ -137,6 +170,179 @@ public:
 
    EReadStatus recvfrom(sockaddr_any& addr, CPacket& packet) const;
 
+      /// Receive a series of packets with one system call (recvmmsg() where available).
+      /// With UDP receive offload this reads one datagram and splits it into packets.
+      /// @param [out] addr array of source addresses, one per packet.
+      /// @param [in,out] packets array of packets to receive into.
+      /// @param [out] status receiving status of every received packet.
+      /// @param [in] size number of elements in the arrays.
+      /// @param [out] w_count number of packets received (including rejected ones).
+      /// @return RST_OK if at least one packet was received, otherwise as with recvfrom.
+
+   EReadStatus recvmmsg(sockaddr_any* addr, CPacket* const* packets, EReadStatus* status, int size,
+           int& w_count) const;
+
+      /// Enable UDP generic segmentation offload (UDP_SEGMENT) for sendmmsg().
+      /// If the system doesn't support it, it is turned off when the channel
+      /// is opened or when the kernel rejects the first segmented datagram.
+      /// @param [in] enable true to use segmentation offload when possible.
+
+   void setGSO(bool enable);
+
+      /// Check whether UDP segmentation offload is currently in use.
+
+   bool getGSO() const { return m_bGSO; }
+
+      /// Enable UDP generic receive offload (UDP_GRO). The kernel may then
+      /// coalesce several packets of the same flow into one datagram, which
+      /// recvmmsg() splits back into packets. If the system doesn't support
+      /// it, it is turned off when the channel is opened.
+      /// @param [in] enable true to use receive offload when possible.
+
+   void setGRO(bool enable);
+
+      /// Check whether UDP receive offload is currently in use.
+      /// When it is, the packets may be only read with recvmmsg().
+
+   bool getGRO() const { return m_bGRO; }
+
+      /// Enable kernel pacing (SO_TXTIME): the packets sent by sendmmsg()
+      /// are given their departure time and the kernel holds them until
+      /// then. This needs a qdisc that honors it (fq) on the outgoing
+      /// interface, otherwise the packets leave immediately. If the system
+      /// doesn't support it, it is turned off when the channel is opened.
+      /// @param [in] enable true to use kernel pacing when possible.
+
+   void setTxTime(bool enable);
+
+      /// Check whether kernel pacing is in use.
+
+   bool getTxTime() const { return m_bTxTime; }
+
+      /// Take the arrival time of the received packets from the system
+      /// (SO_TIMESTAMPNS) and report it in CPacket::m_tsArrival. Otherwise,
+      /// and if the system doesn't report it, m_tsArrival is left zero. If the
+      /// system doesn't support it, it is turned off when the channel is opened.
+      /// @param [in] enable true to use the arrival time from the system when possible.
+
+   void setTimestamp(bool enable);
+
+      /// Check whether the arrival time is taken from the system.
+
+   bool getTimestamp() const { return m_bTimestamp; }
+
+      /// Allow other sockets to bind to the same address (SO_REUSEPORT), so that
+      /// the system distributes the incoming datagrams among them. Must be set
+      /// before the channel is opened. If the system doesn't support it, it is
+      /// turned off when the channel is opened.
+      /// @param [in] enable true to share the port with other sockets.
+
+   void setReusePort(bool enable);
+
+      /// Check whether the port can be shared with other sockets.
+
+   bool getReusePort() const { return m_bReusePort; }
+
+      /// Make the system deliver the packets addressed to an SRT socket to
+      /// the member (socket ID % members) of the group of sockets sharing the
+      /// port, in the order they were bound. Connection requests, which have
+      /// no socket ID yet, are still distributed by the system.
+      /// @param [in] members number of sockets in the group.
+      /// @return true if the steering is in effect.
+
+   bool setReusePortSteering(int members);
+
+      /// Use io_uring for the socket (only when built with ENABLE_IOURING).
+      /// Receives are then posted in advance to a ring, see postRecv(), and
+      /// batches of packets can be sent through a ring, see sendRing(). Must
+      /// be set before the channel is opened. If the system doesn't support
+      /// it, it is turned off when the channel is opened.
+      /// @param [in] enable true to use io_uring when possible.
+
+   void setIOUring(bool enable);
+
+      /// Check whether io_uring is in use.
+
+   bool getIOUring() const { return m_bIOUring; }
+
+      /// Check whether the packets are received with posted receives. This is
+      /// the case when io_uring is in use, but not together with receive offload.
+
+   bool usesRecvRing() const { return m_pRecvRing != NULL; }
+
+      /// Post a receive into the given packet. It's submitted by the next
+      /// call to recvPosted(), and the packet must stay in place until the
+      /// receive is reported complete by recvPosted() or until cancelPosted().
+      /// @param [in] slot identifier of the receive, [0, MAX_RECV_BATCH)
+      /// @param [in] packet packet to receive into.
+
+   void postRecv(int slot, CPacket& packet);
+
+      /// Submit the posted receives and collect the completed ones. If none
+      /// has completed yet, wait for the first one, with the same timeout as
+      /// recvfrom().
+      /// @param [out] slot array of the slots of the completed receives.
+      /// @param [out] addr array of source addresses, one per completed receive.
+      /// @param [out] status receiving status of every completed receive.
+      /// @param [in] size number of elements in the arrays.
+      /// @param [out] w_count number of completed receives (including rejected ones).
+      /// @return RST_OK if at least one receive has completed, otherwise as with recvfrom.
+
+   EReadStatus recvPosted(int* slot, sockaddr_any* addr, EReadStatus* status, int size,
+           int& w_count);
+
+      /// Cancel all posted receives and wait until the system has released their packets.
+
+   void cancelPosted();
+
+      /// Create a ring for sending through this channel with sendRing(). The
+      /// ring is owned by the channel and may be used by one thread at a time.
+      /// @return The ring, or NULL if io_uring is not in use.
+
+   CIOUring* createSendRing();
+
+      /// Send a series of packets, each to its own address, through the given
+      /// ring: all of them are submitted and reaped with one system call.
+      /// @param [in] ring ring created with createSendRing().
+      /// @param [in] addr array of destination addresses, one per packet.
+      /// @param [in] packets array of packets to be sent.
+      /// @param [in] size number of packets in both arrays.
+      /// @return Number of system calls used to send the packets.
+
+   int sendRing(CIOUring& ring, const sockaddr_any* addr, CPacket* packets, int size);
+
+      /// Make the waiting receiving calls return also when wakeup() is called,
+      /// so that one thread can wait for the packets and for other events at
+      /// once. Must be set before the channel is opened. The receives are then
+      /// not posted to io_uring. On Windows the receiving calls can't be woken
+      /// up and return only when their timeout passes.
+      /// @param [in] enable true to make the receiving calls interruptible.
+
+   void setWakeup(bool enable);
+
+      /// Check whether the receiving calls can be woken up.
+
+   bool getWakeup() const { return m_bWakeup; }
+
+      /// Announce that the receiving thread is going to wait for packets.
+      /// It must be called before the thread checks the other events it waits
+      /// for; from then on wakeup() interrupts the wait, until endWait().
+
+   void beginWait() { m_bWaiting = true; }
+   void endWait() { m_bWaiting = false; }
+
+      /// Interrupt the waiting receiving call announced by beginWait(), or
+      /// the next one if it hasn't started yet. Can be called from any thread.
+
+   void wakeup() const;
+
+      /// Set the maximum time the receiving calls wait for a packet.
+      /// @param [in] us the timeout in microseconds, DEF_RECV_TIMEOUT_US by default.
+
+   void setRecvTimeout(int us) { m_iRecvTimeoutUs = us; }
+
+   static const int DEF_RECV_TIMEOUT_US = 10000;
+
       /// Set the IP TTL.
       /// @param [in] ttl IP Time To Live.
       /// @return none.
@@ -167,6 +373,10 @@ public:
 
 private:
    void setUDPSockOpt();
+   EReadStatus checkReceived(CPacket& w_packet, int recv_size, int msg_flags) const;
+   int waitReadable() const;
+   EReadStatus recvCoalesced(sockaddr_any* addr, CPacket* const* packets, EReadStatus* status, int size,
+           int& w_count) const;
 
 private:
 
@@ -176,6 +386,21 @@ private:
    int m_iSndBufSize;                   // UDP sending buffer size
    int m_iRcvBufSize;                   // UDP receiving buffer size
    int m_iIpV6Only;                     // IPV6_V6ONLY option (-1 if not set)
+   bool m_bGSO;                         // UDP segmentation offload in use
+   bool m_bGRO;                         // UDP receive offload in use
+   char* m_pGROBuffer;                  // buffer for a datagram coalesced by receive offload
+   bool m_bReusePort;                   // SO_REUSEPORT option
+   bool m_bTxTime;                      // kernel pacing (SO_TXTIME) in use
+   bool m_bTimestamp;                   // arrival time from the system (SO_TIMESTAMPNS) in use
+   bool m_bIOUring;                     // io_uring in use
+   CIOUring* m_pRecvRing;               // ring of the posted receives
+   struct PostedRecv;
+   PostedRecv* m_pPostedRecv;           // posted receives, by slot
+   std::vector<CIOUring*> m_vSendRings; // rings created for the sending threads
+   bool m_bWakeup;                      // the receiving calls can be woken up
+   int m_aWakeupPipe[2];                // pipe written to wake up the receiving call, -1 if none
+   volatile bool m_bWaiting;            // the receiving thread waits, see beginWait()
+   int m_iRecvTimeoutUs;                // maximum wait of the receiving calls
    sockaddr_any m_BindAddr;
 };
 
@@ -229,6 +229,21 @@ CUDT::CUDT(CUDTSocket* parent): m_parent(parent)
     m_iRcvBufSize     = DEF_BUFFER_SIZE;
     m_iUDPSndBufSize  = DEF_UDP_BUFFER_SIZE;
     m_iUDPRcvBufSize  = m_iRcvBufSize * m_iMSS;
+    m_iUDPSndBatch    = 1;
+    m_iUDPRcvBatch    = 1;
+    m_bUDPGSO         = false;
+    m_bUDPGRO         = false;
+    m_iUDPRcvShards   = 1;
+    m_iUDPSndShards   = 1;
+    m_bUDPIOUring     = false;
+    m_bUDPTxTime      = false;
+    m_bUDPTimestamp   = false;
+    m_iUDPRcvPoolHold = DEF_UDP_RCVPOOLHOLD;
+    m_iBufAlloc       = SRT_BUFALLOC_DEFAULT;
+    m_iUDPSndSched    = SRT_SNDSCHED_HEAP;
+    m_bUDPSingleThread = false;
+    m_bUDPNoThreads   = false;
+    m_iRcvLoans       = DEF_RCV_LOANS;
 
     // Linger: LIVE mode defaults, please refer to `SRTO_TRANSTYPE` option
     // for other modes.
@@ -296,6 +311,21 @@ CUDT::CUDT(CUDTSocket* parent, const CUDT& ancestor): m_parent(parent)
     m_Linger          = ancestor.m_Linger;
     m_iUDPSndBufSize  = ancestor.m_iUDPSndBufSize;
     m_iUDPRcvBufSize  = ancestor.m_iUDPRcvBufSize;
+    m_iUDPSndBatch    = ancestor.m_iUDPSndBatch;
+    m_iUDPRcvBatch    = ancestor.m_iUDPRcvBatch;
+    m_bUDPGSO         = ancestor.m_bUDPGSO;
+    m_bUDPGRO         = ancestor.m_bUDPGRO;
+    m_iUDPRcvShards   = ancestor.m_iUDPRcvShards;
+    m_iUDPSndShards   = ancestor.m_iUDPSndShards;
+    m_bUDPIOUring     = ancestor.m_bUDPIOUring;
+    m_bUDPTxTime      = ancestor.m_bUDPTxTime;
+    m_bUDPTimestamp   = ancestor.m_bUDPTimestamp;
+    m_iUDPRcvPoolHold = ancestor.m_iUDPRcvPoolHold;
+    m_iBufAlloc       = ancestor.m_iBufAlloc;
+    m_iUDPSndSched    = ancestor.m_iUDPSndSched;
+    m_bUDPSingleThread = ancestor.m_bUDPSingleThread;
+    m_bUDPNoThreads   = ancestor.m_bUDPNoThreads;
+    m_iRcvLoans       = ancestor.m_iRcvLoans;
     m_bRendezvous     = ancestor.m_bRendezvous;
     m_SrtHsSide = ancestor.m_SrtHsSide; // actually it sets it to HSD_RESPONDER
     m_tdConnTimeOut = ancestor.m_tdConnTimeOut;
@@ -524,6 +554,156 @@ void CUDT::setOpt(SRT_SOCKOPT optName, const void* optval, int optlen)
 
         break;
 
+    case SRTO_UDP_SNDBATCH:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < 1 || val > CChannel::MAX_SEND_BATCH)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPSndBatch = val;
+        }
+        break;
+
+    case SRTO_UDP_RCVBATCH:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < 1 || val > CChannel::MAX_RECV_BATCH)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPRcvBatch = val;
+        }
+        break;
+
+    case SRTO_UDP_GSO:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPGSO = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_GRO:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPGRO = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_RCVSHARDS:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < 1 || val > CMultiplexer::MAX_RCV_SHARDS)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPRcvShards = val;
+        }
+        break;
+
+    case SRTO_UDP_SNDSHARDS:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < 1 || val > CMultiplexer::MAX_SND_SHARDS)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPSndShards = val;
+        }
+        break;
+
+    case SRTO_UDP_IOURING:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPIOUring = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_TXTIME:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPTxTime = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_TIMESTAMP:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPTimestamp = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_RCVPOOLHOLD:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < -1)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPRcvPoolHold = val;
+        }
+        break;
+
+    case SRTO_BUFALLOC:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < SRT_BUFALLOC_DEFAULT || val > SRT_BUFALLOC_HUGEPAGES_NUMA)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iBufAlloc = val;
+        }
+        break;
+
+    case SRTO_UDP_SNDSCHED:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < SRT_SNDSCHED_HEAP || val > SRT_SNDSCHED_WHEEL)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iUDPSndSched = val;
+        }
+        break;
+
+    case SRTO_UDP_SINGLETHREAD:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPSingleThread = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_UDP_NOTHREADS:
+        if (m_bOpened)
+            throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
+
+        m_bUDPNoThreads = cast_optval<bool>(optval, optlen);
+        break;
+
+    case SRTO_RCVLOANS:
+        {
+            const int val = cast_optval<int>(optval, optlen);
+            if (val < 0)
+                throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+            m_iRcvLoans = val;
+        }
+        break;
+
     case SRTO_RENDEZVOUS:
         if (m_bConnecting || m_bConnected)
             throw CUDTException(MJ_NOTSUP, MN_ISBOUND, 0);
@@ -1012,6 +1192,10 @@ void CUDT::getOpt(SRT_SOCKOPT optName, void *optval, int &optlen)
 {
     ScopedLock cg(m_ConnectionLock);
 
+    // Once the socket is bound, the system features of the multiplexer
+    // are reported as they are in use, off if the system doesn't support them.
+    const CChannel* channel = m_pSndQueue ? m_pSndQueue->m_pChannel : NULL;
+
     switch (optName)
     {
     case SRTO_MSS:
@@ -1067,6 +1251,81 @@ void CUDT::getOpt(SRT_SOCKOPT optName, void *optval, int &optlen)
         optlen         = sizeof(int);
         break;
 
+    case SRTO_UDP_SNDBATCH:
+        *(int *)optval = m_iUDPSndBatch;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_RCVBATCH:
+        *(int *)optval = m_iUDPRcvBatch;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_GSO:
+        *(bool *)optval = m_bUDPGSO && (!channel || channel->getGSO());
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_GRO:
+        *(bool *)optval = m_bUDPGRO && (!channel || channel->getGRO());
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_RCVSHARDS:
+        *(int *)optval = m_iUDPRcvShards;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_SNDSHARDS:
+        *(int *)optval = m_iUDPSndShards;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_IOURING:
+        *(bool *)optval = m_bUDPIOUring && (!channel || channel->getIOUring());
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_TXTIME:
+        *(bool *)optval = m_bUDPTxTime && (!channel || channel->getTxTime());
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_TIMESTAMP:
+        *(bool *)optval = m_bUDPTimestamp && (!channel || channel->getTimestamp());
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_RCVPOOLHOLD:
+        *(int *)optval = m_iUDPRcvPoolHold;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_BUFALLOC:
+        *(int *)optval = m_iBufAlloc;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_SNDSCHED:
+        *(int *)optval = m_iUDPSndSched;
+        optlen         = sizeof(int);
+        break;
+
+    case SRTO_UDP_SINGLETHREAD:
+        *(bool *)optval = m_bUDPSingleThread;
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_UDP_NOTHREADS:
+        *(bool *)optval = m_bUDPNoThreads;
+        optlen          = sizeof(bool);
+        break;
+
+    case SRTO_RCVLOANS:
+        *(int *)optval = m_iRcvLoans;
+        optlen         = sizeof(int);
+        break;
+
     case SRTO_RENDEZVOUS:
         *(bool *)optval = m_bRendezvous;
         optlen          = sizeof(bool);
@@ -1459,6 +1718,10 @@ void CUDT::clearData()
         m_stats.traceRcvBytesUndecrypt   = 0;
 
         m_stats.sndDuration = m_stats.m_sndDurationTotal = 0;
+
+        m_stats.rcvLoaned           = 0;
+        m_stats.rcvLoanedMax        = 0;
+        m_stats.rcvLoanRefusedTotal = 0;
     }
 
     // Resetting these data because this happens when agent isn't connected.
@@ -1494,12 +1757,15 @@ void CUDT::open()
     m_pSNode->m_pUDT      = this;
     m_pSNode->m_tsTimeStamp = steady_clock::now();
     m_pSNode->m_iHeapLoc  = -1;
+    m_pSNode->m_pPrev     = NULL;
+    m_pSNode->m_pNext     = NULL;
 
     if (m_pRNode == NULL)
         m_pRNode = new CRNode;
     m_pRNode->m_pUDT      = this;
     m_pRNode->m_tsTimeStamp = steady_clock::now();
     m_pRNode->m_pPrev = m_pRNode->m_pNext = NULL;
+    m_pRNode->m_iHeapLoc                  = -1;
     m_pRNode->m_bOnList                   = false;
 
     m_iRTT    = 10 * COMM_SYN_INTERVAL_US;
@@ -5804,7 +6070,7 @@ bool CUDT::prepareConnectionObjects(const CHandShake &hs, HandshakeSide hsd, CUD
 
     try
     {
-        m_pSndBuffer = new CSndBuffer(32, m_iMaxSRTPayloadSize);
+        m_pSndBuffer = new CSndBuffer(32, m_iMaxSRTPayloadSize, m_iBufAlloc, m_pRcvQueue->m_UnitQueue.getNumaNode());
         m_pRcvBuffer = new CRcvBuffer(&(m_pRcvQueue->m_UnitQueue), m_iRcvBufSize);
         // after introducing lite ACK, the sndlosslist may not be cleared in time, so it requires twice space.
         m_pSndLossList = new CSndLossList(m_iFlowWindowSize * 2);
@@ -6508,11 +6774,14 @@ void CUDT::checkNeedDrop(bool& w_bCongestion)
 
     if (threshold_ms && timespan_ms > threshold_ms)
     {
+        std::vector<CSndRelease> released;
+
         // protect packet retransmission
         enterCS(m_RecvAckLock);
         int dbytes;
         int32_t first_msgno;
-        int dpkts = m_pSndBuffer->dropLateData((dbytes), (first_msgno), steady_clock::now() - milliseconds_from(threshold_ms));
+        int dpkts = m_pSndBuffer->dropLateData((dbytes), (first_msgno), steady_clock::now() - milliseconds_from(threshold_ms),
+                (released));
         if (dpkts > 0)
         {
             enterCS(m_StatsLock);
@@ -6549,6 +6818,8 @@ void CUDT::checkNeedDrop(bool& w_bCongestion)
         }
         w_bCongestion = true;
         leaveCS(m_RecvAckLock);
+
+        m_pSndQueue->release(released);
     }
     else if (timespan_ms > (m_iPeerTsbPdDelay_ms / 2))
     {
@@ -6568,34 +6839,17 @@ int CUDT::sendmsg(const char *data, int len, int msttl, bool inorder, int64_t sr
     return this->sendmsg2(data, len, (mctrl));
 }
 
-int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl)
+void CUDT::checkSendArgs(const char* data, int len, const SRT_MSGCTRL& mctrl)
 {
-    bool         bCongestion = false;
-
-    // throw an exception if not connected
-    if (m_bBroken || m_bClosing)
-        throw CUDTException(MJ_CONNECTION, MN_CONNLOST, 0);
-    else if (!m_bConnected || !m_CongCtl.ready())
-        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
-
-    if (len <= 0)
-    {
-        LOGC(dlog.Error, log << "INVALID: Data size for sending declared with length: " << len);
-        return 0;
-    }
-
-    if (w_mctrl.msgno != -1) // most unlikely, unless you use balancing groups
+    if (mctrl.msgno != -1) // most unlikely, unless you use balancing groups
     {
-        if (w_mctrl.msgno < 1 || w_mctrl.msgno > MSGNO_SEQ_MAX)
+        if (mctrl.msgno < 1 || mctrl.msgno > MSGNO_SEQ_MAX)
         {
-            LOGC(dlog.Error, log << "INVALID forced msgno " << w_mctrl.msgno << ": can be -1 (trap) or <1..." << MSGNO_SEQ_MAX << ">");
+            LOGC(dlog.Error, log << "INVALID forced msgno " << mctrl.msgno << ": can be -1 (trap) or <1..." << MSGNO_SEQ_MAX << ">");
             throw CUDTException(MJ_NOTSUP, MN_INVAL);
         }
     }
 
-    int  msttl   = w_mctrl.msgttl;
-    bool inorder = w_mctrl.inorder;
-
     // Sendmsg isn't restricted to the congctl type, however the congctl
     // may want to have something to say here.
     // NOTE: SrtCongestion is also allowed to throw CUDTException() by itself!
@@ -6608,7 +6862,7 @@ int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl)
             mn  = MN_INVALBUFFERAPI;
         }
 
-        if (!m_CongCtl->checkTransArgs(api, SrtCongestion::STAD_SEND, data, len, msttl, inorder))
+        if (!m_CongCtl->checkTransArgs(api, SrtCongestion::STAD_SEND, data, len, mctrl.msgttl, mctrl.inorder))
             throw CUDTException(MJ_NOTSUP, mn, 0);
     }
 
@@ -6637,39 +6891,10 @@ int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl)
                  << (m_iSndBufSize * m_iMaxSRTPayloadSize) << ". Use SRTO_SNDBUF if needed.");
         throw CUDTException(MJ_NOTSUP, MN_XSIZE, 0);
     }
+}
 
-    /* XXX
-       This might be worth preserving for several occasions, but it
-       must be at least conditional because it breaks backward compat.
-    if (!m_pCryptoControl || !m_pCryptoControl->isSndEncryptionOK())
-    {
-        LOGC(dlog.Error, log << "Encryption is required, but the peer did not supply correct credentials. Sending
-    rejected."); throw CUDTException(MJ_SETUP, MN_SECURITY, 0);
-    }
-    */
-
-    UniqueLock sendguard(m_SendLock);
-
-    if (m_pSndBuffer->getCurrBufSize() == 0)
-    {
-        // delay the EXP timer to avoid mis-fired timeout
-        ScopedLock ack_lock(m_RecvAckLock);
-        m_tsLastRspAckTime = steady_clock::now();
-        m_iReXmitCount   = 1;
-    }
-
-    // checkNeedDrop(...) may lock m_RecvAckLock
-    // to modify m_pSndBuffer and m_pSndLossList
-    checkNeedDrop((bCongestion));
-
-    int minlen = 1; // Minimum sender buffer space required for STREAM API
-    if (m_bMessageAPI)
-    {
-        // For MESSAGE API the minimum outgoing buffer space required is
-        // the size that can carry over the whole message as passed here.
-        minlen = (len + m_iMaxSRTPayloadSize - 1) / m_iMaxSRTPayloadSize;
-    }
-
+bool CUDT::waitSndBufferSpace(int minlen)
+{
     if (sndBuffersLeft() < minlen)
     {
         //>>We should not get here if SRT_ENABLE_TLPKTDROP
@@ -6738,100 +6963,188 @@ int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl)
                  log << "IPE: sendmsg: the loop exited, while not enough size, still connected, peer healthy. "
                         "Impossible.");
 
-            return 0;
+            return false;
         }
     }
 
-    // If the sender's buffer is empty,
-    // record total time used for sending
-    if (m_pSndBuffer->getCurrBufSize() == 0)
-    {
-        ScopedLock lock(m_StatsLock);
-        m_stats.sndDurationCounter = steady_clock::now();
-    }
+    return true;
+}
 
-    int size = len;
-    if (!m_bMessageAPI)
-    {
-        // For STREAM API it's allowed to send less bytes than the given buffer.
-        // Just return how many bytes were actually scheduled for writing.
-        // XXX May be reasonable to add a flag that requires that the function
-        // not return until the buffer is sent completely.
-        size = min(len, sndBuffersLeft() * m_iMaxSRTPayloadSize);
-    }
+bool CUDT::scheduleMsg(const char* data, int size, SRT_MSGCTRL& w_mctrl,
+                       srt_send_release_fn*& w_release, void* release_opaque)
+{
+    int32_t seqno = m_iSndNextSeqNo;
+    IF_HEAVY_LOGGING(int32_t orig_seqno = seqno);
+    IF_HEAVY_LOGGING(steady_clock::time_point ts_srctime = steady_clock::time_point() + microseconds_from(w_mctrl.srctime));
 
+    // Check if seqno has been set, in case when this is a group sender.
+    // If the sequence is from the past towards the "next sequence",
+    // do not schedule it, the caller pretends that it has been sent.
+    if (w_mctrl.pktseq != SRT_SEQNO_NONE && m_iSndNextSeqNo != SRT_SEQNO_NONE)
     {
-        ScopedLock recvAckLock(m_RecvAckLock);
-        // insert the user buffer into the sending list
-
-        int32_t seqno = m_iSndNextSeqNo;
-        IF_HEAVY_LOGGING(int32_t orig_seqno = seqno);
-        IF_HEAVY_LOGGING(steady_clock::time_point ts_srctime = steady_clock::time_point() + microseconds_from(w_mctrl.srctime));
-
-        // Check if seqno has been set, in case when this is a group sender.
-        // If the sequence is from the past towards the "next sequence",
-        // simply return the size, pretending that it has been sent.
-        if (w_mctrl.pktseq != SRT_SEQNO_NONE && m_iSndNextSeqNo != SRT_SEQNO_NONE)
+        if (CSeqNo::seqcmp(w_mctrl.pktseq, seqno) < 0)
         {
-            if (CSeqNo::seqcmp(w_mctrl.pktseq, seqno) < 0)
-            {
-                HLOGC(dlog.Debug, log << CONID() << "sock:SENDING (NOT): group-req %" << w_mctrl.pktseq
-                        << " OLDER THAN next expected %" << seqno << " - FAKE-SENDING.");
-                return size;
-            }
+            HLOGC(dlog.Debug, log << CONID() << "sock:SENDING (NOT): group-req %" << w_mctrl.pktseq
+                    << " OLDER THAN next expected %" << seqno << " - FAKE-SENDING.");
+            return false;
         }
+    }
 
-        // Set this predicted next sequence to the control information.
-        // It's the sequence of the FIRST (!) packet from all packets used to send
-        // this buffer. Values from this field will be monotonic only if you always
-        // have one packet per buffer (as it's in live mode).
-        w_mctrl.pktseq = seqno;
+    // Set this predicted next sequence to the control information.
+    // It's the sequence of the FIRST (!) packet from all packets used to send
+    // this buffer. Values from this field will be monotonic only if you always
+    // have one packet per buffer (as it's in live mode).
+    w_mctrl.pktseq = seqno;
 
-        // Now seqno is the sequence to which it was scheduled
-        // XXX Conversion from w_mctrl.srctime -> steady_clock::time_point need not be accurrate.
-        HLOGC(dlog.Debug, log << CONID() << "buf:SENDING (BEFORE) srctime:"
-                << (w_mctrl.srctime ? FormatTime(ts_srctime) : "none")
-                << " DATA SIZE: " << size << " sched-SEQUENCE: " << seqno
-                << " STAMP: " << BufferStamp(data, size));
+    // Now seqno is the sequence to which it was scheduled
+    // XXX Conversion from w_mctrl.srctime -> steady_clock::time_point need not be accurrate.
+    HLOGC(dlog.Debug, log << CONID() << "buf:SENDING (BEFORE) srctime:"
+            << (w_mctrl.srctime ? FormatTime(ts_srctime) : "none")
+            << " DATA SIZE: " << size << " sched-SEQUENCE: " << seqno
+            << " STAMP: " << BufferStamp(data, size));
 
-        if (w_mctrl.srctime && w_mctrl.srctime < count_microseconds(m_stats.tsStartTime.time_since_epoch()))
-        {
-            LOGC(mglog.Error,
-                log << "Wrong source time was provided. Sending is rejected.");
-            throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI);
-        }
+    if (w_mctrl.srctime && w_mctrl.srctime < count_microseconds(m_stats.tsStartTime.time_since_epoch()))
+    {
+        LOGC(mglog.Error,
+            log << "Wrong source time was provided. Sending is rejected.");
+        throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI);
+    }
 
-        if (w_mctrl.srctime && (!m_bMessageAPI || !m_bTsbPd))
-        {
-            HLOGC(dlog.Warn,
-                log << "Source time can only be used with TSBPD and Message API enabled. Using default time instead.");
-            w_mctrl.srctime = 0;
-        }
+    if (w_mctrl.srctime && (!m_bMessageAPI || !m_bTsbPd))
+    {
+        HLOGC(dlog.Warn,
+            log << "Source time can only be used with TSBPD and Message API enabled. Using default time instead.");
+        w_mctrl.srctime = 0;
+    }
 
-        // w_mctrl.seqno is INPUT-OUTPUT value:
-        // - INPUT: the current sequence number to be placed for the next scheduled packet
-        // - OUTPUT: value of the sequence number to be put on the first packet at the next sendmsg2 call.
-        // We need to supply to the output the value that was STAMPED ON THE PACKET,
-        // which is seqno. In the output we'll get the next sequence number.
+    // w_mctrl.seqno is INPUT-OUTPUT value:
+    // - INPUT: the current sequence number to be placed for the next scheduled packet
+    // - OUTPUT: value of the sequence number to be put on the first packet at the next sendmsg2 call.
+    // We need to supply to the output the value that was STAMPED ON THE PACKET,
+    // which is seqno. In the output we'll get the next sequence number.
+    // The packets are encrypted in place in the sender buffer, so the
+    // user data block may be referenced only if there is no encryption.
+    if (w_release && (!m_pCryptoControl || !m_pCryptoControl->hasPassphrase()))
+    {
+        m_pSndBuffer->addBuffer(data, size, (w_mctrl), w_release, release_opaque);
+        w_release = NULL;
+    }
+    else
+    {
         m_pSndBuffer->addBuffer(data, size, (w_mctrl));
-        m_iSndNextSeqNo = w_mctrl.pktseq;
-        w_mctrl.pktseq = seqno;
+    }
+    m_iSndNextSeqNo = w_mctrl.pktseq;
+    w_mctrl.pktseq = seqno;
 
-        HLOGC(dlog.Debug, log << CONID() << "buf:SENDING srctime:" << FormatTime(ts_srctime)
-              << " size=" << size << " #" << w_mctrl.msgno << " SCHED %" << orig_seqno
-              << "(>> %" << seqno << ") !" << BufferStamp(data, size));
+    HLOGC(dlog.Debug, log << CONID() << "buf:SENDING srctime:" << FormatTime(ts_srctime)
+          << " size=" << size << " #" << w_mctrl.msgno << " SCHED %" << orig_seqno
+          << "(>> %" << seqno << ") !" << BufferStamp(data, size));
 
-        if (sndBuffersLeft() < 1) // XXX Not sure if it should test if any space in the buffer, or as requried.
-        {
+    return true;
+}
+
+int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl,
+                   srt_send_release_fn* release, void* release_opaque)
+{
+    bool         bCongestion = false;
+    bool         faked       = false;
+
+    // throw an exception if not connected
+    if (m_bBroken || m_bClosing)
+        throw CUDTException(MJ_CONNECTION, MN_CONNLOST, 0);
+    else if (!m_bConnected || !m_CongCtl.ready())
+        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
+
+    if (len <= 0)
+    {
+        LOGC(dlog.Error, log << "INVALID: Data size for sending declared with length: " << len);
+        return 0;
+    }
+
+    checkSendArgs(data, len, w_mctrl);
+
+    /* XXX
+       This might be worth preserving for several occasions, but it
+       must be at least conditional because it breaks backward compat.
+    if (!m_pCryptoControl || !m_pCryptoControl->isSndEncryptionOK())
+    {
+        LOGC(dlog.Error, log << "Encryption is required, but the peer did not supply correct credentials. Sending
+    rejected."); throw CUDTException(MJ_SETUP, MN_SECURITY, 0);
+    }
+    */
+
+    UniqueLock sendguard(m_SendLock);
+
+    if (m_pSndBuffer->getCurrBufSize() == 0)
+    {
+        // delay the EXP timer to avoid mis-fired timeout
+        ScopedLock ack_lock(m_RecvAckLock);
+        m_tsLastRspAckTime = steady_clock::now();
+        m_iReXmitCount   = 1;
+    }
+
+    // checkNeedDrop(...) may lock m_RecvAckLock
+    // to modify m_pSndBuffer and m_pSndLossList
+    checkNeedDrop((bCongestion));
+
+    int minlen = 1; // Minimum sender buffer space required for STREAM API
+    if (m_bMessageAPI)
+    {
+        // For MESSAGE API the minimum outgoing buffer space required is
+        // the size that can carry over the whole message as passed here.
+        minlen = (len + m_iMaxSRTPayloadSize - 1) / m_iMaxSRTPayloadSize;
+    }
+
+    if (!waitSndBufferSpace(minlen))
+        return 0;
+
+    // If the sender's buffer is empty,
+    // record total time used for sending
+    if (m_pSndBuffer->getCurrBufSize() == 0)
+    {
+        ScopedLock lock(m_StatsLock);
+        m_stats.sndDurationCounter = steady_clock::now();
+    }
+
+    int size = len;
+    if (!m_bMessageAPI)
+    {
+        // For STREAM API it's allowed to send less bytes than the given buffer.
+        // Just return how many bytes were actually scheduled for writing.
+        // XXX May be reasonable to add a flag that requires that the function
+        // not return until the buffer is sent completely.
+        size = min(len, sndBuffersLeft() * m_iMaxSRTPayloadSize);
+    }
+
+    {
+        ScopedLock recvAckLock(m_RecvAckLock);
+        // insert the user buffer into the sending list
+        if (!scheduleMsg(data, size, (w_mctrl), (release), release_opaque))
+        {
+            faked = true;
+        }
+        else if (sndBuffersLeft() < 1) // XXX Not sure if it should test if any space in the buffer, or as requried.
+        {
             // write is not available any more
             s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, SRT_EPOLL_OUT, false);
         }
     }
 
+    if (faked)
+    {
+        if (release)
+            release(release_opaque, data, len);
+        return size;
+    }
+
     // insert this socket to the snd list if it is not on the list yet
     // m_pSndUList->pop may lock CSndUList::m_ListLock and then m_RecvAckLock
     m_pSndQueue->m_pSndUList->update(this, CSndUList::rescheduleIf(bCongestion));
 
+    // The data have been copied into the sender buffer.
+    if (release)
+        release(release_opaque, data, len);
+
 #ifdef SRT_ENABLE_ECN
     if (bCongestion)
     {
@@ -6844,6 +7157,88 @@ int CUDT::sendmsg2(const char *data, int len, SRT_MSGCTRL& w_mctrl)
     return size;
 }
 
+int CUDT::sendmmsg(SRT_MMSGHDR* msgs, int count)
+{
+    bool bCongestion = false;
+
+    if (m_bBroken || m_bClosing)
+        throw CUDTException(MJ_CONNECTION, MN_CONNLOST, 0);
+    else if (!m_bConnected || !m_CongCtl.ready())
+        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
+
+    // Every message must fit in the buffer as a whole.
+    if (!m_bMessageAPI)
+        throw CUDTException(MJ_NOTSUP, MN_INVALBUFFERAPI, 0);
+
+    if (count <= 0)
+        throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (msgs[i].len <= 0 || !msgs[i].buf)
+            throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+        checkSendArgs(msgs[i].buf, msgs[i].len, msgs[i].mctrl);
+        msgs[i].msg_len = 0;
+    }
+
+    UniqueLock sendguard(m_SendLock);
+
+    if (m_pSndBuffer->getCurrBufSize() == 0)
+    {
+        // delay the EXP timer to avoid mis-fired timeout
+        ScopedLock ack_lock(m_RecvAckLock);
+        m_tsLastRspAckTime = steady_clock::now();
+        m_iReXmitCount   = 1;
+    }
+
+    checkNeedDrop((bCongestion));
+
+    // Only the first message is waited for, the others
+    // are taken as long as they fit in the buffer.
+    if (!waitSndBufferSpace((msgs[0].len + m_iMaxSRTPayloadSize - 1) / m_iMaxSRTPayloadSize))
+        return 0;
+
+    if (m_pSndBuffer->getCurrBufSize() == 0)
+    {
+        ScopedLock lock(m_StatsLock);
+        m_stats.sndDurationCounter = steady_clock::now();
+    }
+
+    int n = 0;
+    {
+        ScopedLock recvAckLock(m_RecvAckLock);
+        for (; n < count; ++n)
+        {
+            const int minlen = (msgs[n].len + m_iMaxSRTPayloadSize - 1) / m_iMaxSRTPayloadSize;
+            if (sndBuffersLeft() < minlen)
+                break;
+
+            srt_send_release_fn* no_release = NULL;
+            scheduleMsg(msgs[n].buf, msgs[n].len, (msgs[n].mctrl), (no_release), NULL);
+            msgs[n].msg_len = msgs[n].len;
+        }
+
+        if (sndBuffersLeft() < 1)
+        {
+            // write is not available any more
+            s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, SRT_EPOLL_OUT, false);
+        }
+    }
+
+    m_pSndQueue->m_pSndUList->update(this, CSndUList::rescheduleIf(bCongestion));
+
+#ifdef SRT_ENABLE_ECN
+    if (bCongestion)
+    {
+        LOGC(dlog.Error, log << "sendmmsg: CONGESTION; reporting error");
+        throw CUDTException(MJ_AGAIN, MN_CONGESTION, 0);
+    }
+#endif /* SRT_ENABLE_ECN */
+
+    HLOGC(dlog.Debug, log << CONID() << "sock:SENDING (END): " << n << " of " << count << " messages");
+    return n;
+}
+
 int CUDT::recv(char* data, int len)
 {
     SRT_MSGCTRL mctrl = srt_msgctrl_default;
@@ -6884,12 +7279,188 @@ int CUDT::recvmsg2(char* data, int len, SRT_MSGCTRL& w_mctrl)
     return receiveBuffer(data, len);
 }
 
+int CUDT::recvmsgv(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl)
+{
+    if (m_parent->m_IncludedGroup && m_parent->m_IncludedGroup->isGroupReceiver())
+    {
+        LOGP(mglog.Error, "recv*: This socket is a receiver group member. Use group ID, NOT socket ID.");
+        throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
+    }
+
+    if (!m_bConnected || !m_CongCtl.ready())
+        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
+
+    // The segments are filled with a single message.
+    if (!m_bMessageAPI)
+        throw CUDTException(MJ_NOTSUP, MN_INVALBUFFERAPI, 0);
+
+    int len = 0;
+    for (int i = 0; i < iovcnt; ++i)
+    {
+        if (iov[i].len < 0 || (iov[i].len > 0 && !iov[i].buf))
+            throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+        len += iov[i].len;
+    }
+
+    if (len <= 0)
+    {
+        LOGC(dlog.Error, log << "Length of '" << len << "' supplied to srt_recvmsgv.");
+        throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+    }
+
+    return receiveMessage(iov, iovcnt, (w_mctrl));
+}
+
+int CUDT::recvmmsg(SRT_MMSGHDR* msgs, int count)
+{
+    if (m_parent->m_IncludedGroup && m_parent->m_IncludedGroup->isGroupReceiver())
+    {
+        LOGP(mglog.Error, "recv*: This socket is a receiver group member. Use group ID, NOT socket ID.");
+        throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
+    }
+
+    if (!m_bConnected || !m_CongCtl.ready())
+        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
+
+    if (count <= 0)
+        throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+    if (!m_bMessageAPI)
+        throw CUDTException(MJ_NOTSUP, MN_INVALBUFFERAPI, 0);
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (msgs[i].len <= 0)
+            throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+        if (!m_CongCtl->checkTransArgs(SrtCongestion::STA_MESSAGE, SrtCongestion::STAD_RECV, msgs[i].buf, msgs[i].len, SRT_MSGTTL_INF, false))
+            throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
+    }
+
+    // Wait for the first message as recvmsg2 does, then take
+    // those already ready without releasing the locks in between.
+    msgs[0].msg_len = recvmsg2(msgs[0].buf, msgs[0].len, (msgs[0].mctrl));
+    int n = 1;
+
+    UniqueLock recvguard (m_RecvLock);
+    CSync tscond     (m_RcvTsbPdCond,  recvguard);
+
+    enterCS(m_RcvBufferLock);
+    for (; n < count; ++n)
+    {
+        const int res = m_pRcvBuffer->readMsg(msgs[n].buf, msgs[n].len, (msgs[n].mctrl), -1);
+        if (res == 0)
+            break;
+        msgs[n].msg_len = res;
+    }
+    leaveCS(m_RcvBufferLock);
+
+    if (n > 1 && !m_pRcvBuffer->isRcvDataReady())
+    {
+        // Kick TsbPd thread to schedule next wakeup (if running)
+        if (m_bTsbPd)
+            tscond.signal_locked(recvguard);
+
+        s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, SRT_EPOLL_IN, false);
+    }
+
+    HLOGC(dlog.Debug, log << CONID() << "recvmmsg: received " << n << " messages");
+    return n;
+}
+
 // int by_exception: accepts values of CUDTUnited::ErrorHandling:
 // - 0 - by return value
 // - 1 - by exception
 // - 2 - by abort (unused)
 int CUDT::receiveMessage(char* data, int len, SRT_MSGCTRL& w_mctrl, int by_exception)
 {
+    const SRT_IOVEC seg = {data, len};
+    return receiveMessage(&seg, 1, (w_mctrl), by_exception);
+}
+
+int CUDT::recvmsgLoan(SRT_LOAN& w_loan, SRT_MSGCTRL& w_mctrl)
+{
+    if (m_parent->m_IncludedGroup && m_parent->m_IncludedGroup->isGroupReceiver())
+    {
+        LOGP(mglog.Error, "recv*: This socket is a receiver group member. Use group ID, NOT socket ID.");
+        throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
+    }
+
+    if (!m_bConnected || !m_CongCtl.ready())
+        throw CUDTException(MJ_CONNECTION, MN_NOCONN, 0);
+
+    // A loan covers a single unit, so only messages that always
+    // fit in one packet (live mode) can be loaned.
+    if (!m_bMessageAPI || !m_bTsbPd)
+        throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
+
+    // Fail before waiting for the data if no loan can be taken anyway.
+    {
+        ScopedLock bufferlock (m_RcvBufferLock);
+        checkLoanLimit();
+    }
+
+    return receiveMessage(NULL, 0, (w_mctrl), CUDTUnited::ERH_THROW, &w_loan);
+}
+
+void CUDT::returnLoan(SRT_LOAN& w_loan)
+{
+    CUnit* u = (CUnit*) w_loan.handle;
+
+    ScopedLock bufferlock (m_RcvBufferLock);
+    if (!u || !m_pRcvBuffer || !m_pRcvBuffer->returnLoan(u))
+        throw CUDTException(MJ_NOTSUP, MN_INVAL, 0);
+
+    w_loan.buf    = NULL;
+    w_loan.len    = 0;
+    w_loan.handle = NULL;
+
+    ScopedLock lock(m_StatsLock);
+    m_stats.rcvLoaned = m_pRcvBuffer->getLoanCount();
+}
+
+void CUDT::checkLoanLimit()
+{
+    if (m_pRcvBuffer->getLoanCount() < m_iRcvLoans)
+        return;
+
+    {
+        ScopedLock lock(m_StatsLock);
+        ++m_stats.rcvLoanRefusedTotal;
+    }
+
+    HLOGC(dlog.Debug, log << CONID() << "recvmsgLoan: " << m_iRcvLoans << " packets already loaned, REFUSED");
+    throw CUDTException(MJ_SYSTEMRES, MN_MEMORY, 0);
+}
+
+int CUDT::readRcvBuffer(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl, int upto, SRT_LOAN* w_loan)
+{
+    ScopedLock bufferlock (m_RcvBufferLock);
+    if (!w_loan)
+        return m_pRcvBuffer->readMsg(iov, iovcnt, (w_mctrl), upto);
+
+    // Checked again, other threads might have taken loans in the meantime.
+    checkLoanLimit();
+
+    CUnit* u = m_pRcvBuffer->loanMsg((w_mctrl), upto);
+    if (!u)
+        return 0;
+
+    w_loan->buf    = u->m_Packet.m_pcData;
+    w_loan->len    = (int) u->m_Packet.getLength();
+    w_loan->handle = u;
+
+    ScopedLock lock(m_StatsLock);
+    m_stats.rcvLoaned    = m_pRcvBuffer->getLoanCount();
+    m_stats.rcvLoanedMax = max(m_stats.rcvLoanedMax, m_stats.rcvLoaned);
+    return w_loan->len;
+}
+
+int CUDT::receiveMessage(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl, int by_exception, SRT_LOAN* w_loan)
+{
+    int len = 0;
+    for (int i = 0; i < iovcnt; ++i)
+        len += iov[i].len;
+
     // Recvmsg isn't restricted to the congctl type, it's the most
     // basic method of passing the data. You can retrieve data as
     // they come in, however you need to match the size of the buffer.
@@ -6901,7 +7472,8 @@ int CUDT::receiveMessage(char* data, int len, SRT_MSGCTRL& w_mctrl, int by_excep
     // is only used internally, we state that the problem that would be
     // handled by exception here should not happen, and in case if it does,
     // it's a bug to fix, so the exception is nothing wrong.
-    if (!m_CongCtl->checkTransArgs(SrtCongestion::STA_MESSAGE, SrtCongestion::STAD_RECV, data, len, SRT_MSGTTL_INF, false))
+    // A loan needs no buffer, it gets the packet as it is.
+    if (!w_loan && !m_CongCtl->checkTransArgs(SrtCongestion::STA_MESSAGE, SrtCongestion::STAD_RECV, iov[0].buf, len, SRT_MSGTTL_INF, false))
         throw CUDTException(MJ_NOTSUP, MN_INVALMSGAPI, 0);
 
     UniqueLock recvguard (m_RecvLock);
@@ -6923,9 +7495,8 @@ int CUDT::receiveMessage(char* data, int len, SRT_MSGCTRL& w_mctrl, int by_excep
     if (m_bBroken || m_bClosing)
     {
         HLOGC(mglog.Debug, log << CONID() << "receiveMessage: CONNECTION BROKEN - reading from recv buffer just for formality");
-        enterCS(m_RcvBufferLock);
-        int res       = m_pRcvBuffer->readMsg(data, len);
-        leaveCS(m_RcvBufferLock);
+        SRT_MSGCTRL ignored = srt_msgctrl_default;
+        int res = readRcvBuffer(iov, iovcnt, (ignored), -1, w_loan);
         w_mctrl.srctime = 0;
 
         // Kick TsbPd thread to schedule next wakeup (if running)
@@ -6963,9 +7534,7 @@ int CUDT::receiveMessage(char* data, int len, SRT_MSGCTRL& w_mctrl, int by_excep
     if (!m_bSynRecving)
     {
         HLOGC(dlog.Debug, log << CONID() << "receiveMessage: BEGIN ASYNC MODE. Going to extract payload size=" << len);
-        enterCS(m_RcvBufferLock);
-        const int res = m_pRcvBuffer->readMsg(data, len, (w_mctrl), seqdistance);
-        leaveCS(m_RcvBufferLock);
+        const int res = readRcvBuffer(iov, iovcnt, (w_mctrl), seqdistance, w_loan);
         HLOGC(dlog.Debug, log << CONID() << "AFTER readMsg: (NON-BLOCKING) result=" << res);
 
         if (res == 0)
@@ -7081,9 +7650,7 @@ int CUDT::receiveMessage(char* data, int len, SRT_MSGCTRL& w_mctrl, int by_excep
                 << " NMSG " << m_pRcvBuffer->getRcvMsgNum());
                 */
 
-        enterCS(m_RcvBufferLock);
-        res = m_pRcvBuffer->readMsg((data), len, (w_mctrl), seqdistance);
-        leaveCS(m_RcvBufferLock);
+        res = readRcvBuffer(iov, iovcnt, (w_mctrl), seqdistance, w_loan);
         HLOGC(dlog.Debug, log << CONID() << "AFTER readMsg: (BLOCKING) result=" << res);
 
         if (m_bBroken || m_bClosing)
@@ -7460,6 +8027,10 @@ void CUDT::bstats(CBytePerfMon *perf, bool clear, bool instantaneous)
         m_stats.rcvBytesDropTotal + (m_stats.rcvDropTotal * pktHdrSize) + m_stats.m_rcvBytesUndecryptTotal;
     perf->pktRcvUndecryptTotal  = m_stats.m_rcvUndecryptTotal;
     perf->byteRcvUndecryptTotal = m_stats.m_rcvBytesUndecryptTotal;
+
+    perf->pktRcvLoaned           = m_stats.rcvLoaned;
+    perf->pktRcvLoanedMax        = m_stats.rcvLoanedMax;
+    perf->pktRcvLoanRefusedTotal = m_stats.rcvLoanRefusedTotal;
     //<
 
     double interval = count_microseconds(currtime - m_stats.tsLastSampleTime);
@@ -7486,6 +8057,52 @@ void CUDT::bstats(CBytePerfMon *perf, bool clear, bool instantaneous)
 
     perf->mbpsBandwidth = Bps2Mbps(availbw * (m_iMaxSRTPayloadSize + pktHdrSize));
 
+    // Multiplexer statistics, shared by all sockets bound to the same UDP port.
+    if (m_pSndQueue)
+    {
+        m_pSndQueue->getBatchStats((perf->sndBatchCallsTotal), (perf->pktSndBatchTotal), (perf->sndBatchDepthMax),
+                (perf->pktSndGsoTotal), (perf->pktSndTxTimeTotal));
+        m_pSndQueue->getShardStats((perf->sndShard), (perf->sndShardSockets), (perf->usSndShardBusyTotal),
+                (perf->sndSched));
+    }
+    else
+    {
+        perf->sndBatchCallsTotal  = 0;
+        perf->pktSndBatchTotal    = 0;
+        perf->sndBatchDepthMax    = 0;
+        perf->pktSndGsoTotal      = 0;
+        perf->pktSndTxTimeTotal   = 0;
+        perf->sndShard            = 0;
+        perf->sndShardSockets     = 0;
+        perf->usSndShardBusyTotal = 0;
+        perf->sndSched            = SRT_SNDSCHED_HEAP;
+    }
+
+    if (m_pRcvQueue)
+    {
+        m_pRcvQueue->getBatchStats((perf->rcvBatchCallsTotal), (perf->pktRcvBatchTotal), (perf->rcvBatchDepthMax),
+                (perf->pktRcvGroTotal), (perf->pktRcvTimestampTotal));
+        m_pRcvQueue->m_UnitQueue.getPoolStats((perf->rcvUnitsAvail), (perf->rcvUnitsCapacity),
+                (perf->rcvUnitsGrowTotal), (perf->byteRcvUnitsReleasedTotal));
+        m_pRcvQueue->getTimerStats((perf->timerChecksTotal), (perf->timerChecksRate));
+        perf->rcvShard = m_pRcvQueue->m_iShard;
+    }
+    else
+    {
+        perf->rcvBatchCallsTotal = 0;
+        perf->pktRcvBatchTotal   = 0;
+        perf->rcvBatchDepthMax   = 0;
+        perf->pktRcvGroTotal     = 0;
+        perf->pktRcvTimestampTotal = 0;
+        perf->rcvUnitsAvail      = 0;
+        perf->rcvUnitsCapacity   = 0;
+        perf->rcvUnitsGrowTotal  = 0;
+        perf->byteRcvUnitsReleasedTotal = 0;
+        perf->timerChecksTotal   = 0;
+        perf->timerChecksRate    = 0;
+        perf->rcvShard           = 0;
+    }
+
     if (tryEnterCS(m_ConnectionLock))
     {
         if (m_pSndBuffer)
@@ -8151,6 +8768,8 @@ void CUDT::sendCtrl(UDTMessageType pkttype, const int32_t* lparam, void* rparam,
 
 void CUDT::updateSndLossListOnACK(int32_t ackdata_seqno)
 {
+    std::vector<CSndRelease> released;
+
     // Update sender's loss list and acknowledge packets in the sender's buffer
     {
         // m_RecvAckLock protects sender's loss list and epoll
@@ -8178,13 +8797,16 @@ void CUDT::updateSndLossListOnACK(int32_t ackdata_seqno)
         m_pSndLossList->removeUpTo(CSeqNo::decseq(m_iSndLastDataAck));
 
         // acknowledge the sending buffer (remove data that predate 'ack')
-        m_pSndBuffer->ackData(offset);
+        m_pSndBuffer->ackData(offset, (released));
 
         // acknowledde any waiting epolls to write
         s_UDTUnited.m_EPoll.update_events(m_SocketID, m_sPollID, SRT_EPOLL_OUT, true);
         CGlobEvent::triggerEvent();
     }
 
+    // Out of the lock, as the application may send again from there.
+    m_pSndQueue->release(released);
+
     // insert this socket to snd list if it is not on the list yet
     m_pSndQueue->m_pSndUList->update(this, CSndUList::DONT_RESCHEDULE);
 
@@ -8575,15 +9197,16 @@ void CUDT::processCtrl(const CPacket &ctrlpkt)
         updateCC(TEV_ACKACK, ack);
 
         // This function will put a lock on m_RecvLock by itself, as needed.
-        // It must be done inside because this function reads the current time
-        // and if waiting for the lock has caused a delay, the time will be
-        // inaccurate. Additionally it won't lock if TSBPD mode is off, and
-        // won't update anything. Note that if you set TSBPD mode and use
+        // The sample is taken at the arrival time of the ACKACK, so that
+        // neither the queueing in the receiving thread nor waiting for the
+        // lock makes it inaccurate. Additionally it won't lock if TSBPD mode
+        // is off, and won't update anything. Note that if you set TSBPD mode and use
         // srt_recvfile (which doesn't make any sense), you'll have a deadlock.
         steady_clock::duration udrift(0);
         steady_clock::time_point newtimebase;
-        const bool drift_updated = m_pRcvBuffer->addRcvTsbPdDriftSample(ctrlpkt.getMsgTimeStamp(), m_RecvLock,
-                (udrift), (newtimebase));
+        const steady_clock::time_point arrival = is_zero(ctrlpkt.m_tsArrival) ? currtime : ctrlpkt.m_tsArrival;
+        const bool drift_updated = m_pRcvBuffer->addRcvTsbPdDriftSample(ctrlpkt.getMsgTimeStamp(), arrival,
+                m_RecvLock, (udrift), (newtimebase));
         if (drift_updated && m_parent->m_IncludedGroup)
         {
             m_parent->m_IncludedGroup->synchronizeDrift(this, udrift, newtimebase);
@@ -9035,7 +9658,7 @@ int CUDT::packLostData(CPacket& w_packet, steady_clock::time_point& w_origintime
     return 0;
 }
 
-std::pair<int, steady_clock::time_point> CUDT::packData(CPacket& w_packet)
+std::pair<int, steady_clock::time_point> CUDT::packData(CPacket& w_packet, const steady_clock::time_point& departure)
 {
     int payload = 0;
     bool probe = false;
@@ -9045,7 +9668,9 @@ std::pair<int, steady_clock::time_point> CUDT::packData(CPacket& w_packet)
 
     int kflg = EK_NOENC;
 
-    const steady_clock::time_point enter_time = steady_clock::now();
+    // The next sending time is counted from the departure of this packet,
+    // so that packets packed in advance keep the pacing of the socket.
+    const steady_clock::time_point enter_time = departure;
 
     if (!is_zero(m_tsNextSendTime) && enter_time > m_tsNextSendTime)
         m_tdSendTimeDiff += enter_time - m_tsNextSendTime;
@@ -9509,7 +10134,10 @@ int CUDT::processData(CUnit* in_unit)
     // make sure that this packet isn't going to be
     // effectively discarded, as repeated retransmission,
     // for example, burdens the link, but doesn't better the speed.
-    m_RcvTimeWindow.onPktArrival(pktsz);
+    // The receiver queue sets the arrival time of every packet; use the
+    // current time only if it's unknown.
+    const steady_clock::time_point arrival = is_zero(packet.m_tsArrival) ? steady_clock::now() : packet.m_tsArrival;
+    m_RcvTimeWindow.onPktArrival(pktsz, arrival);
 
     // Probe the packet pair if needed.
     // Conditions and any extra data required for the packet
@@ -9521,7 +10149,7 @@ int CUDT::processData(CUnit* in_unit)
     // Retransmitted and unordered packets do not provide expected measurement.
     // We expect the 16th and 17th packet to be sent regularly,
     // otherwise measurement must be rejected.
-    m_RcvTimeWindow.probeArrival(packet, unordered || retransmitted);
+    m_RcvTimeWindow.probeArrival(packet, unordered || retransmitted, arrival);
 
     enterCS(m_StatsLock);
     m_stats.traceBytesRecv += pktsz;
@@ -10418,7 +11046,7 @@ int32_t CUDT::bake(const sockaddr_any& addr, int32_t current_cookie, int correct
 //
 // XXX Make this function return EConnectStatus enum type (extend if needed),
 // and this will be directly passed to the caller.
-int CUDT::processConnectRequest(const sockaddr_any& addr, CPacket& packet)
+int CUDT::processConnectRequest(const sockaddr_any& addr, CPacket& packet, CRcvQueue* rcvq)
 {
     // XXX ASSUMPTIONS:
     // [[using assert(packet.m_iID == 0)]]
@@ -10616,7 +11244,7 @@ int CUDT::processConnectRequest(const sockaddr_any& addr, CPacket& packet)
     else
     {
         int error  = SRT_REJ_UNKNOWN;
-        int result = s_UDTUnited.newConnection(m_SocketID, addr, packet, (hs), (error));
+        int result = s_UDTUnited.newConnection(m_SocketID, addr, packet, rcvq, (hs), (error));
 
         // This is listener - m_RejectReason need not be set
         // because listener has no functionality of giving the app
@@ -10799,24 +11427,7 @@ bool CUDT::checkExpTimer(const steady_clock::time_point& currtime, int check_rea
     HLOGC(mglog.Debug, log << CONID() << "checkTimer: ACTIVITIES PERFORMED: " << decision);
 #endif
 
-    // In UDT the m_bUserDefinedRTO and m_iRTO were in CCC class.
-    // There's nothing in the original code that alters these values.
-
-    steady_clock::time_point next_exp_time;
-    if (m_CongCtl->RTO())
-    {
-        next_exp_time = m_tsLastRspTime + microseconds_from(m_CongCtl->RTO());
-    }
-    else
-    {
-        steady_clock::duration exp_timeout =
-            microseconds_from(m_iEXPCount * (m_iRTT + 4 * m_iRTTVar) + COMM_SYN_INTERVAL_US);
-        if (exp_timeout < (m_iEXPCount * m_tdMinExpInterval))
-            exp_timeout = m_iEXPCount * m_tdMinExpInterval;
-        next_exp_time = m_tsLastRspTime + exp_timeout;
-    }
-
-    if (currtime <= next_exp_time)
+    if (currtime <= getExpTime())
         return false;
 
     // ms -> us
@@ -10890,10 +11501,7 @@ void CUDT::checkRexmitTimer(const steady_clock::time_point& currtime)
      * in the sender's buffer will be added to loss list and retransmitted.
      */
 
-    const uint64_t rtt_syn = (m_iRTT + 4 * m_iRTTVar + 2 * COMM_SYN_INTERVAL_US);
-    const uint64_t exp_int_us = (m_iReXmitCount * rtt_syn + COMM_SYN_INTERVAL_US);
-
-    if (currtime <= (m_tsLastRspAckTime + microseconds_from(exp_int_us)))
+    if (currtime <= getRexmitTime())
         return;
 
     // If there is no unacknowledged data in the sending buffer,
@@ -10997,6 +11605,51 @@ void CUDT::checkTimers()
     }
 }
 
+steady_clock::time_point CUDT::getExpTime()
+{
+    // In UDT the m_bUserDefinedRTO and m_iRTO were in CCC class.
+    // There's nothing in the original code that alters these values.
+
+    if (m_CongCtl->RTO())
+        return m_tsLastRspTime + microseconds_from(m_CongCtl->RTO());
+
+    steady_clock::duration exp_timeout =
+        microseconds_from(m_iEXPCount * (m_iRTT + 4 * m_iRTTVar) + COMM_SYN_INTERVAL_US);
+    if (exp_timeout < (m_iEXPCount * m_tdMinExpInterval))
+        exp_timeout = m_iEXPCount * m_tdMinExpInterval;
+    return m_tsLastRspTime + exp_timeout;
+}
+
+steady_clock::time_point CUDT::getRexmitTime()
+{
+    const uint64_t rtt_syn = (m_iRTT + 4 * m_iRTTVar + 2 * COMM_SYN_INTERVAL_US);
+    const uint64_t exp_int_us = (m_iReXmitCount * rtt_syn + COMM_SYN_INTERVAL_US);
+
+    return m_tsLastRspAckTime + microseconds_from(exp_int_us);
+}
+
+steady_clock::time_point CUDT::getNextTimerTime(const steady_clock::time_point& currtime)
+{
+    steady_clock::time_point next_time = m_tsLastSndTime + microseconds_from(COMM_KEEPALIVE_PERIOD_US);
+    next_time = std::min(next_time, getExpTime());
+
+    // An ACK is sent, and then repeated, until the peer confirms it with ACKACK.
+    const int loss_len = m_pRcvLossList->getLossLength();
+    const int32_t ack = loss_len == 0 ? CSeqNo::incseq(m_iRcvCurrSeqNo) : m_pRcvLossList->getFirstLostSeq();
+    if (ack != m_iRcvLastAckAck)
+        next_time = std::min(next_time, m_tsNextACKTime);
+
+    if (loss_len > 0 && m_bRcvNakReport && m_PktFilterRexmitLevel == SRT_ARQ_ALWAYS)
+        next_time = std::min(next_time, m_tsNextNAKTime);
+
+    if (m_pSndBuffer->getCurrBufSize() > 0)
+        next_time = std::min(next_time, getRexmitTime());
+
+    const steady_clock::time_point earliest = currtime + microseconds_from(COMM_SYN_INTERVAL_US);
+    const steady_clock::time_point latest   = currtime + microseconds_from(COMM_TIMER_MAX_INTERVAL_US);
+    return std::max(earliest, std::min(latest, next_time));
+}
+
 void CUDT::addEPoll(const int eid)
 {
     enterCS(s_UDTUnited.m_EPoll.m_EPollLock);
@@ -11181,6 +11834,67 @@ int64_t CUDT::socketStartTime(SRTSOCKET u)
     return count_microseconds(s->m_pUDT->m_stats.tsStartTime.time_since_epoch());
 }
 
+CRcvQueue* CUDT::polledRcvQueue(SRTSOCKET u)
+{
+    CUDTSocket* s = s_UDTUnited.locateSocket(u);
+    if (!s || !s->m_pUDT)
+        throw CUDTException(MJ_NOTSUP, MN_SIDINVAL, 0);
+
+    CRcvQueue* q = s->m_pUDT->m_pRcvQueue;
+    if (!q)
+        throw CUDTException(MJ_NOTSUP, MN_ISUNBOUND, 0);
+
+    if (!q->isPolled())
+        throw CUDTException(MJ_NOTSUP, MN_NONE, 0);
+
+    return q;
+}
+
+int CUDT::muxFd(SRTSOCKET u, SYSSOCKET* fd)
+{
+    try
+    {
+        CRcvQueue* q = polledRcvQueue(u);
+        if (!fd)
+            return APIError(MJ_NOTSUP, MN_INVAL);
+
+        *fd = q->m_pChannel->getSocket();
+        return 0;
+    }
+    catch (const CUDTException& e)
+    {
+        return APIError(e);
+    }
+}
+
+int CUDT::muxProcess(SRTSOCKET u)
+{
+    try
+    {
+        const int received = polledRcvQueue(u)->process();
+        if (received < 0)
+            return APIError(MJ_CONNECTION, MN_CONNLOST);
+        return received;
+    }
+    catch (const CUDTException& e)
+    {
+        return APIError(e);
+    }
+}
+
+int64_t CUDT::muxNextDeadline(SRTSOCKET u)
+{
+    try
+    {
+        const steady_clock::time_point deadline = polledRcvQueue(u)->nextDeadline();
+        return count_microseconds(deadline.time_since_epoch());
+    }
+    catch (const CUDTException& e)
+    {
+        return APIError(e);
+    }
+}
+
 bool CUDT::runAcceptHook(CUDT *acore, const sockaddr* peer, const CHandShake& hs, const CPacket& hspkt)
 {
     // Prepare the information for the hook.
@@ -11620,6 +12334,21 @@ void CUDTGroup::deriveSettings(CUDT* u)
     IM(SRTO_LINGER, m_Linger);
     IM(SRTO_UDP_SNDBUF, m_iUDPSndBufSize);
     IM(SRTO_UDP_RCVBUF, m_iUDPRcvBufSize);
+    IM(SRTO_UDP_SNDBATCH, m_iUDPSndBatch);
+    IM(SRTO_UDP_RCVBATCH, m_iUDPRcvBatch);
+    IM(SRTO_UDP_GSO, m_bUDPGSO);
+    IM(SRTO_UDP_GRO, m_bUDPGRO);
+    IM(SRTO_UDP_RCVSHARDS, m_iUDPRcvShards);
+    IM(SRTO_UDP_SNDSHARDS, m_iUDPSndShards);
+    IM(SRTO_UDP_IOURING, m_bUDPIOUring);
+    IM(SRTO_UDP_TXTIME, m_bUDPTxTime);
+    IM(SRTO_UDP_TIMESTAMP, m_bUDPTimestamp);
+    IM(SRTO_UDP_RCVPOOLHOLD, m_iUDPRcvPoolHold);
+    IM(SRTO_BUFALLOC, m_iBufAlloc);
+    IM(SRTO_UDP_SNDSCHED, m_iUDPSndSched);
+    IM(SRTO_UDP_SINGLETHREAD, m_bUDPSingleThread);
+    IM(SRTO_UDP_NOTHREADS, m_bUDPNoThreads);
+    IM(SRTO_RCVLOANS, m_iRcvLoans);
     // SRTO_RENDEZVOUS: impossible to have it set on a listener socket.
     // SRTO_SNDTIMEO/RCVTIMEO: groupwise setting
     IM(SRTO_CONNTIMEO, m_tdConnTimeOut);
@@ -11763,6 +12492,21 @@ static bool getOptDefault(SRT_SOCKOPT optname, void* pw_optval, int& w_optlen)
     case SRTO_LINGER: RD(def_linger);
     case SRTO_UDP_SNDBUF:
     case SRTO_UDP_RCVBUF:  RD(CUDT::DEF_UDP_BUFFER_SIZE);
+    case SRTO_UDP_SNDBATCH:
+    case SRTO_UDP_RCVBATCH:
+    case SRTO_UDP_RCVSHARDS:
+    case SRTO_UDP_SNDSHARDS: RD(1);
+    case SRTO_UDP_GSO:
+    case SRTO_UDP_GRO:
+    case SRTO_UDP_IOURING:
+    case SRTO_UDP_TXTIME:
+    case SRTO_UDP_TIMESTAMP: RD(false);
+    case SRTO_UDP_RCVPOOLHOLD: RD(CUDT::DEF_UDP_RCVPOOLHOLD);
+    case SRTO_BUFALLOC: RD(SRT_BUFALLOC_DEFAULT);
+    case SRTO_UDP_SNDSCHED: RD(SRT_SNDSCHED_HEAP);
+    case SRTO_UDP_SINGLETHREAD: RD(false);
+    case SRTO_UDP_NOTHREADS: RD(false);
+    case SRTO_RCVLOANS: RD(CUDT::DEF_RCV_LOANS);
     case SRTO_RENDEZVOUS: RD(false);
     case SRTO_SNDTIMEO: RD(-1);
     case SRTO_RCVTIMEO: RD(-1);
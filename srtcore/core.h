@@ -952,7 +952,14 @@ public: //API
     static int sendmsg(SRTSOCKET u, const char* buf, int len, int ttl = SRT_MSGTTL_INF, bool inorder = false, int64_t srctime = 0);
     static int recvmsg(SRTSOCKET u, char* buf, int len, int64_t& srctime);
     static int sendmsg2(SRTSOCKET u, const char* buf, int len, SRT_MSGCTRL& mctrl);
+    static int sendmsg_zc(SRTSOCKET u, const char* buf, int len, SRT_MSGCTRL& mctrl,
+                          srt_send_release_fn* release, void* release_opaque);
+    static int sendmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count);
     static int recvmsg2(SRTSOCKET u, char* buf, int len, SRT_MSGCTRL& w_mctrl);
+    static int recvmsgv(SRTSOCKET u, const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl);
+    static int recvmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count);
+    static int recvmsg_loan(SRTSOCKET u, SRT_LOAN& w_loan, SRT_MSGCTRL& w_m);
+    static int loan_return(SRTSOCKET u, SRT_LOAN& w_loan);
     static int64_t sendfile(SRTSOCKET u, std::fstream& ifs, int64_t& offset, int64_t size, int block = SRT_DEFAULT_SENDFILE_BLOCK);
     static int64_t recvfile(SRTSOCKET u, std::fstream& ofs, int64_t& offset, int64_t size, int block = SRT_DEFAULT_RECVFILE_BLOCK);
     static int select(int nfds, UDT::UDSET* readfds, UDT::UDSET* writefds, UDT::UDSET* exceptfds, const timeval* timeout);
@@ -980,6 +987,9 @@ public: //API
     static int rejectReason(SRTSOCKET s);
     static int rejectReason(SRTSOCKET s, int value);
     static int64_t socketStartTime(SRTSOCKET s);
+    static int muxFd(SRTSOCKET u, SYSSOCKET* fd);
+    static int muxProcess(SRTSOCKET u);
+    static int64_t muxNextDeadline(SRTSOCKET u);
 
 public: // internal API
     // This is public so that it can be used directly in API implementation functions.
@@ -1010,6 +1020,9 @@ public: // internal API
     static const int SRT_TLPKTDROP_MINTHRESHOLD_MS = 1000;
     static const uint64_t COMM_KEEPALIVE_PERIOD_US = 1*1000*1000;
     static const int32_t COMM_SYN_INTERVAL_US = 10*1000;
+    // Longest time the timers of a connected socket go unchecked, well below
+    // the 1 second a closed socket waits before it's taken off the queues.
+    static const int32_t COMM_TIMER_MAX_INTERVAL_US = 250*1000;
     static const int COMM_CLOSE_BROKEN_LISTENER_TIMEOUT_MS = 3000;
 
     static const int
@@ -1018,6 +1031,8 @@ public: // internal API
         DEF_BUFFER_SIZE = 8192, //Rcv buffer MUST NOT be bigger than Flight Flag size
         DEF_LINGER_S = 3*60,  // 3 minutes
         DEF_UDP_BUFFER_SIZE = 65536,
+        DEF_UDP_RCVPOOLHOLD = 10000, // 10 seconds
+        DEF_RCV_LOANS = 256,
         DEF_CONNTIMEO_S = 3; // 3 seconds
 
 
@@ -1231,6 +1246,22 @@ private:
     void updateIdleLinkFrom(CUDT* source);
 
     void checkNeedDrop(bool& bCongestion);
+    void checkSendArgs(const char* data, int len, const SRT_MSGCTRL& mctrl);
+    bool waitSndBufferSpace(int minlen);
+
+    /// Add a message to the sender buffer, with m_RecvAckLock held.
+    /// @param w_release [in/out] set to NULL if the data are referenced by the buffer.
+    /// @return false if the message was not added, as already sent over the group.
+    bool scheduleMsg(const char* data, int size, SRT_MSGCTRL& w_mctrl,
+                     srt_send_release_fn*& w_release, void* release_opaque);
+
+    /// Read a message from the receiver buffer into the segments or, if
+    /// w_loan is given, loan the unit holding it.
+    /// @return size of the message or 0 if none is ready.
+    int readRcvBuffer(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_mctrl, int upto, SRT_LOAN* w_loan);
+
+    /// Throw SRT_ENOBUF if SRTO_RCVLOANS packets are already loaned, with m_RcvBufferLock held.
+    void checkLoanLimit();
 
     /// Connect to a UDT entity listening at address "peer", which has sent "hs" request.
     /// @param peer [in] The address of the listening UDT entity.
@@ -1274,11 +1305,19 @@ private:
     /// @param len [in] size of the buffer.
     /// @return Actual size of data received.
 
-    SRT_ATR_NODISCARD int sendmsg2(const char* data, int len, SRT_MSGCTRL& w_m);
+    SRT_ATR_NODISCARD int sendmsg2(const char* data, int len, SRT_MSGCTRL& w_m,
+                                   srt_send_release_fn* release = NULL, void* release_opaque = NULL);
+    SRT_ATR_NODISCARD int sendmmsg(SRT_MMSGHDR* msgs, int count);
 
     SRT_ATR_NODISCARD int recvmsg(char* data, int len, int64_t& srctime);
     SRT_ATR_NODISCARD int recvmsg2(char* data, int len, SRT_MSGCTRL& w_m);
+    SRT_ATR_NODISCARD int recvmsgv(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_m);
+    SRT_ATR_NODISCARD int recvmmsg(SRT_MMSGHDR* msgs, int count);
     SRT_ATR_NODISCARD int receiveMessage(char* data, int len, SRT_MSGCTRL& w_m, int erh = 1 /*throw exception*/);
+    SRT_ATR_NODISCARD int receiveMessage(const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL& w_m, int erh = 1 /*throw exception*/,
+            SRT_LOAN* w_loan = NULL);
+    SRT_ATR_NODISCARD int recvmsgLoan(SRT_LOAN& w_loan, SRT_MSGCTRL& w_m);
+    void returnLoan(SRT_LOAN& w_loan);
     SRT_ATR_NODISCARD int receiveBuffer(char* data, int len);
 
     size_t dropMessage(int32_t seqtoskip);
@@ -1403,6 +1442,21 @@ private: // Identification
     linger m_Linger;                             // Linger information on close
     int m_iUDPSndBufSize;                        // UDP sending buffer size
     int m_iUDPRcvBufSize;                        // UDP receiving buffer size
+    int m_iUDPSndBatch;                          // maximum number of packets sent in one system call
+    int m_iUDPRcvBatch;                          // maximum number of packets received in one system call
+    bool m_bUDPGSO;                              // UDP segmentation offload for batched sending
+    bool m_bUDPGRO;                              // UDP receive offload
+    int m_iUDPRcvShards;                         // number of receiving sockets on the port of a listener
+    int m_iUDPSndShards;                         // number of sending workers of the multiplexer
+    bool m_bUDPIOUring;                          // io_uring for the UDP socket
+    bool m_bUDPTxTime;                           // kernel pacing of the sent packets (SO_TXTIME)
+    bool m_bUDPTimestamp;                        // arrival time of the received packets from the system (SO_TIMESTAMPNS)
+    int m_iUDPRcvPoolHold;                       // time in ms the receiver units must be unused before they are released
+    int m_iBufAlloc;                             // allocation policy for the payload memory (SRT_BUFALLOC)
+    int m_iUDPSndSched;                          // scheduler of the sockets in the sending threads (SRT_SNDSCHED)
+    bool m_bUDPSingleThread;                     // one thread of the multiplexer both receives and sends
+    bool m_bUDPNoThreads;                        // the multiplexer has no threads, the application drives it
+    int m_iRcvLoans;                             // maximum number of received packets loaned to the application at a time
     bool m_bRendezvous;                          // Rendezvous connection mode
 
     duration m_tdConnTimeOut;    // connect timeout in milliseconds
@@ -1690,12 +1744,14 @@ private: // Generation and processing of packets
     /// Pack in CPacket the next data to be send.
     ///
     /// @param packet [in, out] a CPacket structure to fill
+    /// @param departure [in] time when the packet leaves: now, or later if the
+    ///        kernel paces the sending (SRTO_UDP_TXTIME) and it's packed in advance
     ///
     /// @return A pair of values is returned (payload, timestamp).
     ///         The payload tells the size of the payload, packed in CPacket.
     ///         The timestamp is the full source/origin timestamp of the data.
     ///         If payload is <= 0, consider the timestamp value invalid.
-    std::pair<int, time_point> packData(CPacket& packet);
+    std::pair<int, time_point> packData(CPacket& packet, const time_point& departure);
 
     int processData(CUnit* unit);
     void processClose();
@@ -1706,8 +1762,9 @@ private: // Generation and processing of packets
     /// modify the object permanently.
     /// @param addr source address from where the request came
     /// @param packet contents of the packet
+    /// @param rcvq receive queue that got the request, which will also serve the new connection
     /// @return URQ code, possibly containing reject reason
-    int processConnectRequest(const sockaddr_any& addr, CPacket& packet);
+    int processConnectRequest(const sockaddr_any& addr, CPacket& packet, CRcvQueue* rcvq);
     static void addLossRecord(std::vector<int32_t>& lossrecord, int32_t lo, int32_t hi);
     int32_t bake(const sockaddr_any& addr, int32_t previous_cookie = 0, int correction = 0);
     int32_t ackDataUpTo(int32_t seq);
@@ -1748,6 +1805,10 @@ private: // Trace
 
         int64_t m_sndDurationTotal;         // total real time for sending
 
+        int rcvLoaned;                      // number of received packets currently loaned to the application
+        int rcvLoanedMax;                   // highest number of received packets loaned at a time
+        int64_t rcvLoanRefusedTotal;        // total number of loans refused because of SRTO_RCVLOANS
+
         time_point tsLastSampleTime;            // last performance sample time
         int64_t traceSent;                  // number of packets sent in the last trace interval
         int64_t traceSentUniq;              // number of original packets sent in the last trace interval
@@ -1804,6 +1865,14 @@ private: // Timers functions
                      LAST_BECAUSE_BIT  =      3;
 
     void checkTimers();
+
+    /// Time when checkTimers() has something to do next, unless a packet
+    /// arrives earlier: kept within COMM_SYN_INTERVAL_US and
+    /// COMM_TIMER_MAX_INTERVAL_US from the current time.
+    time_point getNextTimerTime(const time_point& currtime);
+
+    time_point getExpTime();
+    time_point getRexmitTime();
     void considerLegacySrtHandshake(const time_point &timebase);
     int checkACKTimer (const time_point& currtime);
     int checkNAKTimer(const time_point& currtime);
@@ -1824,6 +1893,9 @@ private: // for UDP multiplexer
     CSNode* m_pSNode;               // node information for UDT list used in snd queue
     CRNode* m_pRNode;               // node information for UDT list used in rcv queue
 
+    // The receiving queue of the socket's multiplexer, if the application drives it
+    static CRcvQueue* polledRcvQueue(SRTSOCKET u);
+
 public: // For SrtCongestion
     const CSndQueue* sndQueue() { return m_pSndQueue; }
     const CRcvQueue* rcvQueue() { return m_pRcvQueue; }
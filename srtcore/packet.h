@@ -396,6 +396,10 @@ public:
    int32_t& m_iID;                      // alias: socket ID
    char*& m_pcData;                     // alias: data/control information
 
+   // Time when the packet was received: as reported by the system if
+   // available (SRTO_UDP_TIMESTAMP), otherwise when it was read.
+   srt::sync::steady_clock::time_point m_tsArrival;
+
    // Experimental: sometimes these references don't work!
    char* getData();
    char* release();
@@ -59,7 +59,7 @@ void PacketFilter::receive(CUnit* unit, std::vector<CUnit*>& w_incoming, loss_se
     {
         // For the sake of rebuilding MARK THIS UNIT GOOD, otherwise the
         // unit factory will supply it from getNextAvailUnit() as if it were not in use.
-        unit->m_iFlag = CUnit::GOOD;
+        m_unitq->makeUnitGood(unit);
         HLOGC(mglog.Debug, log << "FILTER: PASSTHRU current packet %" << unit->m_Packet.getSeqNo());
         w_incoming.push_back(unit);
     }
@@ -109,12 +109,12 @@ void PacketFilter::receive(CUnit* unit, std::vector<CUnit*>& w_incoming, loss_se
     // buffer to decide as to whether it wants them or not.
     // Wanted units will be set GOOD flag, unwanted will remain
     // with FREE and therefore will be returned at the next
-    // call to getNextAvailUnit().
-    unit->m_iFlag = CUnit::FREE;
+    // call to getNextAvailUnit(). The current unit is among
+    // them if it was passed through, otherwise it's still free.
     for (vector<CUnit*>::iterator i = w_incoming.begin(); i != w_incoming.end(); ++i)
     {
         CUnit* u = *i;
-        u->m_iFlag = CUnit::FREE;
+        m_unitq->makeUnitFree(u);
     }
 
     // Packets must be sorted by sequence number, ascending, in order
@@ -185,7 +185,7 @@ void PacketFilter::InsertRebuilt(vector<CUnit*>& incoming, CUnitQueue* uq)
 
         // LOCK the unit as GOOD because otherwise the next
         // call to getNextAvailUnit will return THE SAME UNIT.
-        u->m_iFlag = CUnit::GOOD;
+        uq->makeUnitGood(u);
         // After returning from this function, all units will be
         // set back to FREE so that the buffer can decide whether
         // it wants them or not.
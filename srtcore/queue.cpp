@@ -52,7 +52,9 @@ modified by
 
 #include "platform_sys.h"
 
+#include <algorithm>
 #include <cstring>
+#include <new>
 
 #include "common.h"
 #include "api.h"
@@ -60,6 +62,7 @@ modified by
 #include "threadname.h"
 #include "logging.h"
 #include "queue.h"
+#include "bufalloc.h"
 
 using namespace std;
 using namespace srt::sync;
@@ -67,12 +70,18 @@ using namespace srt_logging;
 
 CUnitQueue::CUnitQueue()
     : m_pQEntry(NULL)
-    , m_pCurrQueue(NULL)
     , m_pLastQueue(NULL)
+    , m_pFreeHead(NULL)
     , m_iSize(0)
     , m_iCount(0)
+    , m_llGrowTotal(0)
+    , m_llReleasedBytes(0)
+    , m_tdHoldDown(seconds_from(-1))
+    , m_tsNextShrinkCheck()
     , m_iMSS()
     , m_iIPversion()
+    , m_iBufAlloc(SRT_BUFALLOC_DEFAULT)
+    , m_iNumaNode(-1)
 {
 }
 
@@ -83,7 +92,7 @@ CUnitQueue::~CUnitQueue()
     while (p != NULL)
     {
         delete[] p->m_pUnit;
-        delete[] p->m_pBuffer;
+        srt::freePayloadBuffer(p->m_pBuffer, size_t(p->m_iSize) * m_iMSS, m_iBufAlloc);
 
         CQEntry *q = p;
         if (p == m_pLastQueue)
@@ -100,34 +109,47 @@ int CUnitQueue::init(int size, int mss, int version)
     CUnit *  tempu = NULL;
     char *   tempb = NULL;
 
+    // The units of the following blocks are placed on
+    // the same node as the first ones.
+    if (m_iBufAlloc == SRT_BUFALLOC_HUGEPAGES_NUMA)
+        m_iNumaNode = srt::currentNumaNode();
+
+    // With huge pages a block takes whole pages.
+    size = srt::roundPayloadCount(size, mss, m_iBufAlloc);
+
     try
     {
         tempq = new CQEntry;
         tempu = new CUnit[size];
-        tempb = new char[size * mss];
+        tempb = srt::allocPayloadBuffer(size_t(size) * mss, m_iBufAlloc, m_iNumaNode);
+        if (!tempb)
+            throw std::bad_alloc();
     }
     catch (...)
     {
         delete tempq;
         delete[] tempu;
-        delete[] tempb;
 
         return -1;
     }
 
-    for (int i = 0; i < size; ++i)
+    // Push in reverse order, so that the units are handed out
+    // starting from the beginning of the block.
+    for (int i = size - 1; i >= 0; --i)
     {
         tempu[i].m_iFlag           = CUnit::FREE;
         tempu[i].m_Packet.m_pcData = tempb + i * mss;
+        tempu[i].m_pEntry          = tempq;
+        pushFree(&tempu[i]);
     }
-    tempq->m_pUnit   = tempu;
-    tempq->m_pBuffer = tempb;
-    tempq->m_iSize   = size;
-
-    m_pQEntry = m_pCurrQueue = m_pLastQueue = tempq;
-    m_pQEntry->m_pNext                      = m_pQEntry;
+    tempq->m_pUnit       = tempu;
+    tempq->m_pBuffer     = tempb;
+    tempq->m_iSize       = size;
+    tempq->m_iUsed       = 0;
+    tempq->m_tsFreeSince = steady_clock::now();
 
-    m_pAvailUnit = m_pCurrQueue->m_pUnit;
+    m_pQEntry = m_pLastQueue = tempq;
+    m_pQEntry->m_pNext       = m_pQEntry;
 
     m_iSize      = size;
     m_iMSS       = mss;
@@ -136,26 +158,16 @@ int CUnitQueue::init(int size, int mss, int version)
     return 0;
 }
 
-// XXX Lots of common code with CUnitQueue:init.
-// Consider merging.
 int CUnitQueue::increase()
 {
-    // adjust/correct m_iCount
-    int      real_count = 0;
-    CQEntry *p          = m_pQEntry;
-    while (p != NULL)
-    {
-        CUnit *u = p->m_pUnit;
-        for (CUnit *end = u + p->m_iSize; u != end; ++u)
-            if (u->m_iFlag != CUnit::FREE)
-                ++real_count;
+    ScopedLock lg(m_FreeLock);
+    return increase_LOCKED();
+}
 
-        if (p == m_pLastQueue)
-            p = NULL;
-        else
-            p = p->m_pNext;
-    }
-    m_iCount = real_count;
+// XXX Lots of common code with CUnitQueue:init.
+// Consider merging.
+int CUnitQueue::increase_LOCKED()
+{
     if (double(m_iCount) / m_iSize < 0.9)
         return -1;
 
@@ -170,13 +182,14 @@ int CUnitQueue::increase()
     {
         tempq = new CQEntry;
         tempu = new CUnit[size];
-        tempb = new char[size * m_iMSS];
+        tempb = srt::allocPayloadBuffer(size_t(size) * m_iMSS, m_iBufAlloc, m_iNumaNode);
+        if (!tempb)
+            throw std::bad_alloc();
     }
     catch (...)
     {
         delete tempq;
         delete[] tempu;
-        delete[] tempb;
 
         LOGC(mglog.Error,
             log << "CUnitQueue:increase: failed to allocate " << size << " new units."
@@ -184,90 +197,516 @@ int CUnitQueue::increase()
         return -1;
     }
 
-    for (int i = 0; i < size; ++i)
+    for (int i = size - 1; i >= 0; --i)
     {
         tempu[i].m_iFlag           = CUnit::FREE;
         tempu[i].m_Packet.m_pcData = tempb + i * m_iMSS;
+        tempu[i].m_pEntry          = tempq;
+        pushFree(&tempu[i]);
     }
-    tempq->m_pUnit   = tempu;
-    tempq->m_pBuffer = tempb;
-    tempq->m_iSize   = size;
+    tempq->m_pUnit       = tempu;
+    tempq->m_pBuffer     = tempb;
+    tempq->m_iSize       = size;
+    tempq->m_iUsed       = 0;
+    tempq->m_tsFreeSince = steady_clock::now();
 
     m_pLastQueue->m_pNext = tempq;
     m_pLastQueue          = tempq;
     m_pLastQueue->m_pNext = m_pQEntry;
 
     m_iSize += size;
+    ++m_llGrowTotal;
 
     return 0;
 }
 
 int CUnitQueue::shrink()
 {
-    // currently queue cannot be shrunk.
-    return -1;
-}
+    if (m_tdHoldDown < steady_clock::duration::zero())
+        return 0;
 
-CUnit *CUnitQueue::getNextAvailUnit()
-{
-    if (m_iCount * 10 > m_iSize * 9)
-        increase();
+    const steady_clock::time_point now = steady_clock::now();
+    ScopedLock lg(m_FreeLock);
+    if (!m_pQEntry || now < m_tsNextShrinkCheck)
+        return 0;
 
-    if (m_iCount >= m_iSize)
-        return NULL;
+    // Walking through all blocks is cheap, but not for every packet.
+    m_tsNextShrinkCheck = now + milliseconds_from(SHRINK_CHECK_INTERVAL_MS);
 
-    int units_checked = 0;
-    do
+    int released = 0;
+    CQEntry* prev = m_pQEntry;
+    CQEntry* p    = m_pQEntry->m_pNext;
+    while (p != m_pQEntry)
     {
-        const CUnit *end = m_pCurrQueue->m_pUnit + m_pCurrQueue->m_iSize;
-        for (; m_pAvailUnit != end; ++m_pAvailUnit, ++units_checked)
+        CQEntry* next = p->m_pNext;
+        const int size = p->m_iSize;
+
+        // Keep at least half of the units free, otherwise the
+        // queue would be increased back soon after.
+        if (p->m_iUsed == 0 && now - p->m_tsFreeSince >= m_tdHoldDown && m_iCount * 2 <= m_iSize - size)
         {
-            if (m_pAvailUnit->m_iFlag == CUnit::FREE)
-            {
-                return m_pAvailUnit;
-            }
+            for (int i = 0; i < size; ++i)
+                unlinkFree(&p->m_pUnit[i]);
+
+            prev->m_pNext = next;
+            if (p == m_pLastQueue)
+                m_pLastQueue = prev;
+
+            delete[] p->m_pUnit;
+            srt::freePayloadBuffer(p->m_pBuffer, size_t(size) * m_iMSS, m_iBufAlloc);
+            delete p;
+
+            m_iSize -= size;
+            m_llReleasedBytes += int64_t(size) * (m_iMSS + sizeof(CUnit));
+            released += size;
         }
+        else
+        {
+            prev = p;
+        }
+        p = next;
+    }
 
-        m_pCurrQueue = m_pCurrQueue->m_pNext;
-        m_pAvailUnit = m_pCurrQueue->m_pUnit;
-    } while (units_checked < m_iSize);
+    if (released > 0)
+    {
+        HLOGC(mglog.Debug, log << "CUnitQueue:shrink: released " << released << " units, size=" << m_iSize
+                << " in use=" << m_iCount);
+    }
 
-    increase();
+    return released;
+}
 
-    return NULL;
+void CUnitQueue::pushFree(CUnit *unit)
+{
+    unit->m_pPrevFree = NULL;
+    unit->m_pNextFree = m_pFreeHead;
+    if (m_pFreeHead)
+        m_pFreeHead->m_pPrevFree = unit;
+    m_pFreeHead = unit;
+}
+
+void CUnitQueue::unlinkFree(CUnit *unit)
+{
+    if (unit->m_pPrevFree)
+        unit->m_pPrevFree->m_pNextFree = unit->m_pNextFree;
+    else
+        m_pFreeHead = unit->m_pNextFree;
+
+    if (unit->m_pNextFree)
+        unit->m_pNextFree->m_pPrevFree = unit->m_pPrevFree;
+
+    unit->m_pPrevFree = unit->m_pNextFree = NULL;
+}
+
+CUnit *CUnitQueue::getNextAvailUnit()
+{
+    ScopedLock lg(m_FreeLock);
+
+    if (m_iCount * 10 > m_iSize * 9)
+        increase_LOCKED();
+
+    return m_pFreeHead;
 }
 
 void CUnitQueue::makeUnitFree(CUnit *unit)
 {
     SRT_ASSERT(unit != NULL);
+    ScopedLock lg(m_FreeLock);
     SRT_ASSERT(unit->m_iFlag != CUnit::FREE);
     unit->m_iFlag = CUnit::FREE;
+    pushFree(unit);
     --m_iCount;
+
+    if (--unit->m_pEntry->m_iUsed == 0)
+        unit->m_pEntry->m_tsFreeSince = steady_clock::now();
 }
 
 void CUnitQueue::makeUnitGood(CUnit *unit)
 {
     SRT_ASSERT(unit != NULL);
+    ScopedLock lg(m_FreeLock);
     SRT_ASSERT(unit->m_iFlag == CUnit::FREE);
     unit->m_iFlag = CUnit::GOOD;
+    unlinkFree(unit);
     ++m_iCount;
+    ++unit->m_pEntry->m_iUsed;
+}
+
+void CUnitQueue::getPoolStats(int& w_free, int& w_capacity, int64_t& w_grown, int64_t& w_released)
+{
+    ScopedLock lg(m_FreeLock);
+    w_free     = m_iSize - m_iCount;
+    w_capacity = m_iSize;
+    w_grown    = m_llGrowTotal;
+    w_released = m_llReleasedBytes;
 }
 
-CSndUList::CSndUList()
+CSndHeap::CSndHeap()
     : m_pHeap(NULL)
     , m_iArrayLength(512)
     , m_iLastEntry(-1)
+{
+    m_pHeap = new CSNode *[m_iArrayLength];
+}
+
+CSndHeap::~CSndHeap()
+{
+    delete[] m_pHeap;
+}
+
+bool CSndHeap::insert(const steady_clock::time_point& ts, CSNode* n)
+{
+    // increase the heap array size if necessary
+    if (m_iLastEntry == m_iArrayLength - 1)
+        realloc_();
+
+    m_iLastEntry++;
+    m_pHeap[m_iLastEntry] = n;
+    n->m_tsTimeStamp = ts;
+
+    int q = m_iLastEntry;
+    int p = q;
+    while (p != 0)
+    {
+        p = (q - 1) >> 1;
+        if (m_pHeap[p]->m_tsTimeStamp <= m_pHeap[q]->m_tsTimeStamp)
+            break;
+
+        swap(m_pHeap[p], m_pHeap[q]);
+        m_pHeap[q]->m_iHeapLoc = q;
+        q                      = p;
+    }
+
+    n->m_iHeapLoc = q;
+    return q == 0;
+}
+
+void CSndHeap::remove(CSNode* n)
+{
+    // remove the node from heap
+    m_pHeap[n->m_iHeapLoc] = m_pHeap[m_iLastEntry];
+    m_iLastEntry--;
+    m_pHeap[n->m_iHeapLoc]->m_iHeapLoc = n->m_iHeapLoc;
+
+    int q = n->m_iHeapLoc;
+
+    // the last entry may be earlier than the parent of a removed inner node
+    while (q > 0 && q <= m_iLastEntry)
+    {
+        const int p = (q - 1) >> 1;
+        if (m_pHeap[p]->m_tsTimeStamp <= m_pHeap[q]->m_tsTimeStamp)
+            break;
+
+        swap(m_pHeap[p], m_pHeap[q]);
+        m_pHeap[p]->m_iHeapLoc = p;
+        m_pHeap[q]->m_iHeapLoc = q;
+        q = p;
+    }
+
+    int p = q * 2 + 1;
+    while (p <= m_iLastEntry)
+    {
+        if ((p + 1 <= m_iLastEntry) && (m_pHeap[p]->m_tsTimeStamp > m_pHeap[p + 1]->m_tsTimeStamp))
+            p++;
+
+        if (m_pHeap[q]->m_tsTimeStamp > m_pHeap[p]->m_tsTimeStamp)
+        {
+            swap(m_pHeap[p], m_pHeap[q]);
+            m_pHeap[p]->m_iHeapLoc = p;
+            m_pHeap[q]->m_iHeapLoc = q;
+
+            q = p;
+            p = q * 2 + 1;
+        }
+        else
+            break;
+    }
+
+    n->m_iHeapLoc = -1;
+}
+
+CSNode* CSndHeap::top(const steady_clock::time_point& until)
+{
+    if (-1 == m_iLastEntry || m_pHeap[0]->m_tsTimeStamp > until)
+        return NULL;
+
+    return m_pHeap[0];
+}
+
+steady_clock::time_point CSndHeap::nextTime() const
+{
+    if (-1 == m_iLastEntry)
+        return steady_clock::time_point();
+
+    return m_pHeap[0]->m_tsTimeStamp;
+}
+
+void CSndHeap::realloc_()
+{
+    CSNode **temp = NULL;
+
+    try
+    {
+        temp = new CSNode *[2 * m_iArrayLength];
+    }
+    catch (...)
+    {
+        throw CUDTException(MJ_SYSTEMRES, MN_MEMORY, 0);
+    }
+
+    memcpy((temp), m_pHeap, sizeof(CSNode *) * m_iArrayLength);
+    m_iArrayLength *= 2;
+    delete[] m_pHeap;
+    m_pHeap = temp;
+}
+
+static inline int lowestBit(uint64_t v)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1))
+    {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+CSndWheel::CSndWheel()
+    : m_tsOrigin(steady_clock::now())
+    , m_ullCursor(0)
+{
+    memset(m_pHead, 0, sizeof m_pHead);
+    memset(m_pTail, 0, sizeof m_pTail);
+    memset(m_aOccupied, 0, sizeof m_aOccupied);
+}
+
+bool CSndWheel::insert(const steady_clock::time_point& ts, CSNode* n)
+{
+    // The node is the first one if nothing is due at the cursor
+    // and the next occupied slot begins later.
+    bool first = false;
+    if (!m_pHead[m_ullCursor & (SLOTS - 1)])
+    {
+        uint64_t next;
+        first = nextSlot_((next)) == -1 || tick_(ts) < next;
+    }
+
+    n->m_tsTimeStamp = ts;
+    place_(n);
+    return first;
+}
+
+void CSndWheel::remove(CSNode* n)
+{
+    unlink_(n);
+}
+
+CSNode* CSndWheel::top(const steady_clock::time_point& until)
+{
+    advance_(tick_(until));
+
+    CSNode* n = m_pHead[m_ullCursor & (SLOTS - 1)];
+    if (!n || n->m_tsTimeStamp > until)
+        return NULL;
+
+    return n;
+}
+
+steady_clock::time_point CSndWheel::nextTime() const
+{
+    CSNode* n = m_pHead[m_ullCursor & (SLOTS - 1)];
+    if (n)
+        return n->m_tsTimeStamp;
+
+    uint64_t next;
+    const int loc = nextSlot_((next));
+    if (loc == -1)
+        return steady_clock::time_point();
+
+    // A slot on the lowest level holds the nodes of a single tick,
+    // on the higher levels the wheel has to turn to sort them out.
+    if (loc < SLOTS)
+        return m_pHead[loc]->m_tsTimeStamp;
+
+    return m_tsOrigin + microseconds_from(int64_t(next));
+}
+
+uint64_t CSndWheel::tick_(const steady_clock::time_point& ts) const
+{
+    if (ts <= m_tsOrigin)
+        return 0;
+
+    return uint64_t(count_microseconds(ts - m_tsOrigin));
+}
+
+void CSndWheel::place_(CSNode* n)
+{
+    const uint64_t t = std::max(tick_(n->m_tsTimeStamp), m_ullCursor);
+
+    // The lowest level on which the time is within the current turn.
+    for (int level = 0; level < LEVELS; ++level)
+    {
+        const int shift = SLOT_BITS * (level + 1);
+        if ((t >> shift) == (m_ullCursor >> shift))
+        {
+            link_(n, level * SLOTS + int((t >> (shift - SLOT_BITS)) & (SLOTS - 1)));
+            return;
+        }
+    }
+
+    link_(n, OVERFLOW_LOC);
+}
+
+void CSndWheel::link_(CSNode* n, int loc)
+{
+    n->m_iHeapLoc = loc;
+    n->m_pNext    = NULL;
+    n->m_pPrev    = m_pTail[loc];
+
+    if (m_pTail[loc])
+        m_pTail[loc]->m_pNext = n;
+    else
+        m_pHead[loc] = n;
+    m_pTail[loc] = n;
+
+    if (loc < OVERFLOW_LOC)
+        m_aOccupied[loc / SLOTS][(loc % SLOTS) / 64] |= uint64_t(1) << (loc % 64);
+}
+
+void CSndWheel::unlink_(CSNode* n)
+{
+    const int loc = n->m_iHeapLoc;
+
+    if (n->m_pPrev)
+        n->m_pPrev->m_pNext = n->m_pNext;
+    else
+        m_pHead[loc] = n->m_pNext;
+
+    if (n->m_pNext)
+        n->m_pNext->m_pPrev = n->m_pPrev;
+    else
+        m_pTail[loc] = n->m_pPrev;
+
+    if (!m_pHead[loc] && loc < OVERFLOW_LOC)
+        m_aOccupied[loc / SLOTS][(loc % SLOTS) / 64] &= ~(uint64_t(1) << (loc % 64));
+
+    n->m_pPrev    = NULL;
+    n->m_pNext    = NULL;
+    n->m_iHeapLoc = -1;
+}
+
+int CSndWheel::findSlot_(int level, int from) const
+{
+    for (int w = from / 64; w < SLOTS / 64; ++w)
+    {
+        uint64_t bits = m_aOccupied[level][w];
+        if (w == from / 64)
+            bits &= ~uint64_t(0) << (from % 64);
+
+        if (bits)
+            return w * 64 + lowestBit(bits);
+    }
+
+    return -1;
+}
+
+int CSndWheel::nextSlot_(uint64_t& w_tick) const
+{
+    // The slots up to the cursor's own are empty on every level above
+    // the lowest, so the first occupied slot found, starting from the
+    // lowest level, is the earliest one.
+    for (int level = 0; level < LEVELS; ++level)
+    {
+        const int shift = SLOT_BITS * level;
+        const int cur   = int((m_ullCursor >> shift) & (SLOTS - 1));
+        if (cur == SLOTS - 1)
+            continue;
+
+        const int slot = findSlot_(level, cur + 1);
+        if (slot == -1)
+            continue;
+
+        w_tick = ((m_ullCursor >> (shift + SLOT_BITS)) << (shift + SLOT_BITS)) | (uint64_t(slot) << shift);
+        return level * SLOTS + slot;
+    }
+
+    if (m_pHead[OVERFLOW_LOC])
+    {
+        const int shift = SLOT_BITS * LEVELS;
+        w_tick = ((m_ullCursor >> shift) + 1) << shift;
+        return OVERFLOW_LOC;
+    }
+
+    return -1;
+}
+
+void CSndWheel::advance_(uint64_t target)
+{
+    while (m_ullCursor < target && !m_pHead[m_ullCursor & (SLOTS - 1)])
+    {
+        // Jump over the empty slots: nothing needs to be
+        // moved down until the next occupied one.
+        uint64_t next;
+        if (nextSlot_((next)) == -1 || next > target)
+        {
+            m_ullCursor = target;
+            return;
+        }
+
+        m_ullCursor = next;
+        cascade_();
+    }
+}
+
+void CSndWheel::cascade_()
+{
+    // From the highest level down, as the nodes moved from
+    // a higher level may land in a slot that begins at the
+    // cursor on a lower level.
+    for (int level = LEVELS; level > 0; --level)
+    {
+        const int shift = SLOT_BITS * level;
+        if (m_ullCursor & ((uint64_t(1) << shift) - 1))
+            continue;
+
+        const int loc = level == LEVELS ? OVERFLOW_LOC : level * SLOTS + int((m_ullCursor >> shift) & (SLOTS - 1));
+        CSNode* n = m_pHead[loc];
+        m_pHead[loc] = NULL;
+        m_pTail[loc] = NULL;
+        if (loc < OVERFLOW_LOC)
+            m_aOccupied[loc / SLOTS][(loc % SLOTS) / 64] &= ~(uint64_t(1) << (loc % 64));
+
+        while (n)
+        {
+            CSNode* next = n->m_pNext;
+            place_(n);
+            n = next;
+        }
+    }
+}
+
+CSndUList::CSndUList(int sched)
+    : m_pSchedule(NULL)
+    , m_iLastEntry(-1)
     , m_ListLock()
     , m_pWindowLock(NULL)
     , m_pWindowCond(NULL)
     , m_pTimer(NULL)
+    , m_pWakeChannel(NULL)
 {
-    m_pHeap = new CSNode *[m_iArrayLength];
+    if (sched == SRT_SNDSCHED_WHEEL)
+        m_pSchedule = new CSndWheel;
+    else
+        m_pSchedule = new CSndHeap;
 }
 
 CSndUList::~CSndUList()
 {
-    delete[] m_pHeap;
+    delete m_pSchedule;
 }
 
 void CSndUList::update(const CUDT* u, EReschedule reschedule)
@@ -281,34 +720,36 @@ void CSndUList::update(const CUDT* u, EReschedule reschedule)
         if (!reschedule) // EReschedule to bool conversion, predicted.
             return;
 
-        if (n->m_iHeapLoc == 0)
-        {
-            n->m_tsTimeStamp = steady_clock::now();
-            m_pTimer->interrupt();
-            return;
-        }
-
-        remove_(u);
-        insert_norealloc_(steady_clock::now(), u);
+        m_pSchedule->remove(n);
+        if (m_pSchedule->insert(steady_clock::now(), n))
+            wakeup_();
         return;
     }
 
     insert_(steady_clock::now(), u);
 }
 
-int CSndUList::pop(sockaddr_any& w_addr, CPacket& w_pkt)
+int CSndUList::pop(sockaddr_any& w_addr, CPacket& w_pkt, steady_clock::time_point& w_departure,
+        const steady_clock::duration& lead)
 {
     ScopedLock listguard(m_ListLock);
 
     if (-1 == m_iLastEntry)
         return -1;
 
-    // no pop until the next schedulled time
-    if (m_pHeap[0]->m_tsTimeStamp > steady_clock::now())
+    // no pop until the next schedulled time (less the lead)
+    const steady_clock::time_point now = steady_clock::now();
+    CSNode* n = m_pSchedule->top(now + lead);
+    if (!n)
         return -1;
 
-    CUDT *u = m_pHeap[0]->m_pUDT;
-    remove_(u);
+    const steady_clock::time_point sched_time = n->m_tsTimeStamp;
+    CUDT *u = n->m_pUDT;
+
+    // The worker calling this will check the list again anyway; in
+    // single-thread mode waking it up would only cost system calls.
+    const bool notify = !m_pWakeChannel;
+    remove_(u, notify);
 
 #define UST(field) ((u->m_b##field) ? "+" : "-") << #field << " "
 
@@ -319,70 +760,44 @@ int CSndUList::pop(sockaddr_any& w_addr, CPacket& w_pkt)
 #undef UST
 
     if (!u->m_bConnected || u->m_bBroken)
-        return -1;
+        return 0;
 
-    // pack a packet from the socket
-    const std::pair<int, steady_clock::time_point> res_time = u->packData((w_pkt));
+    // pack a packet from the socket; a packet taken in advance
+    // is scheduled as if it was sent at its own time
+    w_departure = sched_time > now ? sched_time : now;
+    const std::pair<int, steady_clock::time_point> res_time = u->packData((w_pkt), w_departure);
 
     if (res_time.first <= 0)
-        return -1;
+        return 0;
 
     w_addr = u->m_PeerAddr;
 
     // insert a new entry, ts is the next processing time
     const steady_clock::time_point send_time = res_time.second;
     if (!is_zero(send_time))
-        insert_norealloc_(send_time, u);
-
-    return 1;
-}
-
-void CSndUList::remove(const CUDT *u)
-{
-    ScopedLock listguard(m_ListLock);
-
-    remove_(u);
-}
-
-steady_clock::time_point CSndUList::getNextProcTime()
-{
-    ScopedLock listguard(m_ListLock);
-
-    if (-1 == m_iLastEntry)
-        return steady_clock::time_point();
-
-    return m_pHeap[0]->m_tsTimeStamp;
-}
-
-void CSndUList::realloc_()
-{
-    CSNode **temp = NULL;
-
-    try
-    {
-        temp = new CSNode *[2 * m_iArrayLength];
-    }
-    catch (...)
-    {
-        throw CUDTException(MJ_SYSTEMRES, MN_MEMORY, 0);
-    }
+        insert_(send_time, u, notify);
 
-    memcpy((temp), m_pHeap, sizeof(CSNode *) * m_iArrayLength);
-    m_iArrayLength *= 2;
-    delete[] m_pHeap;
-    m_pHeap = temp;
+    return 1;
 }
 
-void CSndUList::insert_(const steady_clock::time_point& ts, const CUDT* u)
+void CSndUList::remove(const CUDT *u)
 {
-    // increase the heap array size if necessary
-    if (m_iLastEntry == m_iArrayLength - 1)
-        realloc_();
+    ScopedLock listguard(m_ListLock);
+
+    remove_(u);
+}
+
+steady_clock::time_point CSndUList::getNextProcTime()
+{
+    ScopedLock listguard(m_ListLock);
+
+    if (-1 == m_iLastEntry)
+        return steady_clock::time_point();
 
-    insert_norealloc_(ts, u);
+    return m_pSchedule->nextTime();
 }
 
-void CSndUList::insert_norealloc_(const steady_clock::time_point& ts, const CUDT* u)
+void CSndUList::insert_(const steady_clock::time_point& ts, const CUDT* u, bool notify)
 {
     CSNode *n = u->m_pSNode;
 
@@ -390,74 +805,39 @@ void CSndUList::insert_norealloc_(const steady_clock::time_point& ts, const CUDT
     if (n->m_iHeapLoc >= 0)
         return;
 
-    SRT_ASSERT(m_iLastEntry < m_iArrayLength);
+    // an earlier event has been inserted, wake up sending worker
+    if (m_pSchedule->insert(ts, n) && notify)
+        wakeup_();
 
     m_iLastEntry++;
-    m_pHeap[m_iLastEntry] = n;
-    n->m_tsTimeStamp = ts;
-
-    int q = m_iLastEntry;
-    int p = q;
-    while (p != 0)
-    {
-        p = (q - 1) >> 1;
-        if (m_pHeap[p]->m_tsTimeStamp <= m_pHeap[q]->m_tsTimeStamp)
-            break;
-
-        swap(m_pHeap[p], m_pHeap[q]);
-        m_pHeap[q]->m_iHeapLoc = q;
-        q                      = p;
-    }
-
-    n->m_iHeapLoc = q;
-
-    // an earlier event has been inserted, wake up sending worker
-    if (n->m_iHeapLoc == 0)
-        m_pTimer->interrupt();
 
     // first entry, activate the sending queue
-    if (0 == m_iLastEntry)
+    if (0 == m_iLastEntry && !m_pWakeChannel)
     {
         CSync::lock_signal(*m_pWindowCond, *m_pWindowLock);
     }
 }
 
-void CSndUList::remove_(const CUDT* u)
+void CSndUList::remove_(const CUDT* u, bool notify)
 {
     CSNode *n = u->m_pSNode;
 
     if (n->m_iHeapLoc >= 0)
     {
-        // remove the node from heap
-        m_pHeap[n->m_iHeapLoc] = m_pHeap[m_iLastEntry];
+        m_pSchedule->remove(n);
         m_iLastEntry--;
-        m_pHeap[n->m_iHeapLoc]->m_iHeapLoc = n->m_iHeapLoc;
-
-        int q = n->m_iHeapLoc;
-        int p = q * 2 + 1;
-        while (p <= m_iLastEntry)
-        {
-            if ((p + 1 <= m_iLastEntry) && (m_pHeap[p]->m_tsTimeStamp > m_pHeap[p + 1]->m_tsTimeStamp))
-                p++;
-
-            if (m_pHeap[q]->m_tsTimeStamp > m_pHeap[p]->m_tsTimeStamp)
-            {
-                swap(m_pHeap[p], m_pHeap[q]);
-                m_pHeap[p]->m_iHeapLoc = p;
-                m_pHeap[q]->m_iHeapLoc = q;
-
-                q = p;
-                p = q * 2 + 1;
-            }
-            else
-                break;
-        }
-
-        n->m_iHeapLoc = -1;
     }
 
     // the only event has been deleted, wake up immediately
-    if (0 == m_iLastEntry)
+    if (0 == m_iLastEntry && notify)
+        wakeup_();
+}
+
+void CSndUList::wakeup_()
+{
+    if (m_pWakeChannel)
+        m_pWakeChannel->wakeup();
+    else
         m_pTimer->interrupt();
 }
 
@@ -468,6 +848,24 @@ CSndQueue::CSndQueue()
     , m_pTimer(NULL)
     , m_WindowCond()
     , m_bClosing(false)
+    , m_iSendBatchSize(1)
+    , m_pBatchPacket(NULL)
+    , m_pBatchAddr(NULL)
+    , m_pBatchPayload(NULL)
+    , m_pBatchDeparture(NULL)
+    , m_bKernelPacing(false)
+    , m_tdPacingLead()
+    , m_pSendRing(NULL)
+    , m_llBatchCallsTotal(0)
+    , m_llBatchPktsTotal(0)
+    , m_iBatchMaxDepth(0)
+    , m_llSegmentedPktsTotal(0)
+    , m_llTimedPktsTotal(0)
+    , m_llBusyTime(0)
+    , m_iShard(0)
+    , m_iSocketCount(0)
+    , m_iSched(SRT_SNDSCHED_HEAP)
+    , m_bInBatch(false)
 {
     setupCond(m_WindowCond, "Window");
 }
@@ -490,21 +888,52 @@ CSndQueue::~CSndQueue()
     }
     releaseCond(m_WindowCond);
 
+    // No batch is being sent anymore.
+    for (std::vector<CSndRelease>::iterator i = m_vReleases.begin(); i != m_vReleases.end(); ++i)
+        i->call();
+
     delete m_pSndUList;
+    delete[] m_pBatchPacket;
+    delete[] m_pBatchAddr;
+    delete[] m_pBatchPayload;
+    delete[] m_pBatchDeparture;
 }
 
 #if ENABLE_LOGGING
     int CSndQueue::m_counter = 0;
 #endif
 
-void CSndQueue::init(CChannel *c, CTimer *t)
+void CSndQueue::init(CChannel *c, CTimer *t, int batch, int sched, bool thread)
 {
     m_pChannel                 = c;
     m_pTimer                   = t;
-    m_pSndUList                = new CSndUList;
+    m_pSndUList                = new CSndUList(sched);
+    m_iSched                   = sched;
     m_pSndUList->m_pWindowLock = &m_WindowLock;
     m_pSndUList->m_pWindowCond = &m_WindowCond;
     m_pSndUList->m_pTimer      = m_pTimer;
+    m_pSndUList->m_pWakeChannel = thread ? NULL : c;
+
+    m_iSendBatchSize = std::max(1, std::min(batch, int(CChannel::MAX_SEND_BATCH)));
+    m_pBatchPacket   = new CPacket[m_iSendBatchSize];
+    m_pBatchAddr     = new sockaddr_any[m_iSendBatchSize];
+    m_pBatchDeparture = new steady_clock::time_point[m_iSendBatchSize];
+
+    // With kernel pacing the worker doesn't wait for the sending time
+    // of every packet: it hands over all packets due within the lead,
+    // each with its departure time, and the kernel holds them until then.
+    m_bKernelPacing = c->getTxTime();
+    if (m_bKernelPacing)
+        m_tdPacingLead = microseconds_from(PACING_LEAD_US);
+
+    if (m_iSendBatchSize > 1)
+    {
+        m_pBatchPayload = new char[m_iSendBatchSize * SRT_LIVE_MAX_PLSIZE];
+        m_pSendRing = c->createSendRing();
+    }
+
+    if (!thread)
+        return;
 
 #if ENABLE_LOGGING
     ++m_counter;
@@ -583,9 +1012,9 @@ void *CSndQueue::worker(void *param)
 #endif /* SRT_DEBUG_SNDQ_HIGHRATE */
 
         THREAD_PAUSED();
-        if (currtime < next_time)
+        if (currtime < next_time - self->m_tdPacingLead)
         {
-            self->m_pTimer->sleep_until(next_time);
+            self->m_pTimer->sleep_until(next_time - self->m_tdPacingLead);
 
 #if defined(HAI_DEBUG_SNDQ_HIGHRATE)
             self->m_WorkerStats.lSleepTo++;
@@ -593,11 +1022,12 @@ void *CSndQueue::worker(void *param)
         }
         THREAD_RESUMED();
 
-        // it is time to send the next pkt
-        sockaddr_any addr;
-        CPacket      pkt;
-        if (self->m_pSndUList->pop((addr), (pkt)) < 0)
+        // it is time to send the next pkt(s)
+        const steady_clock::time_point busy_since = steady_clock::now();
+        const int batch_size = self->worker_CollectBatch();
+        if (batch_size == 0)
         {
+            self->worker_EndBatch();
             continue;
 
 #if defined(SRT_DEBUG_SNDQ_HIGHRATE)
@@ -605,11 +1035,11 @@ void *CSndQueue::worker(void *param)
 #endif /* SRT_DEBUG_SNDQ_HIGHRATE */
         }
 
-        HLOGC(mglog.Debug, log << self->CONID() << "chn:SENDING: " << pkt.Info());
-        self->m_pChannel->sendto(addr, pkt);
+        self->worker_SendBatch(batch_size, busy_since);
+        self->worker_EndBatch();
 
 #if defined(SRT_DEBUG_SNDQ_HIGHRATE)
-        self->m_WorkerStats.lSendTo++;
+        self->m_WorkerStats.lSendTo += batch_size;
 #endif /* SRT_DEBUG_SNDQ_HIGHRATE */
     }
 
@@ -617,6 +1047,156 @@ void *CSndQueue::worker(void *param)
     return NULL;
 }
 
+steady_clock::time_point CSndQueue::sendDue()
+{
+    const steady_clock::time_point due = nextDue();
+    const steady_clock::time_point busy_since = steady_clock::now();
+    if (is_zero(due) || busy_since < due)
+        return due;
+
+    const int batch_size = worker_CollectBatch();
+    if (batch_size > 0)
+        worker_SendBatch(batch_size, busy_since);
+    worker_EndBatch();
+
+    return nextDue();
+}
+
+steady_clock::time_point CSndQueue::nextDue()
+{
+    const steady_clock::time_point next_time = m_pSndUList->getNextProcTime();
+    return is_zero(next_time) ? next_time : next_time - m_tdPacingLead;
+}
+
+int CSndQueue::worker_CollectBatch()
+{
+    // Collect packets from all sockets that are due to be sent
+    // now, up to the batch size. The heap is consulted again after
+    // every packet so that a socket that is scheduled to send its
+    // next packet immediately (no pacing, probing pair) can contribute
+    // more than one packet to the batch.
+    {
+        ScopedLock lg(m_ReleaseLock);
+        m_bInBatch = true;
+    }
+
+    int size = 0;
+    while (size < m_iSendBatchSize && !m_bClosing)
+    {
+        CPacket& pkt = m_pBatchPacket[size];
+        const int res = m_pSndUList->pop((m_pBatchAddr[size]), (pkt), (m_pBatchDeparture[size]), m_tdPacingLead);
+        if (res < 0)
+            break;
+
+        // This socket had nothing to send and is off the list;
+        // others may still be due.
+        if (res == 0)
+            continue;
+
+        // The packet filter control packet payload is kept in a buffer
+        // of the socket, which is overwritten with the next control packet
+        // of the same socket. All other packets point to the sender buffer.
+        if (m_iSendBatchSize > 1 && !pkt.isControl() && pkt.getMsgSeq() == SRT_MSGNO_CONTROL)
+        {
+            char* payload = m_pBatchPayload + size * SRT_LIVE_MAX_PLSIZE;
+            memcpy((payload), pkt.m_pcData, std::min(pkt.getLength(), size_t(SRT_LIVE_MAX_PLSIZE)));
+            pkt.m_pcData = payload;
+        }
+
+        HLOGC(mglog.Debug, log << CONID() << "chn:SENDING: " << pkt.Info());
+        ++size;
+    }
+
+    return size;
+}
+
+void CSndQueue::worker_SendBatch(int size, const steady_clock::time_point& busy_since)
+{
+    int ncalls = 1;
+    int segmented = 0, timed = 0;
+    if (m_bKernelPacing)
+        ncalls = m_pChannel->sendmmsg(m_pBatchAddr, m_pBatchPacket, m_pBatchDeparture, size, (segmented), (timed));
+    else if (size == 1)
+        m_pChannel->sendto(m_pBatchAddr[0], m_pBatchPacket[0]);
+    else if (m_pSendRing && !m_pChannel->getGSO())
+        ncalls = m_pChannel->sendRing(*m_pSendRing, m_pBatchAddr, m_pBatchPacket, size);
+    else
+        ncalls = m_pChannel->sendmmsg(m_pBatchAddr, m_pBatchPacket, NULL, size, (segmented), (timed));
+
+    ScopedLock lg(m_StatsLock);
+    m_llBatchCallsTotal += ncalls;
+    m_llBatchPktsTotal += size;
+    m_iBatchMaxDepth = std::max(m_iBatchMaxDepth, size);
+    m_llSegmentedPktsTotal += segmented;
+    m_llTimedPktsTotal += timed;
+    m_llBusyTime += count_microseconds(steady_clock::now() - busy_since);
+}
+
+void CSndQueue::worker_EndBatch()
+{
+    std::vector<CSndRelease> done;
+    {
+        ScopedLock lg(m_ReleaseLock);
+        m_bInBatch = false;
+        done.swap(m_vReleases);
+    }
+
+    for (std::vector<CSndRelease>::iterator i = done.begin(); i != done.end(); ++i)
+        i->call();
+}
+
+void CSndQueue::release(const std::vector<CSndRelease>& done)
+{
+    if (done.empty())
+        return;
+
+    // A packet collected into the batch before the block was taken out of
+    // the sender buffer may still point to it, until the batch is sent.
+    {
+        ScopedLock lg(m_ReleaseLock);
+        if (m_bInBatch)
+        {
+            m_vReleases.insert(m_vReleases.end(), done.begin(), done.end());
+            return;
+        }
+    }
+
+    for (std::vector<CSndRelease>::const_iterator i = done.begin(); i != done.end(); ++i)
+        i->call();
+}
+
+void CSndQueue::getShardStats(int& w_shard, int& w_sockets, int64_t& w_busy, int& w_sched)
+{
+    ScopedLock lg(m_StatsLock);
+    w_shard   = m_iShard;
+    w_sockets = m_iSocketCount;
+    w_busy    = m_llBusyTime;
+    w_sched   = m_iSched;
+}
+
+int CSndQueue::getSocketCount()
+{
+    ScopedLock lg(m_StatsLock);
+    return m_iSocketCount;
+}
+
+void CSndQueue::updateSocketCount(int delta)
+{
+    ScopedLock lg(m_StatsLock);
+    m_iSocketCount += delta;
+}
+
+void CSndQueue::getBatchStats(int64_t& w_calls, int64_t& w_pkts, int& w_maxdepth, int64_t& w_segmented,
+        int64_t& w_timed)
+{
+    ScopedLock lg(m_StatsLock);
+    w_calls     = m_llBatchCallsTotal;
+    w_pkts      = m_llBatchPktsTotal;
+    w_maxdepth  = m_iBatchMaxDepth;
+    w_segmented = m_llSegmentedPktsTotal;
+    w_timed     = m_llTimedPktsTotal;
+}
+
 int CSndQueue::sendto(const sockaddr_any& w_addr, CPacket& w_packet)
 {
     // send out the packet immediately (high priority), this is a control packet
@@ -626,8 +1206,7 @@ int CSndQueue::sendto(const sockaddr_any& w_addr, CPacket& w_packet)
 
 //
 CRcvUList::CRcvUList()
-    : m_pUList(NULL)
-    , m_pLast(NULL)
+    : m_Timers()
 {
 }
 
@@ -635,180 +1214,236 @@ CRcvUList::~CRcvUList() {}
 
 void CRcvUList::insert(const CUDT *u)
 {
-    CRNode *n      = u->m_pRNode;
-    n->m_tsTimeStamp = steady_clock::now();
-
-    if (NULL == m_pUList)
-    {
-        // empty list, insert as the single node
-        n->m_pPrev = n->m_pNext = NULL;
-        m_pLast = m_pUList = n;
+    CRNode *n = u->m_pRNode;
 
+    if (n->m_iHeapLoc >= 0)
         return;
-    }
 
-    // always insert at the end for RcvUList
-    n->m_pPrev       = m_pLast;
-    n->m_pNext       = NULL;
-    m_pLast->m_pNext = n;
-    m_pLast          = n;
+    m_Timers.insert(steady_clock::now(), n);
 }
 
 void CRcvUList::remove(const CUDT *u)
 {
     CRNode *n = u->m_pRNode;
 
-    if (!n->m_bOnList)
+    if (!n->m_bOnList || n->m_iHeapLoc < 0)
         return;
 
-    if (NULL == n->m_pPrev)
-    {
-        // n is the first node
-        m_pUList = n->m_pNext;
-        if (NULL == m_pUList)
-            m_pLast = NULL;
-        else
-            m_pUList->m_pPrev = NULL;
-    }
-    else
-    {
-        n->m_pPrev->m_pNext = n->m_pNext;
-        if (NULL == n->m_pNext)
-        {
-            // n is the last node
-            m_pLast = n->m_pPrev;
-        }
-        else
-            n->m_pNext->m_pPrev = n->m_pPrev;
-    }
-
-    n->m_pNext = n->m_pPrev = NULL;
+    m_Timers.remove(n);
 }
 
-void CRcvUList::update(const CUDT *u)
+void CRcvUList::update(const CUDT *u, const steady_clock::time_point& ts)
 {
     CRNode *n = u->m_pRNode;
 
-    if (!n->m_bOnList)
+    if (!n->m_bOnList || n->m_iHeapLoc < 0)
         return;
 
-    n->m_tsTimeStamp = steady_clock::now();
-
-    // if n is the last node, do not need to change
-    if (NULL == n->m_pNext)
-        return;
-
-    if (NULL == n->m_pPrev)
-    {
-        m_pUList          = n->m_pNext;
-        m_pUList->m_pPrev = NULL;
-    }
-    else
-    {
-        n->m_pPrev->m_pNext = n->m_pNext;
-        n->m_pNext->m_pPrev = n->m_pPrev;
-    }
+    m_Timers.remove(n);
+    m_Timers.insert(ts, n);
+}
 
-    n->m_pPrev       = m_pLast;
-    n->m_pNext       = NULL;
-    m_pLast->m_pNext = n;
-    m_pLast          = n;
+CUDT* CRcvUList::next(const steady_clock::time_point& now)
+{
+    CSNode* n = m_Timers.top(now);
+    return n ? n->m_pUDT : NULL;
 }
 
-//
 CHash::CHash()
-    : m_pBucket(NULL)
-    , m_iHashSize(0)
+    : m_pTable(NULL)
+    , m_iCount(0)
+    , m_iRemoved(0)
 {
 }
 
 CHash::~CHash()
 {
-    for (int i = 0; i < m_iHashSize; ++i)
+    deleteTable(m_pTable);
+}
+
+CHash::CTable* CHash::newTable(int capacity)
+{
+    int bits = 0;
+    while ((1 << bits) < capacity)
+        ++bits;
+
+    CTable* t  = new CTable;
+    t->m_pSlot = new CSlot[size_t(1) << bits];
+    t->m_uMask = (uint32_t(1) << bits) - 1;
+    t->m_iShift = 32 - bits;
+    for (uint32_t i = 0; i <= t->m_uMask; ++i)
     {
-        CBucket *b = m_pBucket[i];
-        while (NULL != b)
-        {
-            CBucket *n = b->m_pNext;
-            delete b;
-            b = n;
-        }
+        t->m_pSlot[i].m_iID  = SLOT_EMPTY;
+        t->m_pSlot[i].m_pUDT = NULL;
     }
+    return t;
+}
 
-    delete[] m_pBucket;
+void CHash::deleteTable(CTable* t)
+{
+    if (!t)
+        return;
+    delete[] t->m_pSlot;
+    delete t;
 }
 
-void CHash::init(int size)
+uint32_t CHash::slotOf(const CTable* t, int32_t id)
 {
-    m_pBucket = new CBucket *[size];
+    // Fibonacci hashing: the socket IDs are mostly consecutive
+    // numbers, the multiplication spreads them over the table.
+    const uint32_t h = uint32_t(id) * 2654435769u;
+    return t->m_iShift < 32 ? (h >> t->m_iShift) : 0;
+}
 
-    for (int i = 0; i < size; ++i)
-        m_pBucket[i] = NULL;
+void CHash::init(int size)
+{
+    // Keep the table at most half full.
+    rehash(std::max(int(MIN_CAPACITY), size * 2));
+}
 
-    m_iHashSize = size;
+int CHash::capacity() const
+{
+    return m_pTable ? int(m_pTable->m_uMask + 1) : 0;
 }
 
-CUDT *CHash::lookup(int32_t id)
+CUDT *CHash::lookup(int32_t id) const
 {
-    // simple hash function (% hash table size); suitable for socket descriptors
-    CBucket *b = m_pBucket[id % m_iHashSize];
+    const CTable* t = m_pTable;
+    if (!t)
+        return NULL;
 
-    while (NULL != b)
+    for (uint32_t i = slotOf(t, id);; i = (i + 1) & t->m_uMask)
     {
-        if (id == b->m_iID)
-            return b->m_pUDT;
-        b = b->m_pNext;
-    }
+        const CSlot& slot = t->m_pSlot[i];
+        if (slot.m_iID == SLOT_EMPTY)
+            return NULL;
 
-    return NULL;
+        if (slot.m_iID == id)
+            return slot.m_pUDT;
+    }
 }
 
 void CHash::insert(int32_t id, CUDT *u)
 {
-    CBucket *b = m_pBucket[id % m_iHashSize];
+    SRT_ASSERT(id != SLOT_EMPTY && id != SLOT_REMOVED);
+
+    // Keep at most half of the slots used, including the removed ones,
+    // so that the probing ends soon. Rehashing drops the removed ones.
+    CTable* t = m_pTable;
+    if (!t || (m_iCount + m_iRemoved + 1) * 2 > int(t->m_uMask + 1))
+    {
+        rehash((m_iCount + 1) * 4);
+        t = m_pTable;
+    }
+
+    CSlot* target = NULL;
+    for (uint32_t i = slotOf(t, id);; i = (i + 1) & t->m_uMask)
+    {
+        CSlot& slot = t->m_pSlot[i];
+        if (slot.m_iID == id)
+        {
+            slot.m_pUDT = u;
+            return;
+        }
 
-    CBucket *n = new CBucket;
-    n->m_iID   = id;
-    n->m_pUDT  = u;
-    n->m_pNext = b;
+        if (slot.m_iID == SLOT_REMOVED && !target)
+            target = &slot;
 
-    m_pBucket[id % m_iHashSize] = n;
+        if (slot.m_iID == SLOT_EMPTY)
+        {
+            if (!target)
+                target = &slot;
+            break;
+        }
+    }
+
+    if (target->m_iID == SLOT_REMOVED)
+        --m_iRemoved;
+    target->m_iID  = id;
+    target->m_pUDT = u;
+    ++m_iCount;
 }
 
 void CHash::remove(int32_t id)
 {
-    CBucket *b = m_pBucket[id % m_iHashSize];
-    CBucket *p = NULL;
+    CTable* t = m_pTable;
+    if (!t)
+        return;
 
-    while (NULL != b)
+    for (uint32_t i = slotOf(t, id);; i = (i + 1) & t->m_uMask)
     {
-        if (id == b->m_iID)
-        {
-            if (NULL == p)
-                m_pBucket[id % m_iHashSize] = b->m_pNext;
-            else
-                p->m_pNext = b->m_pNext;
-
-            delete b;
+        CSlot& slot = t->m_pSlot[i];
+        if (slot.m_iID == SLOT_EMPTY)
+            return;
 
+        if (slot.m_iID == id)
+        {
+            slot.m_iID  = SLOT_REMOVED;
+            slot.m_pUDT = NULL;
+            --m_iCount;
+            ++m_iRemoved;
             return;
         }
+    }
+}
+
+void CHash::rehash(int capacity)
+{
+    CTable* const old = m_pTable;
+    CTable* const t   = newTable(std::max(int(MIN_CAPACITY), capacity));
 
-        p = b;
-        b = b->m_pNext;
+    if (old)
+    {
+        for (uint32_t i = 0; i <= old->m_uMask; ++i)
+        {
+            const CSlot& from = old->m_pSlot[i];
+            if (from.m_iID == SLOT_EMPTY || from.m_iID == SLOT_REMOVED)
+                continue;
+
+            uint32_t j = slotOf(t, from.m_iID);
+            while (t->m_pSlot[j].m_iID != SLOT_EMPTY)
+                j = (j + 1) & t->m_uMask;
+            t->m_pSlot[j].m_pUDT = from.m_pUDT;
+            t->m_pSlot[j].m_iID  = from.m_iID;
+        }
     }
+
+    deleteTable(old);
+    m_pTable   = t;
+    m_iRemoved = 0;
+
+    HLOGC(mglog.Debug, log << "CHash: rehashed " << m_iCount << " entries into " << (t->m_uMask + 1) << " slots");
 }
 
 //
 CRendezvousQueue::CRendezvousQueue()
-    : m_lRendezvousID()
+    : m_mRendezvousID()
+    , m_mPeerAddr()
+    , m_Deadlines()
     , m_RIDVectorLock()
 {
 }
 
 CRendezvousQueue::~CRendezvousQueue()
 {
-    m_lRendezvousID.clear();
+    m_mRendezvousID.clear();
+}
+
+bool CRendezvousQueue::AddrLess::operator()(const sockaddr_any& a1, const sockaddr_any& a2) const
+{
+    if (a1.family() != a2.family())
+        return a1.family() < a2.family();
+
+    if (a1.sin.sin_port != a2.sin.sin_port)
+        return a1.sin.sin_port < a2.sin.sin_port;
+
+    if (a1.family() == AF_INET)
+        return a1.sin.sin_addr.s_addr < a2.sin.sin_addr.s_addr;
+
+    if (a1.family() == AF_INET6)
+        return memcmp(&a1.sin6.sin6_addr, &a2.sin6.sin6_addr, sizeof (in6_addr)) < 0;
+
+    return false;
 }
 
 void CRendezvousQueue::insert(
@@ -816,16 +1451,24 @@ void CRendezvousQueue::insert(
 {
     ScopedLock vg(m_RIDVectorLock);
 
-    CRL r;
+    // The socket connects again after a failed attempt.
+    if (m_mRendezvousID.count(id))
+        remove(id, false);
+
+    CRL& r = m_mRendezvousID[id];
     r.m_iID        = id;
     r.m_pUDT       = u;
     r.m_PeerAddr = addr;
     r.m_tsTTL = ttl;
+    r.m_iHeapLoc = -1;
+    r.m_pPrev = r.m_pNext = NULL;
+
+    m_mPeerAddr.insert(std::make_pair(addr, id));
+    schedule_(r);
 
-    m_lRendezvousID.push_back(r);
     HLOGC(mglog.Debug, log << "RID: adding socket @" << id << " for address: " << SockaddrToString(addr)
             << " expires: " << FormatTime(ttl)
-            << " (total connectors: " << m_lRendezvousID.size() << ")");
+            << " (total connectors: " << m_mRendezvousID.size() << ")");
 }
 
 void CRendezvousQueue::remove(const SRTSOCKET &id, bool should_lock)
@@ -833,13 +1476,22 @@ void CRendezvousQueue::remove(const SRTSOCKET &id, bool should_lock)
     if (should_lock)
         enterCS(m_RIDVectorLock);
 
-    for (list<CRL>::iterator i = m_lRendezvousID.begin(); i != m_lRendezvousID.end(); ++i)
+    connectors_t::iterator i = m_mRendezvousID.find(id);
+    if (i != m_mRendezvousID.end())
     {
-        if (i->m_iID == id)
+        std::pair<addr_index_t::iterator, addr_index_t::iterator> range = m_mPeerAddr.equal_range(i->second.m_PeerAddr);
+        for (addr_index_t::iterator a = range.first; a != range.second; ++a)
         {
-            m_lRendezvousID.erase(i);
-            break;
+            if (a->second == id)
+            {
+                m_mPeerAddr.erase(a);
+                break;
+            }
         }
+
+        if (i->second.m_iHeapLoc != -1)
+            m_Deadlines.remove(&i->second);
+        m_mRendezvousID.erase(i);
     }
 
     if (should_lock)
@@ -850,16 +1502,30 @@ CUDT* CRendezvousQueue::retrieve(const sockaddr_any& addr, SRTSOCKET& w_id)
 {
     ScopedLock     vg(m_RIDVectorLock);
 
-    // TODO: optimize search
-    for (list<CRL>::iterator i = m_lRendezvousID.begin(); i != m_lRendezvousID.end(); ++i)
+    if (w_id != 0)
+    {
+        connectors_t::iterator i = m_mRendezvousID.find(w_id);
+        if (i != m_mRendezvousID.end() && i->second.m_PeerAddr == addr)
+        {
+            HLOGC(mglog.Debug, log << "RID: found id @" << i->second.m_iID << " while looking for THIS ID FROM "
+                    << SockaddrToString(i->second.m_PeerAddr));
+            return i->second.m_pUDT;
+        }
+    }
+    else
     {
-        if (i->m_PeerAddr == addr && ((w_id == 0) || (w_id == i->m_iID)))
+        // The first connector to this address, as they were inserted.
+        std::pair<addr_index_t::iterator, addr_index_t::iterator> range = m_mPeerAddr.equal_range(addr);
+        for (addr_index_t::iterator a = range.first; a != range.second; ++a)
         {
-            HLOGC(mglog.Debug, log << "RID: found id @" << i->m_iID << " while looking for "
-                    << (w_id ? "THIS ID FROM " : "A NEW CONNECTION FROM ")
-                    << SockaddrToString(i->m_PeerAddr));
-            w_id = i->m_iID;
-            return i->m_pUDT;
+            const CRL& r = m_mRendezvousID.find(a->second)->second;
+            if (r.m_PeerAddr == addr)
+            {
+                HLOGC(mglog.Debug, log << "RID: found id @" << r.m_iID << " while looking for A NEW CONNECTION FROM "
+                        << SockaddrToString(r.m_PeerAddr));
+                w_id = r.m_iID;
+                return r.m_pUDT;
+            }
         }
     }
 
@@ -870,163 +1536,172 @@ CUDT* CRendezvousQueue::retrieve(const sockaddr_any& addr, SRTSOCKET& w_id)
    else
        spec << " AGENT @" << w_id;
    HLOGC(mglog.Debug, log << "RID: NO CONNECTOR FOR ADR:" << SockaddrToString(addr)
-           << " while looking for " << spec.str() << " (" << m_lRendezvousID.size() << " connectors total)");
+           << " while looking for " << spec.str() << " (" << m_mRendezvousID.size() << " connectors total)");
 #endif
 
     return NULL;
 }
 
+void CRendezvousQueue::schedule_(CRL& r)
+{
+    // If no packet has been received from the peer,
+    // avoid sending too many requests, at most 1 request per 250ms
+    const steady_clock::time_point next_req = r.m_pUDT->m_tsLastReqTime + milliseconds_from(250);
+
+    if (r.m_iHeapLoc != -1)
+        m_Deadlines.remove(&r);
+    m_Deadlines.insert(std::min(next_req, r.m_tsTTL), &r);
+}
+
+steady_clock::time_point CRendezvousQueue::nextTime()
+{
+    ScopedLock vg(m_RIDVectorLock);
+    return m_Deadlines.nextTime();
+}
+
 void CRendezvousQueue::updateConnStatus(EReadStatus rst, EConnectStatus cst, const CPacket &response)
 {
     ScopedLock vg(m_RIDVectorLock);
 
-    if (m_lRendezvousID.empty())
+    if (m_mRendezvousID.empty())
         return;
 
     HLOGC(mglog.Debug,
           log << "updateConnStatus: updating after getting pkt id=" << response.m_iID
               << " status: " << ConnectStatusStr(cst));
 
-#if ENABLE_HEAVY_LOGGING
-    int debug_nupd  = 0;
-    int debug_nrun  = 0;
-    int debug_nfail = 0;
-#endif
+    // RST_AGAIN happens in case when the last attempt to read a packet from the UDP
+    // socket has read nothing. In this case it would be a repeated update, while
+    // still waiting for a response from the peer. When we have any other state here
+    // (most expectably CONN_CONTINUE or CONN_RENDEZVOUS, which means that a packet has
+    // just arrived in this iteration), do the update immetiately (in SRT this also
+    // involves additional incoming data interpretation, which wasn't the case in UDT).
+    const bool addressed = rst != RST_AGAIN && m_mRendezvousID.count(response.m_iID);
+
+    // Use "slow" cyclic responding for the sockets whose time has come.
+    // They are taken out first, as processing may remove any of them.
+    const steady_clock::time_point now = steady_clock::now();
+    std::vector<SRTSOCKET> due;
+    if (addressed)
+        due.push_back(response.m_iID);
+    CSNode* n;
+    while ((n = m_Deadlines.top(now)) != NULL)
+    {
+        m_Deadlines.remove(n);
+        const SRTSOCKET id = static_cast<CRL*>(n)->m_iID;
+        if (!addressed || id != response.m_iID)
+            due.push_back(id);
+    }
 
-    for (list<CRL>::iterator i = m_lRendezvousID.begin(), i_next = i; i != m_lRendezvousID.end(); i = i_next)
-    {
-        ++i_next;
-        // NOTE: This is a SAFE LOOP.
-        // Incrementation will be done at the end, after the processing did not
-        // REMOVE the currently processed element. When the element was removed,
-        // the iterator value for the next iteration will be taken from erase()'s result.
-
-        // RST_AGAIN happens in case when the last attempt to read a packet from the UDP
-        // socket has read nothing. In this case it would be a repeated update, while
-        // still waiting for a response from the peer. When we have any other state here
-        // (most expectably CONN_CONTINUE or CONN_RENDEZVOUS, which means that a packet has
-        // just arrived in this iteration), do the update immetiately (in SRT this also
-        // involves additional incoming data interpretation, which wasn't the case in UDT).
-
-        // Use "slow" cyclic responding in case when
-        // - RST_AGAIN (no packet was received for whichever socket)
-        // - a packet was received, but not for THIS socket
-        if (rst == RST_AGAIN || i->m_iID != response.m_iID)
+    for (std::vector<SRTSOCKET>::iterator d = due.begin(); d != due.end(); ++d)
+    {
+        connectors_t::iterator i = m_mRendezvousID.find(*d);
+        if (i == m_mRendezvousID.end())
+            continue;
+
+        if (!addressed || *d != response.m_iID)
         {
-            // If no packet has been received from the peer,
-            // avoid sending too many requests, at most 1 request per 250ms
-            const steady_clock::time_point then = i->m_pUDT->m_tsLastReqTime;
-            const steady_clock::time_point now = steady_clock::now();
-            const steady_clock::duration timeout_250ms = milliseconds_from(250);
-            const bool now_is_time = (now - then) > timeout_250ms;
+            // The request may have been sent since the visit was scheduled.
+            const steady_clock::time_point then = i->second.m_pUDT->m_tsLastReqTime;
+            const bool now_is_time = (now - then) > milliseconds_from(250) || now >= i->second.m_tsTTL;
             HLOGC(mglog.Debug,
-                  log << "RID:@" << i->m_iID << " then=" << FormatTime(then)
+                  log << "RID:@" << *d << " then=" << FormatTime(then)
                       << " now=" << FormatTime(now) << " passed=" << count_microseconds(now - then)
                       << "<=> 250000 -- now's " << (now_is_time ? "" : "NOT ") << "the time");
 
-            if (!now_is_time)
-                continue;
-        }
-
-        HLOGC(mglog.Debug, log << "RID:@" << i->m_iID << " cst=" << ConnectStatusStr(cst) << " -- sending update NOW.");
-
-#if ENABLE_HEAVY_LOGGING
-        ++debug_nrun;
-#endif
-
-        // XXX This looks like a loop that rolls in infinity without any sleeps
-        // inside and makes it once per about 50 calls send a hs conclusion
-        // for a randomly sampled rendezvous ID of a socket out of the list.
-        // Ok, probably the rendezvous ID should be just one so not much to
-        // sample from, but if so, why the container?
-        //
-        // This must be somehow fixed!
-        //
-        // Maybe the time should be simply checked once and the whole loop not
-        // done when "it's not the time"?
-        const steady_clock::time_point now = steady_clock::now();
-        if (now >= i->m_tsTTL)
-        {
-            HLOGC(mglog.Debug, log << "RID: socket @" << i->m_iID
-                << " removed - EXPIRED ("
-                // The "enforced on FAILURE" is below when processAsyncConnectRequest failed.
-                << (is_zero(i->m_tsTTL) ? "enforced on FAILURE" : "passed TTL")
-                << "). removing from queue");
-            // connection timer expired, acknowledge app via epoll
-            i->m_pUDT->m_bConnecting = false;
-            i->m_pUDT->m_RejectReason = SRT_REJ_TIMEOUT;
-            CUDT::s_UDTUnited.m_EPoll.update_events(i->m_iID, i->m_pUDT->m_sPollID, SRT_EPOLL_ERR, true);
-            /*
-             * Setting m_bConnecting to false but keeping socket in rendezvous queue is not a good idea.
-             * Next CUDT::close will not remove it from rendezvous queue (because !m_bConnecting)
-             * and may crash here on next pass.
-             */
-            // i_next was preincremented, but this is guaranteed to point to
-            // the element next to erased one.
-            i_next = m_lRendezvousID.erase(i);
-            continue;
-        }
-        else
-        {
-            HLOGC(mglog.Debug, log << "RID: socket @" << i->m_iID << " still active (remaining "
-                    << std::fixed << (count_microseconds(i->m_tsTTL - now)/1000000.0) << "s of TTL)...");
-        }
-
-        // This queue is used only in case of Async mode (rendezvous or caller-listener).
-        // Synchronous connection requests are handled in startConnect() completely.
-        if (!i->m_pUDT->m_bSynRecving)
-        {
-#if ENABLE_HEAVY_LOGGING
-            ++debug_nupd;
-#endif
-            // IMPORTANT INFORMATION concerning changes towards UDT legacy.
-            // In the UDT code there was no attempt to interpret any incoming data.
-            // All data from the incoming packet were considered to be already deployed into
-            // m_ConnRes field, and m_ConnReq field was considered at this time accordingly updated.
-            // Therefore this procedure did only one thing: craft a new handshake packet and send it.
-            // In SRT this may also interpret extra data (extensions in case when Agent is Responder)
-            // and the `response` packet may sometimes contain no data. Therefore the passed `rst`
-            // must be checked to distinguish the call by periodic update (RST_AGAIN) from a call
-            // due to have received the packet (RST_OK).
-            //
-            // In the below call, only the underlying `processRendezvous` function will be attempting
-            // to interpret these data (for caller-listener this was already done by `processConnectRequest`
-            // before calling this function), and it checks for the data presence.
-
-            EReadStatus    read_st = rst;
-            EConnectStatus conn_st = cst;
-
-            if (i->m_iID != response.m_iID)
-            {
-                read_st = RST_AGAIN;
-                conn_st = CONN_AGAIN;
-            }
-
-            if (!i->m_pUDT->processAsyncConnectRequest(read_st, conn_st, response, i->m_PeerAddr))
+            if (!now_is_time)
             {
-                // cst == CONN_REJECT can only be result of worker_ProcessAddressedPacket and
-                // its already set in this case.
-                LOGC(mglog.Error, log << "RendezvousQueue: processAsyncConnectRequest FAILED. Setting TTL as EXPIRED.");
-                i->m_pUDT->sendCtrl(UMSG_SHUTDOWN);
-                i->m_tsTTL = steady_clock::time_point(); // Make it expire right now, will be picked up at the next iteration
-#if ENABLE_HEAVY_LOGGING
-                ++debug_nfail;
-#endif
+                schedule_(i->second);
+                continue;
             }
-
-            // NOTE: safe loop, the incrementation was done before the loop body,
-            // so the `i' node can be safely deleted. Just the body must end here.
-            continue;
-        }
-        else
-        {
-            HLOGC(mglog.Debug, log << "RID: socket @" << i->m_iID << " deemed SYNCHRONOUS, NOT UPDATING");
         }
+
+        process_(i->second, rst, cst, response);
+
+        // The connector is scheduled again, unless it's gone.
+        i = m_mRendezvousID.find(*d);
+        if (i != m_mRendezvousID.end())
+            schedule_(i->second);
     }
 
     HLOGC(mglog.Debug,
-          log << "updateConnStatus: " << debug_nupd << "/" << debug_nrun << " sockets updated ("
-              << (debug_nrun - debug_nupd) << " useless). REMOVED " << debug_nfail << " sockets.");
+          log << "updateConnStatus: " << due.size() << "/" << m_mRendezvousID.size() << " sockets visited");
+}
+
+void CRendezvousQueue::process_(CRL& r, EReadStatus rst, EConnectStatus cst, const CPacket& response)
+{
+    HLOGC(mglog.Debug, log << "RID:@" << r.m_iID << " cst=" << ConnectStatusStr(cst) << " -- sending update NOW.");
+
+    const steady_clock::time_point now = steady_clock::now();
+    if (now >= r.m_tsTTL)
+    {
+        HLOGC(mglog.Debug, log << "RID: socket @" << r.m_iID
+            << " removed - EXPIRED ("
+            // The "enforced on FAILURE" is below when processAsyncConnectRequest failed.
+            << (is_zero(r.m_tsTTL) ? "enforced on FAILURE" : "passed TTL")
+            << "). removing from queue");
+        // connection timer expired, acknowledge app via epoll
+        r.m_pUDT->m_bConnecting = false;
+        r.m_pUDT->m_RejectReason = SRT_REJ_TIMEOUT;
+        CUDT::s_UDTUnited.m_EPoll.update_events(r.m_iID, r.m_pUDT->m_sPollID, SRT_EPOLL_ERR, true);
+        /*
+         * Setting m_bConnecting to false but keeping socket in rendezvous queue is not a good idea.
+         * Next CUDT::close will not remove it from rendezvous queue (because !m_bConnecting)
+         * and may crash here on next pass.
+         */
+        remove(r.m_iID, false);
+        return;
+    }
+    else
+    {
+        HLOGC(mglog.Debug, log << "RID: socket @" << r.m_iID << " still active (remaining "
+                << std::fixed << (count_microseconds(r.m_tsTTL - now)/1000000.0) << "s of TTL)...");
+    }
+
+    // This queue is used only in case of Async mode (rendezvous or caller-listener).
+    // Synchronous connection requests are handled in startConnect() completely.
+    if (r.m_pUDT->m_bSynRecving)
+    {
+        HLOGC(mglog.Debug, log << "RID: socket @" << r.m_iID << " deemed SYNCHRONOUS, NOT UPDATING");
+        return;
+    }
+
+    // IMPORTANT INFORMATION concerning changes towards UDT legacy.
+    // In the UDT code there was no attempt to interpret any incoming data.
+    // All data from the incoming packet were considered to be already deployed into
+    // m_ConnRes field, and m_ConnReq field was considered at this time accordingly updated.
+    // Therefore this procedure did only one thing: craft a new handshake packet and send it.
+    // In SRT this may also interpret extra data (extensions in case when Agent is Responder)
+    // and the `response` packet may sometimes contain no data. Therefore the passed `rst`
+    // must be checked to distinguish the call by periodic update (RST_AGAIN) from a call
+    // due to have received the packet (RST_OK).
+    //
+    // In the below call, only the underlying `processRendezvous` function will be attempting
+    // to interpret these data (for caller-listener this was already done by `processConnectRequest`
+    // before calling this function), and it checks for the data presence.
+
+    EReadStatus    read_st = rst;
+    EConnectStatus conn_st = cst;
+
+    if (r.m_iID != response.m_iID)
+    {
+        read_st = RST_AGAIN;
+        conn_st = CONN_AGAIN;
+    }
+
+    // The connector is removed from the queue when the connection is established.
+    const SRTSOCKET id = r.m_iID;
+    CUDT* u = r.m_pUDT;
+    if (!u->processAsyncConnectRequest(read_st, conn_st, response, r.m_PeerAddr))
+    {
+        // cst == CONN_REJECT can only be result of worker_ProcessAddressedPacket and
+        // its already set in this case.
+        LOGC(mglog.Error, log << "RendezvousQueue: processAsyncConnectRequest FAILED. Setting TTL as EXPIRED.");
+        u->sendCtrl(UMSG_SHUTDOWN);
+        connectors_t::iterator i = m_mRendezvousID.find(id);
+        if (i != m_mRendezvousID.end())
+            i->second.m_tsTTL = steady_clock::time_point(); // Make it expire right now, will be picked up at the next iteration
+    }
 }
 
 //
@@ -1037,11 +1712,29 @@ CRcvQueue::CRcvQueue()
     , m_pHash(NULL)
     , m_pChannel(NULL)
     , m_pTimer(NULL)
+    , m_pSndQueue(NULL)
+    , m_bPolled(false)
     , m_iPayloadSize()
+    , m_pWorkerUnit(NULL)
+    , m_WorkerConnStatus(CONN_AGAIN)
     , m_bClosing(false)
+    , m_iRecvBatchSize(1)
+    , m_iBatchFill(0)
+    , m_iBatchNext(0)
+    , m_llBatchCallsTotal(0)
+    , m_llBatchPktsTotal(0)
+    , m_iBatchMaxDepth(0)
+    , m_llCoalescedPktsTotal(0)
+    , m_llTimedPktsTotal(0)
+    , m_llTimerChecksTotal(0)
+    , m_iTimerChecksRate(0)
+    , m_llTimerChecksPeriod(0)
+    , m_tsTimerChecksSince(steady_clock::now())
     , m_LSLock()
     , m_pListener(NULL)
     , m_pRendezvousQueue(NULL)
+    , m_pNextShard(NULL)
+    , m_iShard(0)
     , m_vNewEntry()
     , m_IDLock()
     , m_mBuffer()
@@ -1061,21 +1754,17 @@ CRcvQueue::~CRcvQueue()
     }
     releaseCond(m_BufferCond);
 
+    // The system must release the units of the posted
+    // receives before the unit queue frees them.
+    if (!m_vPostedUnit.empty())
+        m_pChannel->cancelPosted();
+
     delete m_pRcvUList;
     delete m_pHash;
     delete m_pRendezvousQueue;
 
-    // remove all queued messages
-    for (map<int32_t, std::queue<CPacket *> >::iterator i = m_mBuffer.begin(); i != m_mBuffer.end(); ++i)
-    {
-        while (!i->second.empty())
-        {
-            CPacket *pkt = i->second.front();
-            delete[] pkt->m_pcData;
-            delete pkt;
-            i->second.pop();
-        }
-    }
+    // The queued messages are in the units, released with the unit queue.
+    m_mBuffer.clear();
 }
 
 #if ENABLE_LOGGING
@@ -1083,21 +1772,55 @@ CRcvQueue::~CRcvQueue()
 #endif
 
 
-void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel *cc, CTimer *t)
+void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel *cc, CTimer *t, int batch,
+        CSndQueue* sndq, bool thread)
 {
     m_iPayloadSize = payload;
 
     m_UnitQueue.init(qsize, payload, version);
 
+    m_iRecvBatchSize = std::max(1, std::min(batch, int(CChannel::MAX_RECV_BATCH)));
+
+    // A datagram coalesced by the receive offload may carry many packets,
+    // all of which need a unit, and it can be only read as a batch.
+    if (cc->getGRO())
+        m_iRecvBatchSize = CChannel::MAX_RECV_BATCH;
+
+    // With io_uring the receives are posted in advance, each into its own
+    // unit, and as many of them as fit in the channel's ring.
+    if (cc->usesRecvRing())
+    {
+        m_iRecvBatchSize = CChannel::MAX_RECV_BATCH;
+        m_vPostedUnit.resize(m_iRecvBatchSize, NULL);
+        m_vBatchSlot.resize(m_iRecvBatchSize, 0);
+    }
+
+    if (m_iRecvBatchSize > 1)
+    {
+        m_vBatchUnit.resize(m_iRecvBatchSize, NULL);
+        m_vBatchPacket.resize(m_iRecvBatchSize, NULL);
+        m_vBatchAddr.resize(m_iRecvBatchSize, sockaddr_any(version));
+        m_vBatchStatus.resize(m_iRecvBatchSize, RST_AGAIN);
+    }
+
     m_pHash = new CHash;
     m_pHash->init(hsize);
 
-    m_pChannel = cc;
-    m_pTimer   = t;
+    m_pChannel  = cc;
+    m_pTimer    = t;
+    m_pSndQueue = sndq;
 
     m_pRcvUList        = new CRcvUList;
     m_pRendezvousQueue = new CRendezvousQueue;
 
+    // The application calling process() waits for the channel itself.
+    if (!thread)
+    {
+        m_bPolled = true;
+        m_pChannel->setRecvTimeout(0);
+        return;
+    }
+
 #if ENABLE_LOGGING
     ++m_counter;
     const std::string thrname = "SRT:RcvQ:w" + Sprint(m_counter);
@@ -1113,128 +1836,152 @@ void CRcvQueue::init(int qsize, int payload, int version, int hsize, CChannel *c
 
 void *CRcvQueue::worker(void *param)
 {
-    CRcvQueue *  self = (CRcvQueue *)param;
-    sockaddr_any sa(self->m_UnitQueue.getIPversion());
-    int32_t      id = 0;
+    CRcvQueue *self = (CRcvQueue *)param;
 
     THREAD_STATE_INIT("SRT:RcvQ:worker");
 
-    CUnit *        unit = 0;
-    EConnectStatus cst  = CONN_AGAIN;
     while (!self->m_bClosing)
     {
-        bool        have_received = false;
-        EReadStatus rst           = self->worker_RetrieveUnit((id), (unit), (sa));
-        if (rst == RST_OK)
-        {
-            if (id < 0)
-            {
-                // User error on peer. May log something, but generally can only ignore it.
-                // XXX Think maybe about sending some "connection rejection response".
-                HLOGC(mglog.Debug,
-                      log << self->CONID() << "RECEIVED negative socket id '" << id
-                          << "', rejecting (POSSIBLE ATTACK)");
-                continue;
-            }
+        if (self->worker_Iterate() == RST_ERROR)
+            break;
+    }
 
-            // NOTE: cst state is being changed here.
-            // This state should be maintained through any next failed calls to worker_RetrieveUnit.
-            // Any error switches this to rejection, just for a case.
+    THREAD_EXIT();
+    return NULL;
+}
 
-            // Note to rendezvous connection. This can accept:
-            // - ID == 0 - take the first waiting rendezvous socket
-            // - ID > 0  - find the rendezvous socket that has this ID.
-            if (id == 0)
-            {
-                // ID 0 is for connection request, which should be passed to the listening socket or rendezvous sockets
-                cst = self->worker_ProcessConnectionRequest(unit, sa);
-            }
-            else
-            {
-                // Otherwise ID is expected to be associated with:
-                // - an enqueued rendezvous socket
-                // - a socket connected to a peer
-                cst = self->worker_ProcessAddressedPacket(id, unit, sa);
-                // CAN RETURN CONN_REJECT, but m_RejectReason is already set
-            }
-            HLOGC(mglog.Debug, log << self->CONID() << "worker: result for the unit: " << ConnectStatusStr(cst));
-            if (cst == CONN_AGAIN)
-            {
-                HLOGC(mglog.Debug, log << self->CONID() << "worker: packet not dispatched, continuing reading.");
-                continue;
-            }
-            have_received = true;
-        }
-        else if (rst == RST_ERROR)
+// One round of the worker: retrieves and dispatches a packet, if any has
+// arrived, then checks the timers and connectors that are due.
+EReadStatus CRcvQueue::worker_Iterate()
+{
+    // The state kept between the iterations
+    CUnit*&         unit = m_pWorkerUnit;
+    EConnectStatus& cst  = m_WorkerConnStatus;
+
+    sockaddr_any sa(m_UnitQueue.getIPversion());
+    int32_t      id = 0;
+
+    bool        have_received = false;
+    EReadStatus rst           = worker_RetrieveUnit((id), (unit), (sa));
+    if (m_pSndQueue)
+        m_pChannel->endWait();
+    if (rst == RST_OK)
+    {
+        if (id < 0)
         {
-            // According to the description by CChannel::recvfrom, this can be either of:
-            // - IPE: all errors except EBADF
-            // - socket was closed in the meantime by another thread: EBADF
-            // If EBADF, then it's expected that the "closing" state is also set.
-            // Check that just to report possible errors, but interrupt the loop anyway.
-            if (self->m_bClosing)
-            {
-                HLOGC(mglog.Debug,
-                      log << self->CONID() << "CChannel reported error, but Queue is closing - INTERRUPTING worker.");
-            }
-            else
-            {
-                LOGC(mglog.Fatal,
-                     log << self->CONID()
-                         << "CChannel reported ERROR DURING TRANSMISSION - IPE. INTERRUPTING worker anyway.");
-            }
-            cst = CONN_REJECT;
-            break;
+            // User error on peer. May log something, but generally can only ignore it.
+            // XXX Think maybe about sending some "connection rejection response".
+            HLOGC(mglog.Debug,
+                  log << CONID() << "RECEIVED negative socket id '" << id
+                      << "', rejecting (POSSIBLE ATTACK)");
+            return rst;
         }
-        // OTHERWISE: this is an "AGAIN" situation. No data was read, but the process should continue.
 
-        // take care of the timing event for all UDT sockets
-        const steady_clock::time_point curtime_minus_syn = steady_clock::now() - microseconds_from(CUDT::COMM_SYN_INTERVAL_US);
+        // NOTE: cst state is being changed here.
+        // This state should be maintained through any next failed calls to worker_RetrieveUnit.
+        // Any error switches this to rejection, just for a case.
 
-        CRNode *ul = self->m_pRcvUList->m_pUList;
-        while ((NULL != ul) && (ul->m_tsTimeStamp < curtime_minus_syn))
+        // Note to rendezvous connection. This can accept:
+        // - ID == 0 - take the first waiting rendezvous socket
+        // - ID > 0  - find the rendezvous socket that has this ID.
+        if (id == 0)
+        {
+            // ID 0 is for connection request, which should be passed to the listening socket or rendezvous sockets
+            cst = worker_ProcessConnectionRequest(unit, sa);
+        }
+        else
+        {
+            // Otherwise ID is expected to be associated with:
+            // - an enqueued rendezvous socket
+            // - a socket connected to a peer
+            cst = worker_ProcessAddressedPacket(id, unit, sa);
+            // CAN RETURN CONN_REJECT, but m_RejectReason is already set
+        }
+        HLOGC(mglog.Debug, log << CONID() << "worker: result for the unit: " << ConnectStatusStr(cst));
+        if (cst == CONN_AGAIN)
+        {
+            HLOGC(mglog.Debug, log << CONID() << "worker: packet not dispatched, continuing reading.");
+            return rst;
+        }
+        have_received = true;
+    }
+    else if (rst == RST_ERROR)
+    {
+        // According to the description by CChannel::recvfrom, this can be either of:
+        // - IPE: all errors except EBADF
+        // - socket was closed in the meantime by another thread: EBADF
+        // If EBADF, then it's expected that the "closing" state is also set.
+        // Check that just to report possible errors, but interrupt the loop anyway.
+        if (m_bClosing)
+        {
+            HLOGC(mglog.Debug,
+                  log << CONID() << "CChannel reported error, but Queue is closing - INTERRUPTING worker.");
+        }
+        else
         {
-            CUDT *u = ul->m_pUDT;
+            LOGC(mglog.Fatal,
+                 log << CONID()
+                     << "CChannel reported ERROR DURING TRANSMISSION - IPE. INTERRUPTING worker anyway.");
+        }
+        cst = CONN_REJECT;
+        return rst;
+    }
+    // OTHERWISE: this is an "AGAIN" situation. No data was read, but the process should continue.
 
-            if (u->m_bConnected && !u->m_bBroken && !u->m_bClosing)
-            {
-                u->checkTimers();
-                self->m_pRcvUList->update(u);
-            }
-            else
-            {
-                HLOGC(mglog.Debug,
-                      log << CUDTUnited::CONID(u->m_SocketID) << " SOCKET broken, REMOVING FROM RCV QUEUE/MAP.");
-                // the socket must be removed from Hash table first, then RcvUList
-                self->m_pHash->remove(u->m_SocketID);
-                self->m_pRcvUList->remove(u);
-                u->m_pRNode->m_bOnList = false;
-            }
+    // take care of the timing event for the UDT sockets whose timers are due
+    const steady_clock::time_point now = steady_clock::now();
+    int timer_checks = 0;
 
-            ul = self->m_pRcvUList->m_pUList;
+    CUDT *u;
+    while ((u = m_pRcvUList->next(now)) != NULL)
+    {
+        if (u->m_bConnected && !u->m_bBroken && !u->m_bClosing)
+        {
+            u->checkTimers();
+            m_pRcvUList->update(u, u->getNextTimerTime(now));
+            ++timer_checks;
         }
-
-        if (have_received)
+        else
         {
             HLOGC(mglog.Debug,
-                  log << "worker: RECEIVED PACKET --> updateConnStatus. cst=" << ConnectStatusStr(cst) << " id=" << id
-                      << " pkt-payload-size=" << unit->m_Packet.getLength());
+                  log << CUDTUnited::CONID(u->m_SocketID) << " SOCKET broken, REMOVING FROM RCV QUEUE/MAP.");
+            // the socket must be removed from Hash table first, then RcvUList
+            m_pHash->remove(u->m_SocketID);
+            m_pRcvUList->remove(u);
+            u->m_pRNode->m_bOnList = false;
         }
+    }
+
+    worker_CountTimerChecks(timer_checks, now);
 
-        // Check connection requests status for all sockets in the RendezvousQueue.
-        // Pass the connection status from the last call of:
-        // worker_ProcessAddressedPacket --->
-        // worker_TryAsyncRend_OrStore --->
-        // CUDT::processAsyncConnectResponse --->
-        // CUDT::processConnectResponse
-        self->m_pRendezvousQueue->updateConnStatus(rst, cst, unit->m_Packet);
+    if (have_received)
+    {
+        HLOGC(mglog.Debug,
+              log << "worker: RECEIVED PACKET --> updateConnStatus. cst=" << ConnectStatusStr(cst) << " id=" << id
+                  << " pkt-payload-size=" << unit->m_Packet.getLength());
+    }
 
-        // XXX updateConnStatus may have removed the connector from the list,
-        // however there's still m_mBuffer in CRcvQueue for that socket to care about.
+    // Check connection requests status for all sockets in the RendezvousQueue.
+    // Pass the connection status from the last call of:
+    // worker_ProcessAddressedPacket --->
+    // worker_TryAsyncRend_OrStore --->
+    // CUDT::processAsyncConnectResponse --->
+    // CUDT::processConnectResponse
+    m_pRendezvousQueue->updateConnStatus(rst, cst, unit->m_Packet);
+
+    // Release the units not used for a while. No unit is being read
+    // into now, unless there are packets of a batch left to dispatch.
+    if (m_iBatchNext >= m_iBatchFill && m_UnitQueue.shrink() > 0)
+    {
+        // The units kept from the last read may have been released.
+        std::fill(m_vBatchUnit.begin(), m_vBatchUnit.end(), (CUnit*)NULL);
+        unit = m_UnitQueue.getNextAvailUnit();
     }
 
-    THREAD_EXIT();
-    return NULL;
+    // XXX updateConnStatus may have removed the connector from the list,
+    // however there's still m_mBuffer in CRcvQueue for that socket to care about.
+
+    return rst;
 }
 
 EReadStatus CRcvQueue::worker_RetrieveUnit(int32_t& w_id, CUnit*& w_unit, sockaddr_any& w_addr)
@@ -1258,25 +2005,18 @@ EReadStatus CRcvQueue::worker_RetrieveUnit(int32_t& w_id, CUnit*& w_unit, sockad
             m_pHash->insert(ne->m_SocketID, ne);
         }
     }
+
+    // Send the due packets before waiting for the incoming ones.
+    if (m_pSndQueue)
+        worker_SendDue();
+
+    if (m_iRecvBatchSize > 1)
+        return worker_RetrieveBatchUnit((w_id), (w_unit), (w_addr));
+
     // find next available slot for incoming packet
     w_unit = m_UnitQueue.getNextAvailUnit();
     if (!w_unit)
-    {
-        // no space, skip this packet
-        CPacket temp;
-        temp.m_pcData = new char[m_iPayloadSize];
-        temp.setLength(m_iPayloadSize);
-        THREAD_PAUSED();
-        EReadStatus rst = m_pChannel->recvfrom((w_addr), (temp));
-        THREAD_RESUMED();
-        // Note: this will print nothing about the packet details unless heavy logging is on.
-        LOGC(mglog.Error, log << CONID() << "LOCAL STORAGE DEPLETED. Dropping 1 packet: " << temp.Info());
-        delete[] temp.m_pcData;
-
-        // Be transparent for RST_ERROR, but ignore the correct
-        // data read and fake that the packet was dropped.
-        return rst == RST_ERROR ? RST_ERROR : RST_AGAIN;
-    }
+        return worker_DropPacket((w_addr));
 
     w_unit->m_Packet.setLength(m_iPayloadSize);
 
@@ -1287,14 +2027,326 @@ EReadStatus CRcvQueue::worker_RetrieveUnit(int32_t& w_id, CUnit*& w_unit, sockad
 
     if (rst == RST_OK)
     {
+        const bool timed = !is_zero(w_unit->m_Packet.m_tsArrival);
+        if (!timed)
+            w_unit->m_Packet.m_tsArrival = steady_clock::now();
         w_id = w_unit->m_Packet.m_iID;
         HLOGC(mglog.Debug, log << "INCOMING PACKET: FROM=" << SockaddrToString(w_addr)
                 << " BOUND=" << SockaddrToString(m_pChannel->bindAddressAny())
                 << " " << w_unit->m_Packet.Info());
+        worker_CountReceived(1, timed);
     }
     return rst;
 }
 
+// Returns the next packet from the current batch, reading a new
+// batch first when all packets from the previous one have been
+// dispatched already.
+EReadStatus CRcvQueue::worker_RetrieveBatchUnit(int32_t& w_id, CUnit*& w_unit, sockaddr_any& w_addr)
+{
+    if (m_iBatchNext >= m_iBatchFill)
+    {
+        const EReadStatus rst = worker_ReadBatch();
+        if (rst != RST_OK)
+        {
+            // The caller refers to the unit's packet also when nothing was read.
+            if (m_vBatchUnit[0])
+                w_unit = m_vBatchUnit[0];
+            return rst;
+        }
+    }
+
+    while (m_iBatchNext < m_iBatchFill)
+    {
+        const int i = m_iBatchNext++;
+        CUnit* unit = m_vBatchUnit[i];
+
+        // The unit has been reserved for reading. Now give it back to
+        // the unit queue; the packet dispatching code takes it again
+        // if the packet gets stored in the receiver buffer.
+        m_UnitQueue.makeUnitFree(unit);
+        w_unit = unit;
+
+        if (m_vBatchStatus[i] != RST_OK)
+            continue;
+
+        w_addr = m_vBatchAddr[i];
+        w_id = unit->m_Packet.m_iID;
+        HLOGC(mglog.Debug, log << "INCOMING PACKET: FROM=" << SockaddrToString(w_addr)
+                << " BOUND=" << SockaddrToString(m_pChannel->bindAddressAny())
+                << " " << unit->m_Packet.Info()
+                << " (batch " << (i + 1) << "/" << m_iBatchFill << ")");
+        return RST_OK;
+    }
+
+    // All packets in this batch were rejected by the channel.
+    return RST_AGAIN;
+}
+
+EReadStatus CRcvQueue::worker_ReadBatch()
+{
+    if (!m_vPostedUnit.empty())
+        return worker_ReadPosted();
+
+    m_iBatchFill = 0;
+    m_iBatchNext = 0;
+
+    // Reserve the units up front. Each one is marked as occupied so that
+    // getNextAvailUnit() doesn't return the same unit again.
+    int reserved = 0;
+    for (; reserved < m_iRecvBatchSize; ++reserved)
+    {
+        CUnit* unit = m_UnitQueue.getNextAvailUnit();
+        if (!unit)
+            break;
+
+        m_UnitQueue.makeUnitGood(unit);
+        unit->m_Packet.setLength(m_iPayloadSize);
+        m_vBatchUnit[reserved] = unit;
+        m_vBatchPacket[reserved] = &unit->m_Packet;
+    }
+
+    if (reserved == 0)
+    {
+        sockaddr_any addr(m_UnitQueue.getIPversion());
+        return worker_DropPacket((addr));
+    }
+
+    int count = 0;
+    THREAD_PAUSED();
+    const EReadStatus rst = m_pChannel->recvmmsg(&m_vBatchAddr[0], &m_vBatchPacket[0], &m_vBatchStatus[0], reserved,
+            (count));
+    THREAD_RESUMED();
+
+    // Return the units that haven't been filled.
+    for (int i = count; i < reserved; ++i)
+        m_UnitQueue.makeUnitFree(m_vBatchUnit[i]);
+
+    worker_FinishBatch(count);
+    return rst;
+}
+
+// Same as worker_ReadBatch(), but with the receives posted to the channel's
+// ring. A unit stays reserved for its slot until the receive completes and
+// then the slot gets a new unit.
+EReadStatus CRcvQueue::worker_ReadPosted()
+{
+    m_iBatchFill = 0;
+    m_iBatchNext = 0;
+
+    int posted = 0;
+    for (int slot = 0; slot < m_iRecvBatchSize; ++slot)
+    {
+        if (!m_vPostedUnit[slot])
+        {
+            CUnit* unit = m_UnitQueue.getNextAvailUnit();
+            if (!unit)
+                continue;
+
+            m_UnitQueue.makeUnitGood(unit);
+            unit->m_Packet.setLength(m_iPayloadSize);
+            m_vPostedUnit[slot] = unit;
+            m_pChannel->postRecv(slot, unit->m_Packet);
+        }
+        ++posted;
+    }
+
+    if (posted == 0)
+    {
+        sockaddr_any addr(m_UnitQueue.getIPversion());
+        return worker_DropPacket((addr));
+    }
+
+    int count = 0;
+    THREAD_PAUSED();
+    const EReadStatus rst = m_pChannel->recvPosted(&m_vBatchSlot[0], &m_vBatchAddr[0], &m_vBatchStatus[0],
+            m_iRecvBatchSize, (count));
+    THREAD_RESUMED();
+
+    for (int i = 0; i < count; ++i)
+    {
+        const int slot = m_vBatchSlot[i];
+        m_vBatchUnit[i] = m_vPostedUnit[slot];
+        m_vPostedUnit[slot] = NULL;
+    }
+
+    worker_FinishBatch(count);
+    return rst;
+}
+
+void CRcvQueue::worker_FinishBatch(int count)
+{
+    // Packets without the arrival time reported by the system get the
+    // time of reading, as with recvfrom(), the same for the whole batch.
+    const steady_clock::time_point now = steady_clock::now();
+    int timed = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        CPacket& packet = m_vBatchUnit[i]->m_Packet;
+        if (!is_zero(packet.m_tsArrival))
+            ++timed;
+        else
+            packet.m_tsArrival = now;
+    }
+
+    if (count > 0)
+        worker_CountReceived(count, timed, m_pChannel->getGRO() && count > 1);
+
+    m_iBatchFill = count;
+}
+
+EReadStatus CRcvQueue::worker_DropPacket(sockaddr_any& w_addr)
+{
+    // no space, skip this packet
+    CPacket temp;
+    temp.m_pcData = new char[m_iPayloadSize];
+    temp.setLength(m_iPayloadSize);
+    THREAD_PAUSED();
+    EReadStatus rst = m_pChannel->recvfrom((w_addr), (temp));
+    THREAD_RESUMED();
+    // Note: this will print nothing about the packet details unless heavy logging is on.
+    LOGC(mglog.Error, log << CONID() << "LOCAL STORAGE DEPLETED. Dropping 1 packet: " << temp.Info());
+    delete[] temp.m_pcData;
+
+    // Be transparent for RST_ERROR, but ignore the correct
+    // data read and fake that the packet was dropped.
+    return rst == RST_ERROR ? RST_ERROR : RST_AGAIN;
+}
+
+void CRcvQueue::worker_CountReceived(int count, int timed, bool coalesced)
+{
+    ScopedLock lg(m_StatsLock);
+    ++m_llBatchCallsTotal;
+    m_llBatchPktsTotal += count;
+    m_iBatchMaxDepth = std::max(m_iBatchMaxDepth, count);
+    if (coalesced)
+        m_llCoalescedPktsTotal += count;
+    m_llTimedPktsTotal += timed;
+}
+
+void CRcvQueue::getBatchStats(int64_t& w_calls, int64_t& w_pkts, int& w_maxdepth, int64_t& w_coalesced,
+        int64_t& w_timed)
+{
+    ScopedLock lg(m_StatsLock);
+    w_calls     = m_llBatchCallsTotal;
+    w_pkts      = m_llBatchPktsTotal;
+    w_maxdepth  = m_iBatchMaxDepth;
+    w_coalesced = m_llCoalescedPktsTotal;
+    w_timed     = m_llTimedPktsTotal;
+}
+
+void CRcvQueue::worker_CountTimerChecks(int count, const steady_clock::time_point& now)
+{
+    m_llTimerChecksPeriod += count;
+
+    const bool period_over = now - m_tsTimerChecksSince >= seconds_from(1);
+    if (count == 0 && !period_over)
+        return;
+
+    ScopedLock lg(m_StatsLock);
+    m_llTimerChecksTotal += count;
+    if (period_over)
+    {
+        // checks per second over the last period of at least a second
+        m_iTimerChecksRate    = int(m_llTimerChecksPeriod * 1000000 / count_microseconds(now - m_tsTimerChecksSince));
+        m_llTimerChecksPeriod = 0;
+        m_tsTimerChecksSince  = now;
+    }
+}
+
+// In single-thread mode: sends a batch of the packets that are due and
+// limits the wait for the incoming packets to when the next ones are due.
+void CRcvQueue::worker_SendDue()
+{
+    if (m_bPolled)
+    {
+        m_pSndQueue->sendDue();
+        return;
+    }
+
+    // From now on a socket scheduled earlier by another thread wakes up the wait.
+    m_pChannel->beginWait();
+    const steady_clock::time_point next_time = m_pSndQueue->sendDue();
+
+    int64_t timeout_us = CChannel::DEF_RECV_TIMEOUT_US;
+    if (!is_zero(next_time))
+        timeout_us = std::max<int64_t>(0, std::min(timeout_us, count_microseconds(next_time - steady_clock::now())));
+    m_pChannel->setRecvTimeout(int(timeout_us));
+}
+
+int CRcvQueue::process()
+{
+    SRT_ASSERT(m_bPolled);
+    ScopedLock lg(m_PollLock);
+
+    int received = 0;
+    while (received < MAX_PROCESS_PACKETS && !m_bClosing)
+    {
+        const EReadStatus rst = worker_Iterate();
+        if (rst == RST_ERROR)
+            return -1;
+        if (rst == RST_AGAIN)
+            break;
+        ++received;
+    }
+    return received;
+}
+
+steady_clock::time_point CRcvQueue::nextDeadline()
+{
+    ScopedLock lg(m_PollLock);
+    const steady_clock::time_point now = steady_clock::now();
+
+    // Packets of the last batch still to be dispatched, or sockets to be added
+    if (m_iBatchNext < m_iBatchFill || ifNewEntry())
+        return now;
+
+    // The worker thread checks everything at least that often.
+    steady_clock::time_point deadline = now + microseconds_from(CChannel::DEF_RECV_TIMEOUT_US);
+
+    const steady_clock::time_point times[] = {
+        m_pSndQueue ? m_pSndQueue->nextDue() : steady_clock::time_point(),
+        m_pRcvUList->nextTime(),
+        m_pRendezvousQueue->nextTime()
+    };
+    for (size_t i = 0; i < sizeof times / sizeof times[0]; ++i)
+    {
+        if (!is_zero(times[i]) && times[i] < deadline)
+            deadline = times[i];
+    }
+    return deadline;
+}
+
+bool CRcvQueue::removePolled(CUDT* u)
+{
+    // The GC calls it with the global control lock held, which process()
+    // may need as well, so it only tries.
+    if (!m_bPolled || !tryEnterCS(m_PollLock))
+        return false;
+
+    {
+        ScopedLock listguard(m_IDLock);
+        m_vNewEntry.erase(std::remove(m_vNewEntry.begin(), m_vNewEntry.end(), u), m_vNewEntry.end());
+    }
+
+    if (u->m_pRNode->m_bOnList)
+    {
+        m_pHash->remove(u->m_SocketID);
+        m_pRcvUList->remove(u);
+        u->m_pRNode->m_bOnList = false;
+    }
+
+    leaveCS(m_PollLock);
+    return true;
+}
+
+void CRcvQueue::getTimerStats(int64_t& w_checks, int& w_rate)
+{
+    ScopedLock lg(m_StatsLock);
+    w_checks = m_llTimerChecksTotal;
+    w_rate   = m_iTimerChecksRate;
+}
+
 EConnectStatus CRcvQueue::worker_ProcessConnectionRequest(CUnit* unit, const sockaddr_any& addr)
 {
     HLOGC(mglog.Debug,
@@ -1312,7 +2364,7 @@ EConnectStatus CRcvQueue::worker_ProcessConnectionRequest(CUnit* unit, const soc
         {
             LOGC(mglog.Note,
                  log << "PASSING request from: " << SockaddrToString(addr) << " to agent:" << m_pListener->socketID());
-            listener_ret = m_pListener->processConnectRequest(addr, unit->m_Packet);
+            listener_ret = m_pListener->processConnectRequest(addr, unit->m_Packet, this);
 
             // This function does return a code, but it's hard to say as to whether
             // anything can be done about it. In case when it's stated possible, the
@@ -1379,7 +2431,7 @@ EConnectStatus CRcvQueue::worker_ProcessAddressedPacket(int32_t id, CUnit* unit,
         u->processData(unit);
 
     u->checkTimers();
-    m_pRcvUList->update(u);
+    m_pRcvUList->update(u, u->getNextTimerTime(steady_clock::now()));
 
     return CONN_RUNNING;
 }
@@ -1442,7 +2494,7 @@ EConnectStatus CRcvQueue::worker_TryAsyncRend_OrStore(int32_t id, CUnit* unit, c
         if (cst == CONN_CONFUSED)
         {
             LOGC(mglog.Warn, log << "AsyncOrRND: PACKET NOT HANDSHAKE - re-requesting handshake from peer");
-            storePkt(id, unit->m_Packet.clone());
+            storePkt(id, unit);
             if (!u->processAsyncConnectRequest(RST_AGAIN, CONN_CONTINUE, unit->m_Packet, u->m_PeerAddr))
             {
                 // Reuse previous behavior to reject a packet
@@ -1517,7 +2569,7 @@ EConnectStatus CRcvQueue::worker_TryAsyncRend_OrStore(int32_t id, CUnit* unit, c
           log << "AsyncOrRND: packet RESOLVED TO ID=" << id << " -- continuing through CENTRAL PACKET QUEUE");
     // This is where also the packets for rendezvous connection will be landing,
     // in case of a synchronous connection.
-    storePkt(id, unit->m_Packet.clone());
+    storePkt(id, unit);
 
     return CONN_CONTINUE;
 }
@@ -1544,7 +2596,7 @@ int CRcvQueue::recvfrom(int32_t id, CPacket& w_packet)
     UniqueLock bufferlock (m_BufferLock);
     CSync buffercond    (m_BufferCond, bufferlock);
 
-    map<int32_t, std::queue<CPacket *> >::iterator i = m_mBuffer.find(id);
+    map<int32_t, std::queue<CUnit *> >::iterator i = m_mBuffer.find(id);
 
     if (i == m_mBuffer.end())
     {
@@ -1559,9 +2611,10 @@ int CRcvQueue::recvfrom(int32_t id, CPacket& w_packet)
     }
 
     // retrieve the earliest packet
-    CPacket *newpkt = i->second.front();
+    CUnit *unit = i->second.front();
+    const CPacket& newpkt = unit->m_Packet;
 
-    if (w_packet.getLength() < newpkt->getLength())
+    if (w_packet.getLength() < newpkt.getLength())
     {
         w_packet.setLength(-1);
         return -1;
@@ -1570,17 +2623,11 @@ int CRcvQueue::recvfrom(int32_t id, CPacket& w_packet)
     // copy packet content
     // XXX Check if this wouldn't be better done by providing
     // copy constructor for DynamicStruct.
-    // XXX Another thing: this looks wasteful. This expects an already
-    // allocated memory on the packet, this thing gets the packet,
-    // copies it into the passed packet and then the source packet
-    // gets deleted. Why not simply return the originally stored packet,
-    // without copying, allocation and deallocation?
-    memcpy((w_packet.m_nHeader), newpkt->m_nHeader, CPacket::HDR_SIZE);
-    memcpy((w_packet.m_pcData), newpkt->m_pcData, newpkt->getLength());
-    w_packet.setLength(newpkt->getLength());
-
-    delete[] newpkt->m_pcData;
-    delete newpkt;
+    memcpy((w_packet.m_nHeader), newpkt.m_nHeader, CPacket::HDR_SIZE);
+    memcpy((w_packet.m_pcData), newpkt.m_pcData, newpkt.getLength());
+    w_packet.setLength(newpkt.getLength());
+
+    m_UnitQueue.makeUnitFree(unit);
 
     // remove this message from queue,
     // if no more messages left for this socket, release its data structure
@@ -1593,21 +2640,33 @@ int CRcvQueue::recvfrom(int32_t id, CPacket& w_packet)
 
 int CRcvQueue::setListener(CUDT *u)
 {
-    ScopedLock lslock(m_LSLock);
+    {
+        ScopedLock lslock(m_LSLock);
 
-    if (NULL != m_pListener)
-        return -1;
+        if (NULL != m_pListener)
+            return -1;
+
+        m_pListener = u;
+    }
+
+    // Connection requests may arrive at any of the sockets sharing the port.
+    if (m_pNextShard)
+        m_pNextShard->setListener(u);
 
-    m_pListener = u;
     return 0;
 }
 
 void CRcvQueue::removeListener(const CUDT *u)
 {
-    ScopedLock lslock(m_LSLock);
+    {
+        ScopedLock lslock(m_LSLock);
+
+        if (u == m_pListener)
+            m_pListener = NULL;
+    }
 
-    if (u == m_pListener)
-        m_pListener = NULL;
+    if (m_pNextShard)
+        m_pNextShard->removeListener(u);
 }
 
 void CRcvQueue::registerConnector(const SRTSOCKET& id, CUDT* u, const sockaddr_any& addr, const steady_clock::time_point& ttl)
@@ -1624,15 +2683,14 @@ void CRcvQueue::removeConnector(const SRTSOCKET &id, bool should_lock)
 
     ScopedLock bufferlock(m_BufferLock);
 
-    map<int32_t, std::queue<CPacket *> >::iterator i = m_mBuffer.find(id);
+    map<int32_t, std::queue<CUnit *> >::iterator i = m_mBuffer.find(id);
     if (i != m_mBuffer.end())
     {
         HLOGC(mglog.Debug,
               log << "removeConnector: ... and its packet queue with " << i->second.size() << " packets collected");
         while (!i->second.empty())
         {
-            delete[] i->second.front()->m_pcData;
-            delete i->second.front();
+            m_UnitQueue.makeUnitFree(i->second.front());
             i->second.pop();
         }
         m_mBuffer.erase(i);
@@ -1661,24 +2719,26 @@ CUDT *CRcvQueue::getNewEntry()
     return u;
 }
 
-void CRcvQueue::storePkt(int32_t id, CPacket *pkt)
+void CRcvQueue::storePkt(int32_t id, CUnit *unit)
 {
     UniqueLock bufferlock (m_BufferLock);
     CSync passcond    (m_BufferCond, bufferlock);
 
-    map<int32_t, std::queue<CPacket *> >::iterator i = m_mBuffer.find(id);
+    map<int32_t, std::queue<CUnit *> >::iterator i = m_mBuffer.find(id);
 
     if (i == m_mBuffer.end())
     {
-        m_mBuffer[id].push(pkt);
+        m_UnitQueue.makeUnitGood(unit);
+        m_mBuffer[id].push(unit);
         passcond.signal_locked(bufferlock);
     }
     else
     {
         // avoid storing too many packets, in case of malfunction or attack
-        if (i->second.size() > 16)
+        if (i->second.size() >= MAX_EARLY_PACKETS)
             return;
 
-        i->second.push(pkt);
+        m_UnitQueue.makeUnitGood(unit);
+        i->second.push(unit);
     }
 }
@@ -65,12 +65,30 @@ modified by
 #include <vector>
 
 class CUDT;
+struct CQEntry;
 
 struct CUnit
 {
    CPacket m_Packet;		// packet
    enum Flag { FREE = 0, GOOD = 1, PASSACK = 2, DROPPED = 3 };
    Flag m_iFlag;			// 0: free, 1: occupied, 2: msg read but not freed (out-of-order), 3: msg dropped
+
+   CUnit* m_pPrevFree;		// previous unit in the free list (valid only when FREE)
+   CUnit* m_pNextFree;		// next unit in the free list (valid only when FREE)
+   CQEntry* m_pEntry;		// the block of units this one belongs to
+};
+
+// A block of units allocated at once by CUnitQueue.
+struct CQEntry
+{
+   CUnit* m_pUnit;   // unit queue
+   char* m_pBuffer;  // data buffer
+   int m_iSize;      // size of each queue
+   int m_iUsed;      // number of units not free
+
+   srt::sync::steady_clock::time_point m_tsFreeSince; // since when all units are free
+
+   CQEntry* m_pNext;
 };
 
 class CUnitQueue
@@ -96,11 +114,24 @@ public:     // Storage size operations
 
    int increase();
 
-      /// Decrease (halve) the unit queue size.
-      /// @return 0: success, -1: failure.
+      /// Release the blocks of units that have been free for longer than
+      /// the hold-down period, as long as no more than half of the
+      /// remaining units are in use. The first block is never released.
+      /// This must be called by the thread that reads into the units.
+      /// @return number of units released.
 
    int shrink();
 
+      /// Set the time a block of units must remain free before it's released.
+      /// @param [in] hold hold-down period, negative to never release
+
+   void setHoldDown(const srt::sync::steady_clock::duration& hold) { m_tdHoldDown = hold; }
+
+      /// Set the allocation policy for the packet payloads. Must be called before init().
+      /// @param [in] policy one of SRT_BUFALLOC values
+
+   void setAllocPolicy(int policy) { m_iBufAlloc = policy; }
+
 public:
    int size() const     { return m_iSize - m_iCount; }
    int capacity() const { return m_iSize; }
@@ -108,37 +139,62 @@ public:
 public:     // Operations on units
 
       /// find an available unit for incoming packet.
+      /// The unit stays free until makeUnitGood() is called on it,
+      /// so subsequent calls return the same unit.
       /// @return Pointer to the available unit, NULL if not found.
 
    CUnit* getNextAvailUnit();
 
+      /// Return the unit to the free list. Can be called from any thread.
+
    void makeUnitFree(CUnit * unit);
 
+      /// Take the unit off the free list. The unit need not be the one
+      /// returned by the last getNextAvailUnit() call.
+
    void makeUnitGood(CUnit * unit);
 
 public:
    inline int getIPversion() const { return m_iIPversion; }
 
+      /// NUMA node the units are placed on, -1 if none.
+   inline int getNumaNode() const { return m_iNumaNode; }
+
+      /// Get the pool statistics.
+      /// @param [out] w_free number of units currently in the free list
+      /// @param [out] w_capacity total number of units
+      /// @param [out] w_grown number of times the pool has been increased
+      /// @param [out] w_released number of bytes released by shrinking
+
+   void getPoolStats(int& w_free, int& w_capacity, int64_t& w_grown, int64_t& w_released);
+
 private:
-   struct CQEntry
-   {
-      CUnit* m_pUnit;   // unit queue
-      char* m_pBuffer;  // data buffer
-      int m_iSize;      // size of each queue
+   static const int SHRINK_CHECK_INTERVAL_MS = 100;
 
-      CQEntry* m_pNext;
-   }
-   *m_pQEntry,          // pointer to the first unit queue
-   *m_pCurrQueue,       // pointer to the current available queue
-   *m_pLastQueue;       // pointer to the last unit queue
+   int increase_LOCKED();
+   void pushFree(CUnit* unit);
+   void unlinkFree(CUnit* unit);
 
-   CUnit* m_pAvailUnit; // recent available unit
+private:
+   CQEntry* m_pQEntry;    // pointer to the first unit queue
+   CQEntry* m_pLastQueue; // pointer to the last unit queue
+
+   CUnit* m_pFreeHead;  // most recently freed unit, the first one to be reused
 
    int m_iSize;         // total size of the unit queue, in number of packets
    int m_iCount;        // total number of valid (occupied) packets in the queue
+   int64_t m_llGrowTotal; // number of times the queue has been increased
+   int64_t m_llReleasedBytes; // memory released by shrinking the queue
+
+   srt::sync::steady_clock::duration m_tdHoldDown;        // time a block must be free before it's released
+   srt::sync::steady_clock::time_point m_tsNextShrinkCheck; // next time to look for blocks to release
+
+   srt::sync::Mutex m_FreeLock; // protects the free list and the counters
 
    int m_iMSS;          // unit buffer size
    int m_iIPversion;    // IP version
+   int m_iBufAlloc;     // allocation policy for the unit buffers (SRT_BUFALLOC)
+   int m_iNumaNode;     // NUMA node for the unit buffers, -1 if none
 
 private:
    CUnitQueue(const CUnitQueue&);
@@ -150,7 +206,130 @@ struct CSNode
    CUDT* m_pUDT;		// Pointer to the instance of CUDT socket
    srt::sync::steady_clock::time_point m_tsTimeStamp;
 
-   int m_iHeapLoc;		// location on the heap, -1 means not on the heap
+   int m_iHeapLoc;		// location on the heap or slot on the timing wheel, -1 means not scheduled
+
+   CSNode* m_pPrev;		// previous node in the same slot of the timing wheel
+   CSNode* m_pNext;		// next node in the same slot of the timing wheel
+};
+
+/// The order of the sockets of a sending queue by their next processing time.
+/// Not thread-safe: CSndUList serializes the access.
+class CSndSchedule
+{
+public:
+   virtual ~CSndSchedule() {}
+
+      /// Schedule a node that isn't scheduled yet.
+      /// @param [in] ts next processing time
+      /// @param [in] n node of the UDT instance
+      /// @return true if the node is now the first one to be processed
+
+   virtual bool insert(const srt::sync::steady_clock::time_point& ts, CSNode* n) = 0;
+
+      /// Remove a scheduled node.
+      /// @param [in] n node of the UDT instance
+
+   virtual void remove(CSNode* n) = 0;
+
+      /// Get the first node to be processed, if it's due by the given time.
+      /// @param [in] until time by which the node must be due
+      /// @return the node, or NULL if none is due
+
+   virtual CSNode* top(const srt::sync::steady_clock::time_point& until) = 0;
+
+      /// Get the time when the first node is to be processed.
+      /// @return the time (possibly earlier than the actual time of the node), or zero if nothing is scheduled
+
+   virtual srt::sync::steady_clock::time_point nextTime() const = 0;
+};
+
+/// Binary heap, O(log n) insertion and removal.
+class CSndHeap: public CSndSchedule
+{
+public:
+   CSndHeap();
+   ~CSndHeap();
+
+   bool insert(const srt::sync::steady_clock::time_point& ts, CSNode* n);
+   void remove(CSNode* n);
+   CSNode* top(const srt::sync::steady_clock::time_point& until);
+   srt::sync::steady_clock::time_point nextTime() const;
+
+private:
+
+   /// Doubles the size of the heap array.
+   ///
+   void realloc_();
+
+private:
+   CSNode** m_pHeap;			// The heap array
+   int m_iArrayLength;			// physical length of the array
+   int m_iLastEntry;			// position of last entry on the heap array
+
+private:
+   CSndHeap(const CSndHeap&);
+   CSndHeap& operator=(const CSndHeap&);
+};
+
+/// Hierarchical timing wheel with 1 us slots, O(1) insertion and removal.
+///
+/// Every level has 256 slots, each one covering 256 times the span of a slot
+/// of the level below. A node is kept on the lowest level on which its time
+/// falls into the current turn of the wheel, and moves down when the cursor
+/// reaches its slot on the higher level. The nodes in the slot of the cursor
+/// on the lowest level are due and processed in the order of insertion. The
+/// nodes beyond the reach of the highest level (about 71 minutes) wait on a
+/// separate list until the highest level turns over.
+class CSndWheel: public CSndSchedule
+{
+public:
+   CSndWheel();
+
+   bool insert(const srt::sync::steady_clock::time_point& ts, CSNode* n);
+   void remove(CSNode* n);
+   CSNode* top(const srt::sync::steady_clock::time_point& until);
+   srt::sync::steady_clock::time_point nextTime() const;
+
+private:
+   static const int LEVELS = 4;
+   static const int SLOT_BITS = 8;
+   static const int SLOTS = 1 << SLOT_BITS;
+   static const int OVERFLOW_LOC = LEVELS * SLOTS;  // location of the nodes beyond the reach of the wheel
+
+   uint64_t tick_(const srt::sync::steady_clock::time_point& ts) const;
+
+   /// Put the node in the slot matching its time, or the cursor's slot if it's overdue.
+   void place_(CSNode* n);
+
+   void link_(CSNode* n, int loc);
+   void unlink_(CSNode* n);
+
+   /// Find the first occupied slot on a level, starting from the given one.
+   /// @return the slot index or -1 if there's none
+   int findSlot_(int level, int from) const;
+
+   /// Find the next occupied slot after the cursor.
+   /// @param [out] w_tick the tick at which the slot begins
+   /// @return location of the slot, or -1 if the wheel is empty beyond the cursor
+   int nextSlot_(uint64_t& w_tick) const;
+
+   /// Move the cursor forward to the given tick, stopping at the first due node.
+   void advance_(uint64_t target);
+
+   /// Move the nodes of the slots that begin at the cursor to the lower levels.
+   void cascade_();
+
+private:
+   srt::sync::steady_clock::time_point m_tsOrigin;  // time of tick 0
+   uint64_t m_ullCursor;                            // current tick, in us since m_tsOrigin
+
+   CSNode* m_pHead[OVERFLOW_LOC + 1];               // first node in every slot (level * SLOTS + slot)
+   CSNode* m_pTail[OVERFLOW_LOC + 1];               // last node in every slot
+   uint64_t m_aOccupied[LEVELS][SLOTS / 64];        // bitmap of the non-empty slots on every level
+
+private:
+   CSndWheel(const CSndWheel&);
+   CSndWheel& operator=(const CSndWheel&);
 };
 
 class CSndUList
@@ -158,7 +337,8 @@ class CSndUList
 friend class CSndQueue;
 
 public:
-   CSndUList();
+   /// @param [in] sched the scheduler of the sockets (SRT_SNDSCHED)
+   explicit CSndUList(int sched = SRT_SNDSCHED_HEAP);
    ~CSndUList();
 
 public:
@@ -176,9 +356,13 @@ public:
       /// Retrieve the next packet and peer address from the first entry, and reschedule it in the queue.
       /// @param [out] addr destination address of the next packet
       /// @param [out] pkt the next packet to be sent
-      /// @return 1 if successfully retrieved, -1 if no packet found.
+      /// @param [out] departure time when the packet should leave (now, unless it's taken in advance)
+      /// @param [in] lead how far in advance of its scheduled time the packet may be taken
+      /// @return 1 if successfully retrieved, 0 if the first due socket had no packet to send
+      ///         (it's then removed from the list), -1 if no socket is due.
 
-   int pop(sockaddr_any& addr, CPacket& pkt);
+   int pop(sockaddr_any& addr, CPacket& pkt, srt::sync::steady_clock::time_point& departure,
+           const srt::sync::steady_clock::duration& lead);
 
       /// Remove UDT instance from the list.
       /// @param [in] u pointer to the UDT instance
@@ -192,29 +376,21 @@ public:
 
 private:
 
-   /// Doubles the size of the list.
-   ///
-   void realloc_();
-
-   /// Insert a new UDT instance into the list with realloc if required.
+   /// Insert a new UDT instance into the list.
    ///
    /// @param [in] ts time stamp: next processing time
    /// @param [in] u pointer to the UDT instance
-   void insert_(const srt::sync::steady_clock::time_point &ts, const CUDT* u);
+   /// @param [in] notify wake up the sending worker if it has to send earlier
+   void insert_(const srt::sync::steady_clock::time_point &ts, const CUDT* u, bool notify = true);
 
-   /// Insert a new UDT instance into the list without realloc.
-   /// Should be called if there is a gauranteed space for the element.
-   ///
-   /// @param [in] ts time stamp: next processing time
-   /// @param [in] u pointer to the UDT instance
-   void insert_norealloc_(const srt::sync::steady_clock::time_point &ts, const CUDT* u);
+   void remove_(const CUDT* u, bool notify = true);
 
-   void remove_(const CUDT* u);
+   /// Make the sending worker check the list again.
+   void wakeup_();
 
 private:
-   CSNode** m_pHeap;			// The heap array
-   int m_iArrayLength;			// physical length of the array
-   int m_iLastEntry;			// position of last entry on the heap array
+   CSndSchedule* m_pSchedule;		// the order of the sockets
+   int m_iLastEntry;			// number of scheduled sockets less one
 
    srt::sync::Mutex m_ListLock;
 
@@ -222,23 +398,21 @@ private:
    srt::sync::Condition* m_pWindowCond;
 
    srt::sync::CTimer* m_pTimer;
+   CChannel* m_pWakeChannel;		// channel whose receiving thread sends the packets, in single-thread mode
 
 private:
    CSndUList(const CSndUList&);
    CSndUList& operator=(const CSndUList&);
 };
 
-struct CRNode
+struct CRNode: public CSNode
 {
-   CUDT* m_pUDT;                // Pointer to the instance of CUDT socket
-   srt::sync::steady_clock::time_point m_tsTimeStamp;      // Time Stamp
-
-   CRNode* m_pPrev;             // previous link
-   CRNode* m_pNext;             // next link
-
    bool m_bOnList;              // if the node is already on the list
 };
 
+/// The sockets served by a receiving queue, ordered by the time when their
+/// timers (ACK, NAK, EXP, retransmission, keepalive) have to be checked next.
+/// Only the thread of the receiving queue may access it.
 class CRcvUList
 {
 public:
@@ -247,7 +421,7 @@ public:
 
 public:
 
-      /// Insert a new UDT instance to the list.
+      /// Insert a new UDT instance to the list, with the timers due at once.
       /// @param [in] u pointer to the UDT instance
 
    void insert(const CUDT* u);
@@ -257,22 +431,35 @@ public:
 
    void remove(const CUDT* u);
 
-      /// Move the UDT instance to the end of the list, if it already exists; otherwise, do nothing.
+      /// Set the time of the next check of the UDT instance, if it's on the list; otherwise, do nothing.
       /// @param [in] u pointer to the UDT instance
+      /// @param [in] ts time when the timers of the UDT instance have to be checked
 
-   void update(const CUDT* u);
+   void update(const CUDT* u, const srt::sync::steady_clock::time_point& ts);
 
-public:
-   CRNode* m_pUList;		// the head node
+      /// Retrieve a UDT instance whose timers are due. It stays on the list
+      /// and has to be updated or removed before the next call.
+      /// @param [in] now current time
+      /// @return pointer to the UDT instance, or NULL if none is due
+
+   CUDT* next(const srt::sync::steady_clock::time_point& now);
+
+      /// Time when the timers of the first UDT instance have to be checked, or zero if the list is empty.
+
+   srt::sync::steady_clock::time_point nextTime() { return m_Timers.nextTime(); }
 
 private:
-   CRNode* m_pLast;		// the last node
+   CSndWheel m_Timers;          // the nodes by the time of the next check
 
 private:
    CRcvUList(const CRcvUList&);
    CRcvUList& operator=(const CRcvUList&);
 };
 
+// Socket lookup table: open addressing with linear probing, so that a
+// lookup reads consecutive slots instead of chasing pointers. It is used
+// by the receiving thread of the multiplexer only (or under its polling
+// lock, without threads), so it takes no lock.
 class CHash
 {
 public:
@@ -282,7 +469,7 @@ public:
 public:
 
       /// Initialize the hash table.
-      /// @param [in] size hash table size
+      /// @param [in] size expected number of entries (the table grows when needed)
 
    void init(int size);
 
@@ -290,9 +477,9 @@ public:
       /// @param [in] id socket ID
       /// @return Pointer to a UDT instance, or NULL if not found.
 
-   CUDT* lookup(int32_t id);
+   CUDT* lookup(int32_t id) const;
 
-      /// Insert an entry to the hash table.
+      /// Insert an entry to the hash table. An existing entry with the same ID is replaced.
       /// @param [in] id socket ID
       /// @param [in] u pointer to the UDT instance
 
@@ -303,22 +490,51 @@ public:
 
    void remove(int32_t id);
 
+      /// Number of entries in the table.
+
+   int size() const { return m_iCount; }
+
+      /// Number of slots in the current table.
+
+   int capacity() const;
+
 private:
-   struct CBucket
+   static const int32_t SLOT_EMPTY = 0;      // never used slot, ends the probing
+   static const int32_t SLOT_REMOVED = -1;   // slot of a removed entry, continues the probing
+   static const int MIN_CAPACITY = 16;
+
+   struct CSlot
    {
-      int32_t m_iID;		// Socket ID
-      CUDT* m_pUDT;		// Socket instance
+      int32_t m_iID;           // Socket ID, or SLOT_EMPTY/SLOT_REMOVED
+      CUDT* m_pUDT;            // Socket instance
+   };
 
-      CBucket* m_pNext;		// next bucket
-   } **m_pBucket;		// list of buckets (the hash table)
+   struct CTable
+   {
+      CSlot* m_pSlot;          // slots, a power of 2 of them
+      uint32_t m_uMask;        // number of slots - 1
+      int m_iShift;            // 32 - log2(number of slots)
+   };
 
-   int m_iHashSize;		// size of hash table
+   static CTable* newTable(int capacity);
+   static void deleteTable(CTable* t);
+   static uint32_t slotOf(const CTable* t, int32_t id);
+
+   void rehash(int capacity);
+
+   CTable* m_pTable;                    // current table
+   int m_iCount;                        // number of entries
+   int m_iRemoved;                      // number of slots of removed entries
 
 private:
    CHash(const CHash&);
    CHash& operator=(const CHash&);
 };
 
+/// The sockets connecting in asynchronous or rendezvous mode. They are found
+/// by the socket ID and by the peer address of an incoming handshake, and
+/// are visited when their next handshake is due or their TTL passes, so that
+/// an update does not have to go through all of them.
 class CRendezvousQueue
 {
 public:
@@ -338,19 +554,54 @@ public:
 
    void updateConnStatus(EReadStatus rst, EConnectStatus, const CPacket& response);
 
+   /// Time of the next visit of a connector, or zero if there are none.
+   srt::sync::steady_clock::time_point nextTime();
+
 private:
-   struct CRL
+   struct CRL: public CSNode
    {
       SRTSOCKET m_iID;        // UDT socket ID (self)
-      CUDT* m_pUDT;           // UDT instance
       sockaddr_any m_PeerAddr;// UDT sonnection peer address
       srt::sync::steady_clock::time_point m_tsTTL;    // the time that this request expires
    };
-   std::list<CRL> m_lRendezvousID;    // The sockets currently in rendezvous mode
+
+   // Orders the addresses by family, port and address, the fields
+   // compared by sockaddr_any::Equal.
+   struct AddrLess
+   {
+      bool operator()(const sockaddr_any& a1, const sockaddr_any& a2) const;
+   };
+
+   typedef std::map<SRTSOCKET, CRL> connectors_t;
+   typedef std::multimap<sockaddr_any, SRTSOCKET, AddrLess> addr_index_t;
+
+   /// Schedule the next visit of the connector, when it should send
+   /// the next handshake or its TTL passes, whichever comes first.
+   void schedule_(CRL& r);
+
+   /// Check the TTL of the connector and send the next handshake.
+   /// The connector may be removed from the queue by the call.
+   void process_(CRL& r, EReadStatus rst, EConnectStatus cst, const CPacket& response);
+
+   connectors_t m_mRendezvousID;      // The sockets currently in rendezvous mode
+   addr_index_t m_mPeerAddr;          // IDs of the sockets by the peer address, in the order of insertion
+   CSndWheel m_Deadlines;             // The sockets by the time of the next visit
 
    srt::sync::Mutex m_RIDVectorLock;
 };
 
+// A user data block sent without copying (srt_sendmsg_zc), to be given
+// back to the application.
+struct CSndRelease
+{
+   srt_send_release_fn* m_pRelease;
+   void* m_pOpaque;
+   const char* m_pcData;
+   int m_iLength;
+
+   void call() const { m_pRelease(m_pOpaque, m_pcData, m_iLength); }
+};
+
 class CSndQueue
 {
 friend class CUDT;
@@ -371,8 +622,12 @@ public:
       /// Initialize the sending queue.
       /// @param [in] c UDP channel to be associated to the queue
       /// @param [in] t Timer
+      /// @param [in] batch maximum number of packets sent in one system call
+      /// @param [in] sched the scheduler of the sockets (SRT_SNDSCHED)
+      /// @param [in] thread start the worker thread; otherwise the receiving
+      ///        thread of the channel sends the packets by calling sendDue()
 
-   void init(CChannel* c, srt::sync::CTimer* t);
+   void init(CChannel* c, srt::sync::CTimer* t, int batch = 1, int sched = SRT_SNDSCHED_HEAP, bool thread = true);
 
       /// Send out a packet to a given address.
       /// @param [in] addr destination address
@@ -400,10 +655,53 @@ public:
        m_bClosing = true;
    }
 
+   int getSendBatchSize() const { return m_iSendBatchSize; }
+
+      /// Get the statistics of batched sending.
+      /// @param [out] w_calls number of system calls used to send data packets
+      /// @param [out] w_pkts number of data packets sent
+      /// @param [out] w_maxdepth maximum number of packets sent in one system call
+      /// @param [out] w_segmented number of data packets sent with UDP segmentation offload
+      /// @param [out] w_timed number of data packets sent with a departure time (SO_TXTIME)
+
+   void getBatchStats(int64_t& w_calls, int64_t& w_pkts, int& w_maxdepth, int64_t& w_segmented, int64_t& w_timed);
+
+      /// Get the utilization of this sending worker of the multiplexer.
+      /// @param [out] w_shard index of this worker in the multiplexer
+      /// @param [out] w_sockets number of sockets served by this worker
+      /// @param [out] w_busy time spent on collecting and sending packets, in microseconds
+      /// @param [out] w_sched scheduler of the sockets (SRT_SNDSCHED_*)
+
+   void getShardStats(int& w_shard, int& w_sockets, int64_t& w_busy, int& w_sched);
+
+      /// Send one batch of the packets that are due, in place of the worker thread.
+      /// @return time when the next packets are due, or zero if no socket has any to send
+
+   srt::sync::steady_clock::time_point sendDue();
+
+      /// Time when the next packets are due to be sent, or zero if no socket has any to send.
+
+   srt::sync::steady_clock::time_point nextDue();
+
+      /// Give the user data blocks back to the application. The packets of
+      /// the batch being collected or sent may still point to them, so if there
+      /// is one, this is done when it's sent. Call without any lock held.
+      /// @param [in] done the blocks no longer in the sender buffer
+
+   void release(const std::vector<CSndRelease>& done);
+
 private:
    static void* worker(void* param);
    srt::sync::CThread m_WorkerThread;
 
+   // Subroutines of worker
+   int worker_CollectBatch();
+   void worker_SendBatch(int size, const srt::sync::steady_clock::time_point& busy_since);
+   void worker_EndBatch();
+
+   int getSocketCount();
+   void updateSocketCount(int delta);
+
 private:
    CSndUList* m_pSndUList;              // List of UDT instances for data sending
    CChannel* m_pChannel;                // The UDP channel for data sending
@@ -414,6 +712,35 @@ private:
 
    volatile bool m_bClosing;            // closing the worker
 
+   int m_iSendBatchSize;                // maximum number of packets sent in one system call
+   CPacket* m_pBatchPacket;             // packets collected for the current batch
+   sockaddr_any* m_pBatchAddr;          // destination addresses of the collected packets
+   char* m_pBatchPayload;               // copies of packet filter control payloads
+   srt::sync::steady_clock::time_point* m_pBatchDeparture; // departure times of the collected packets
+   bool m_bKernelPacing;                // the kernel paces the packets by their departure time (SO_TXTIME)
+   srt::sync::steady_clock::duration m_tdPacingLead; // how far in advance the packets are handed over to the kernel
+   CIOUring* m_pSendRing;               // io_uring for sending the batches, if in use (owned by the channel)
+
+   // With kernel pacing, the packets are handed over this much
+   // before their departure time.
+   static const int PACING_LEAD_US = 2000;
+
+   srt::sync::Mutex m_StatsLock;
+   int64_t m_llBatchCallsTotal;         // number of system calls used to send data packets
+   int64_t m_llBatchPktsTotal;          // number of data packets sent
+   int m_iBatchMaxDepth;                // maximum number of packets sent in one system call
+   int64_t m_llSegmentedPktsTotal;      // number of data packets sent with segmentation offload
+   int64_t m_llTimedPktsTotal;          // number of data packets sent with a departure time
+   int64_t m_llBusyTime;                // time spent on collecting and sending packets, in microseconds
+
+   int m_iShard;                        // index of this worker in the multiplexer
+   int m_iSocketCount;                  // number of sockets served by this worker
+   int m_iSched;                        // scheduler of the sockets (SRT_SNDSCHED_*)
+
+   srt::sync::Mutex m_ReleaseLock;
+   bool m_bInBatch;                     // a batch is being collected or sent
+   std::vector<CSndRelease> m_vReleases; // user data blocks to give back when the batch is sent
+
 #if defined(SRT_DEBUG_SNDQ_HIGHRATE)//>>debug high freq worker
    uint64_t m_ullDbgPeriod;
    uint64_t m_ullDbgTime;
@@ -460,8 +787,34 @@ public:
       /// @param [in] hsize hash table size
       /// @param [in] c UDP channel to be associated to the queue
       /// @param [in] t timer
+      /// @param [in] batch maximum number of packets read in one system call
+      /// @param [in] sndq sending queue without a thread, whose packets this queue's worker sends
+      /// @param [in] thread start the worker thread; otherwise the application calls process()
+
+   void init(int size, int payload, int version, int hsize, CChannel* c, srt::sync::CTimer* t, int batch = 1,
+             CSndQueue* sndq = NULL, bool thread = true);
+
+      /// Do once, without waiting, what the worker thread does: send the packets
+      /// that are due, dispatch the packets that have arrived and check the timers
+      /// and connectors that are due. For a queue without the worker thread only.
+      /// @return number of packets received, or -1 if the channel has failed
 
-   void init(int size, int payload, int version, int hsize, CChannel* c, srt::sync::CTimer* t);
+   int process();
+
+      /// Time when process() has to be called next, unless a packet arrives before.
+
+   srt::sync::steady_clock::time_point nextDeadline();
+
+      /// Check whether the application drives the queue with process().
+
+   bool isPolled() const { return m_bPolled; }
+
+      /// Take a closed socket off the queue driven by process(), which has no
+      /// worker to do it. Fails while process() is running, to be retried.
+      /// @param [in] u pointer to the UDT instance
+      /// @return true if the socket is not served by the queue anymore
+
+   bool removePolled(CUDT* u);
 
       /// Read a packet for a specific UDT socket id.
       /// @param [in] id Socket ID
@@ -477,11 +830,37 @@ public:
        m_bClosing = true;
    }
 
+   int getRecvBatchSize() const { return m_iRecvBatchSize; }
+
+      /// Get the statistics of batched receiving.
+      /// @param [out] w_calls number of system calls that delivered packets
+      /// @param [out] w_pkts number of packets received
+      /// @param [out] w_maxdepth maximum number of packets received in one system call
+      /// @param [out] w_coalesced number of packets received in datagrams coalesced by UDP receive offload
+      /// @param [out] w_timed number of packets received with the arrival time from the system
+
+   void getBatchStats(int64_t& w_calls, int64_t& w_pkts, int& w_maxdepth, int64_t& w_coalesced, int64_t& w_timed);
+
+      /// Get the statistics of the timer checks of the sockets.
+      /// @param [out] w_checks number of times the timers of a socket have been checked when due
+      /// @param [out] w_rate number of such checks per second, over the last second
+
+   void getTimerStats(int64_t& w_checks, int& w_rate);
+
 private:
    static void* worker(void* param);
    srt::sync::CThread m_WorkerThread;
    // Subroutines of worker
+   EReadStatus worker_Iterate();
    EReadStatus worker_RetrieveUnit(int32_t& id, CUnit*& unit, sockaddr_any& sa);
+   EReadStatus worker_RetrieveBatchUnit(int32_t& id, CUnit*& unit, sockaddr_any& sa);
+   EReadStatus worker_ReadBatch();
+   EReadStatus worker_ReadPosted();
+   void worker_FinishBatch(int count);
+   EReadStatus worker_DropPacket(sockaddr_any& sa);
+   void worker_CountReceived(int count, int timed, bool coalesced = false);
+   void worker_CountTimerChecks(int count, const srt::sync::steady_clock::time_point& now);
+   void worker_SendDue();
    EConnectStatus worker_ProcessConnectionRequest(CUnit* unit, const sockaddr_any& sa);
    EConnectStatus worker_TryAsyncRend_OrStore(int32_t id, CUnit* unit, const sockaddr_any& sa);
    EConnectStatus worker_ProcessAddressedPacket(int32_t id, CUnit* unit, const sockaddr_any& sa);
@@ -492,10 +871,41 @@ private:
    CHash* m_pHash;              // Hash table for UDT socket looking up
    CChannel* m_pChannel;        // UDP channel for receving packets
    srt::sync::CTimer* m_pTimer; // shared timer with the snd queue
+   CSndQueue* m_pSndQueue;      // sending queue served by the worker, in single-thread mode
+   bool m_bPolled;              // no worker thread, the application calls process()
 
    int m_iPayloadSize;          // packet payload size
 
+   CUnit* m_pWorkerUnit;                // unit of the last packet retrieved by the worker
+   EConnectStatus m_WorkerConnStatus;   // result of dispatching the last packet
+   static const int MAX_PROCESS_PACKETS = 256; // packets dispatched by one call of process()
+   srt::sync::Mutex m_PollLock;         // held by process(), so that removePolled() doesn't interfere
+
    volatile bool m_bClosing;    // closing the worker
+
+   int m_iRecvBatchSize;                    // maximum number of packets read in one system call
+   std::vector<CUnit*> m_vBatchUnit;        // units reserved for the current batch
+   std::vector<CPacket*> m_vBatchPacket;    // packets of the reserved units
+   std::vector<sockaddr_any> m_vBatchAddr;  // source addresses of the received packets
+   std::vector<EReadStatus> m_vBatchStatus; // receiving status of the received packets
+   int m_iBatchFill;                        // number of packets received in the current batch
+   int m_iBatchNext;                        // next packet of the current batch to be dispatched
+   std::vector<CUnit*> m_vPostedUnit;       // units with a receive posted to the channel's ring, by slot
+   std::vector<int> m_vBatchSlot;           // slots of the completed posted receives
+
+   srt::sync::Mutex m_StatsLock;
+   int64_t m_llBatchCallsTotal; // number of system calls that delivered packets
+   int64_t m_llBatchPktsTotal;  // number of packets received
+   int m_iBatchMaxDepth;        // maximum number of packets received in one system call
+   int64_t m_llCoalescedPktsTotal; // number of packets received in coalesced datagrams
+   int64_t m_llTimedPktsTotal;     // number of packets received with the arrival time from the system
+   int64_t m_llTimerChecksTotal;   // number of timer checks of the sockets when due
+   int m_iTimerChecksRate;         // timer checks per second, over the last second
+
+   // Counted by the worker, outside of the lock
+   int64_t m_llTimerChecksPeriod;  // timer checks since m_tsTimerChecksSince
+   srt::sync::steady_clock::time_point m_tsTimerChecksSince;
+
 #if ENABLE_LOGGING
    static int m_counter;
 #endif
@@ -511,17 +921,26 @@ private:
    bool ifNewEntry();
    CUDT* getNewEntry();
 
-   void storePkt(int32_t id, CPacket* pkt);
+      /// Keep a packet for a socket that is still connecting, until it's read by recvfrom().
+      /// The unit is taken from the unit queue and returned to it when the packet is read
+      /// or the connector is removed. At most MAX_EARLY_PACKETS are kept for a socket.
+      /// @param [in] id Socket ID
+      /// @param [in] unit the unit with the packet, as received by the worker
+
+   void storePkt(int32_t id, CUnit* unit);
 
 private:
    srt::sync::Mutex m_LSLock;
    CUDT* m_pListener;                                   // pointer to the (unique, if any) listening UDT entity
    CRendezvousQueue* m_pRendezvousQueue;                // The list of sockets in rendezvous mode
+   CRcvQueue* m_pNextShard;                             // next receive queue sharing the port with this one, if any
+   int m_iShard;                                        // index of this receive queue among those sharing the port
 
    std::vector<CUDT*> m_vNewEntry;                      // newly added entries, to be inserted
    srt::sync::Mutex m_IDLock;
 
-   std::map<int32_t, std::queue<CPacket*> > m_mBuffer;	// temporary buffer for rendezvous connection request
+   static const size_t MAX_EARLY_PACKETS = 16;
+   std::map<int32_t, std::queue<CUnit*> > m_mBuffer;	// temporary buffer for rendezvous connection request
    srt::sync::Mutex m_BufferLock;
    srt::sync::Condition m_BufferCond;
 
@@ -544,7 +963,37 @@ struct CMultiplexer
    int m_iMSS;          // Maximum Segment Size
    int m_iRefCount;     // number of UDT instances that are associated with this multiplexer
    int m_iIpV6Only;     // IPV6_V6ONLY option
+   int m_iSndBatch;     // maximum number of packets sent in one system call
+   int m_iRcvBatch;     // maximum number of packets received in one system call
+   bool m_bGSO;         // UDP segmentation offload for batched sending
+   bool m_bGRO;         // UDP receive offload
    bool m_bReusable;    // if this one can be shared with others
+   int m_iRcvShards;    // number of receiving sockets on the port for a listener
+
+   // Additional receiving sockets opened on the same port with SO_REUSEPORT
+   // when a listener starts, each with its own receive queue and worker.
+   // The m_pRcvQueue and m_pChannel above are the first shard.
+   std::vector<CRcvQueue*> m_vRcvShards;
+   std::vector<CChannel*> m_vShardChannels;
+   bool m_bRcvSteering; // the packets are delivered to the shards by the destination socket ID
+   int m_iSndShards;    // number of sending workers
+   bool m_bIOUring;     // io_uring for the UDP socket
+   bool m_bTxTime;      // kernel pacing of the sent packets
+   bool m_bTimestamp;   // arrival time of the received packets from the system
+   int m_iRcvPoolHold;  // time in ms the receiver units must be unused before they are released
+   int m_iBufAlloc;     // allocation policy for the receiver units (SRT_BUFALLOC)
+   int m_iSndSched;     // scheduler of the sockets in the sending queues (SRT_SNDSCHED)
+   bool m_bSingleThread; // the receiving worker sends the packets, there are no sending workers
+   bool m_bNoThreads;   // no workers at all, the application calls process() of the receiving queue
+
+   // Additional sending queues, each with its own worker, timer and list
+   // of sockets, all sending through m_pChannel. The m_pSndQueue above is
+   // the first one. A socket is assigned to the least loaded one.
+   std::vector<CSndQueue*> m_vSndShards;
+   std::vector<srt::sync::CTimer*> m_vSndShardTimers;
+
+   static const int MAX_RCV_SHARDS = 16;
+   static const int MAX_SND_SHARDS = 16;
 
    int m_iID;           // multiplexer ID
 };
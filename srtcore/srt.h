@@ -239,7 +239,22 @@ typedef enum SRT_SOCKOPT {
    SRTO_GROUPTYPE,           // Group type to which an accepted socket is about to be added, available in the handshake
    // (some space left)
    SRTO_PACKETFILTER = 60,   // Add and configure a packet filter
-   SRTO_RETRANSMISSION_ALGORITHM = 61 // An option to select packet retransmission algorithm
+   SRTO_RETRANSMISSION_ALGORITHM = 61, // An option to select packet retransmission algorithm
+   SRTO_UDP_SNDBATCH = 62,   // Maximum number of packets sent by the multiplexer in one system call
+   SRTO_UDP_RCVBATCH = 63,   // Maximum number of packets received by the multiplexer in one system call
+   SRTO_UDP_GSO = 64,        // Use UDP segmentation offload (Linux UDP_SEGMENT) for batched sending
+   SRTO_UDP_GRO = 65,        // Use UDP receive offload (Linux UDP_GRO)
+   SRTO_UDP_RCVSHARDS = 66,  // Number of receiving sockets and threads sharing the port of a listener (SO_REUSEPORT)
+   SRTO_UDP_SNDSHARDS = 67,  // Number of sending threads of the multiplexer
+   SRTO_UDP_IOURING = 68,    // Use io_uring for the multiplexer's UDP socket (if built with ENABLE_IOURING)
+   SRTO_UDP_TXTIME = 69,     // Let the kernel pace the sent packets by their departure time (Linux SO_TXTIME)
+   SRTO_UDP_TIMESTAMP = 70,  // Take the arrival time of the received packets from the system (Linux SO_TIMESTAMPNS)
+   SRTO_UDP_RCVPOOLHOLD = 71,// Time in ms a block of the multiplexer's receiver units must stay unused before it's released
+   SRTO_BUFALLOC = 72,       // Allocation policy for the packet payload memory (SRT_BUFALLOC)
+   SRTO_UDP_SNDSCHED = 73,   // Scheduler of the sockets in the sending threads of the multiplexer (SRT_SNDSCHED)
+   SRTO_UDP_SINGLETHREAD = 74,// The multiplexer's receiving thread also sends the packets, no sending thread
+   SRTO_UDP_NOTHREADS = 75,   // The multiplexer has no threads, the application drives it with srt_mux_process()
+   SRTO_RCVLOANS = 76         // Maximum number of received packets loaned to the application at a time (srt_recvmsg_loan)
 } SRT_SOCKOPT;
 
 
@@ -287,6 +302,21 @@ typedef enum SRT_TRANSTYPE
     SRTT_INVALID
 } SRT_TRANSTYPE;
 
+// Values for SRTO_BUFALLOC
+typedef enum SRT_BUFALLOC
+{
+    SRT_BUFALLOC_DEFAULT = 0,        // regular heap memory
+    SRT_BUFALLOC_HUGEPAGES = 1,      // 2 MB huge pages (Linux)
+    SRT_BUFALLOC_HUGEPAGES_NUMA = 2  // huge pages on the NUMA node of the thread that created the multiplexer
+} SRT_BUFALLOC;
+
+// Values for SRTO_UDP_SNDSCHED
+typedef enum SRT_SNDSCHED
+{
+    SRT_SNDSCHED_HEAP = 0,           // binary heap
+    SRT_SNDSCHED_WHEEL = 1           // hierarchical timing wheel
+} SRT_SNDSCHED;
+
 // These sizes should be used for Live mode. In Live mode you should not
 // exceed the size that fits in a single MTU.
 
@@ -406,6 +436,32 @@ struct CBytePerfMon
    int64_t  pktRecvUnique;              // number of packets to be received by the application
    uint64_t byteSentUnique;             // number of data bytes, sent by the application
    uint64_t byteRecvUnique;             // number of data bytes to be received by the application
+
+   // Multiplexer (shared by all sockets bound to the same UDP port)
+   int64_t  sndBatchCallsTotal;         // total number of system calls used by the multiplexer to send data packets
+   int64_t  pktSndBatchTotal;           // total number of data packets sent by the multiplexer
+   int      sndBatchDepthMax;           // maximum number of packets sent by the multiplexer in one system call
+   int64_t  rcvBatchCallsTotal;         // total number of system calls that delivered packets to the multiplexer
+   int64_t  pktRcvBatchTotal;           // total number of packets received by the multiplexer
+   int      rcvBatchDepthMax;           // maximum number of packets received by the multiplexer in one system call
+   int64_t  pktSndGsoTotal;             // total number of data packets sent by the multiplexer with segmentation offload
+   int64_t  pktRcvGroTotal;             // total number of packets received by the multiplexer in coalesced datagrams
+   int64_t  pktSndTxTimeTotal;          // total number of data packets sent by the multiplexer with a departure time
+   int64_t  pktRcvTimestampTotal;       // total number of packets received by the multiplexer with the arrival time from the system
+   int      sndShard;                   // index of the multiplexer's sending thread that serves this socket
+   int      sndShardSockets;            // number of sockets served by this sending thread
+   int64_t  usSndShardBusyTotal;        // total time this sending thread spent on collecting and sending packets
+   int      rcvUnitsAvail;              // number of free units in the multiplexer's receiver unit pool
+   int      rcvUnitsCapacity;           // total number of units in the multiplexer's receiver unit pool
+   int64_t  rcvUnitsGrowTotal;          // number of times the multiplexer's receiver unit pool has been extended
+   int64_t  byteRcvUnitsReleasedTotal;  // total memory released from the multiplexer's receiver unit pool
+   int64_t  timerChecksTotal;           // total number of timer checks of the sockets by the multiplexer's receiving thread
+   int      timerChecksRate;            // number of timer checks per second by the multiplexer's receiving thread
+   int      pktRcvLoaned;               // number of received packets currently loaned to the application
+   int      pktRcvLoanedMax;            // highest number of received packets loaned at a time
+   int64_t  pktRcvLoanRefusedTotal;     // total number of loans refused because SRTO_RCVLOANS was reached
+   int      rcvShard;                   // index of the multiplexer's receiving socket that serves this socket
+   int      sndSched;                   // scheduler of the multiplexer's sending thread (SRT_SNDSCHED_*)
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -833,6 +889,30 @@ static const int SRT_MSGTTL_INF = -1; // unlimited TTL specification for message
 SRT_API void srt_msgctrl_init(SRT_MSGCTRL* mctrl);
 SRT_API extern const SRT_MSGCTRL srt_msgctrl_default;
 
+// One of the segments a message is received into.
+typedef struct SRT_IoVec_
+{
+   char* buf;
+   int len;
+} SRT_IOVEC;
+
+// One of the messages sent by srt_sendmmsg or received by srt_recvmmsg.
+typedef struct SRT_MMsgHdr_
+{
+   char* buf;            // message data
+   int len;              // size of the message (sending) or of the buffer (receiving)
+   int msg_len;          // size of the message sent or received (output)
+   SRT_MSGCTRL mctrl;    // message control data
+} SRT_MMSGHDR;
+
+// A received message loaned by srt_recvmsg_loan.
+typedef struct SRT_Loan_
+{
+   const char* buf;      // message data, inside the receiver's memory
+   int len;              // size of the message
+   void* handle;         // identifies the loan for srt_loan_return
+} SRT_LOAN;
+
 // The send/receive functions.
 // These functions have different names due to different sets of parameters
 // to be supplied. Not all of them are needed or make sense in all modes:
@@ -854,6 +934,16 @@ SRT_API int srt_send    (SRTSOCKET u, const char* buf, int len);
 SRT_API int srt_sendmsg (SRTSOCKET u, const char* buf, int len, int ttl/* = -1*/, int inorder/* = false*/);
 SRT_API int srt_sendmsg2(SRTSOCKET u, const char* buf, int len, SRT_MSGCTRL *mctrl);
 
+// Sending without copying: the library references the caller's buffer until
+// every packet of the message is acknowledged or dropped, then calls release_fn.
+typedef void srt_send_release_fn(void* opaque, const char* buf, int len);
+SRT_API int srt_sendmsg_zc(SRTSOCKET u, const char* buf, int len, SRT_MSGCTRL *mctrl,
+                           srt_send_release_fn* release_fn, void* release_opaque);
+
+// Sending many messages in one call (message mode only). Returns the number
+// of messages accepted, which is less than count when the buffer is full.
+SRT_API int srt_sendmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count);
+
 //
 // Receiving functions
 //
@@ -863,6 +953,16 @@ SRT_API int srt_recv    (SRTSOCKET u, char* buf, int len);
 SRT_API int srt_recvmsg (SRTSOCKET u, char* buf, int len);
 SRT_API int srt_recvmsg2(SRTSOCKET u, char *buf, int len, SRT_MSGCTRL *mctrl);
 
+// Vectored receiving: a message scattered over the given segments, and
+// the messages ready to read received in one call (message mode only).
+SRT_API int srt_recvmsgv(SRTSOCKET u, const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL *mctrl);
+SRT_API int srt_recvmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count);
+
+// Receiving without copying (live mode only): the message stays in the
+// receiver's memory until the loan is given back with srt_loan_return.
+SRT_API int srt_recvmsg_loan(SRTSOCKET u, SRT_LOAN* loan, SRT_MSGCTRL *mctrl);
+SRT_API int srt_loan_return(SRTSOCKET u, SRT_LOAN* loan);
+
 
 // Special send/receive functions for files only.
 #define SRT_DEFAULT_SENDFILE_BLOCK 364000
@@ -911,6 +1011,11 @@ SRT_API int srt_epoll_uwait(int eid, SRT_EPOLL_EVENT* fdsSet, int fdsSize, int64
 SRT_API int32_t srt_epoll_set(int eid, int32_t flags);
 SRT_API int srt_epoll_release(int eid);
 
+// Multiplexer driven by the application (SRTO_UDP_NOTHREADS)
+SRT_API int srt_mux_fd(SRTSOCKET u, SYSSOCKET* fd);
+SRT_API int srt_mux_process(SRTSOCKET u);
+SRT_API int64_t srt_mux_next_deadline(SRTSOCKET u);
+
 // Logging control
 
 SRT_API void srt_setloglevel(int ll);
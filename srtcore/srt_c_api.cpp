@@ -220,6 +220,17 @@ int srt_sendmsg2(SRTSOCKET u, const char * buf, int len, SRT_MSGCTRL *mctrl)
     return CUDT::sendmsg2(u, buf, len, (mignore));
 }
 
+int srt_sendmsg_zc(SRTSOCKET u, const char * buf, int len, SRT_MSGCTRL *mctrl,
+                   srt_send_release_fn* release_fn, void* release_opaque)
+{
+    if (mctrl)
+        return CUDT::sendmsg_zc(u, buf, len, (*mctrl), release_fn, release_opaque);
+    SRT_MSGCTRL mignore = srt_msgctrl_default;
+    return CUDT::sendmsg_zc(u, buf, len, (mignore), release_fn, release_opaque);
+}
+
+int srt_sendmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count) { return CUDT::sendmmsg(u, msgs, count); }
+
 int srt_recvmsg2(SRTSOCKET u, char * buf, int len, SRT_MSGCTRL *mctrl)
 {
     if (mctrl)
@@ -228,6 +239,33 @@ int srt_recvmsg2(SRTSOCKET u, char * buf, int len, SRT_MSGCTRL *mctrl)
     return CUDT::recvmsg2(u, buf, len, (mignore));
 }
 
+int srt_recvmsgv(SRTSOCKET u, const SRT_IOVEC* iov, int iovcnt, SRT_MSGCTRL *mctrl)
+{
+    if (mctrl)
+        return CUDT::recvmsgv(u, iov, iovcnt, (*mctrl));
+    SRT_MSGCTRL mignore = srt_msgctrl_default;
+    return CUDT::recvmsgv(u, iov, iovcnt, (mignore));
+}
+
+int srt_recvmmsg(SRTSOCKET u, SRT_MMSGHDR* msgs, int count) { return CUDT::recvmmsg(u, msgs, count); }
+
+int srt_recvmsg_loan(SRTSOCKET u, SRT_LOAN* loan, SRT_MSGCTRL *mctrl)
+{
+    if (!loan)
+        return CUDT::APIError(MJ_NOTSUP, MN_INVAL, 0);
+    if (mctrl)
+        return CUDT::recvmsg_loan(u, (*loan), (*mctrl));
+    SRT_MSGCTRL mignore = srt_msgctrl_default;
+    return CUDT::recvmsg_loan(u, (*loan), (mignore));
+}
+
+int srt_loan_return(SRTSOCKET u, SRT_LOAN* loan)
+{
+    if (!loan)
+        return CUDT::APIError(MJ_NOTSUP, MN_INVAL, 0);
+    return CUDT::loan_return(u, (*loan));
+}
+
 const char* srt_getlasterror_str() { return UDT::getlasterror().getErrorMessage(); }
 
 int srt_getlasterror(int* loc_errno)
@@ -374,6 +412,21 @@ int srt_setrejectreason(SRTSOCKET sock, int value)
     return CUDT::rejectReason(sock, value);
 }
 
+int srt_mux_fd(SRTSOCKET u, SYSSOCKET* fd)
+{
+    return CUDT::muxFd(u, fd);
+}
+
+int srt_mux_process(SRTSOCKET u)
+{
+    return CUDT::muxProcess(u);
+}
+
+int64_t srt_mux_next_deadline(SRTSOCKET u)
+{
+    return CUDT::muxNextDeadline(u);
+}
+
 int srt_listen_callback(SRTSOCKET lsn, srt_listen_callback_fn* hook, void* opaq)
 {
     if (!hook)
@@ -0,0 +1,238 @@
+/*
+ * SRT - Secure, Reliable, Transport
+ * Copyright (c) 2020 Haivision Systems Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include "platform_sys.h"
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "uring.h"
+
+// The ring memory is shared with the kernel: the head of the submission
+// queue and the tail of the completion queue are written by the kernel,
+// so they are read with acquire semantics, and the indexes this side
+// writes are published with release semantics.
+static inline unsigned load_acquire(const unsigned* p)
+{
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void store_release(unsigned* p, unsigned v)
+{
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+}
+
+CIOUring::CIOUring()
+    : m_iRingFd(-1)
+    , m_pRingMem(MAP_FAILED)
+    , m_zRingMemSize(0)
+    , m_pSqes((io_uring_sqe*)MAP_FAILED)
+    , m_zSqesSize(0)
+    , m_puSqHead(NULL)
+    , m_puSqTail(NULL)
+    , m_puSqArray(NULL)
+    , m_uSqMask(0)
+    , m_uSqEntries(0)
+    , m_uSqeTail(0)
+    , m_uSqeSubmitted(0)
+    , m_puCqHead(NULL)
+    , m_puCqTail(NULL)
+    , m_uCqMask(0)
+    , m_pCqes(NULL)
+{
+}
+
+CIOUring::~CIOUring()
+{
+    close();
+}
+
+bool CIOUring::open(unsigned entries, int fd)
+{
+    io_uring_params p;
+    memset(&p, 0, sizeof p);
+
+    m_iRingFd = (int)::syscall(__NR_io_uring_setup, entries, &p);
+    if (m_iRingFd == -1)
+        return false;
+
+    // Required: one mapping for both rings (5.4) and the timeout
+    // given to io_uring_enter() (5.11).
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG))
+    {
+        close();
+        return false;
+    }
+
+    const size_t sqsize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    const size_t cqsize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    m_zRingMemSize = sqsize > cqsize ? sqsize : cqsize;
+    m_pRingMem = ::mmap(NULL, m_zRingMemSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            m_iRingFd, IORING_OFF_SQ_RING);
+    if (m_pRingMem == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    m_zSqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    m_pSqes = (io_uring_sqe*)::mmap(NULL, m_zSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+            m_iRingFd, IORING_OFF_SQES);
+    if (m_pSqes == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+
+    char* mem = (char*)m_pRingMem;
+    m_puSqHead   = (unsigned*)(mem + p.sq_off.head);
+    m_puSqTail   = (unsigned*)(mem + p.sq_off.tail);
+    m_puSqArray  = (unsigned*)(mem + p.sq_off.array);
+    m_uSqMask    = *(unsigned*)(mem + p.sq_off.ring_mask);
+    m_uSqEntries = p.sq_entries;
+    m_puCqHead   = (unsigned*)(mem + p.cq_off.head);
+    m_puCqTail   = (unsigned*)(mem + p.cq_off.tail);
+    m_uCqMask    = *(unsigned*)(mem + p.cq_off.ring_mask);
+    m_pCqes      = (io_uring_cqe*)(mem + p.cq_off.cqes);
+
+    m_uSqeTail = m_uSqeSubmitted = *m_puSqTail;
+
+    // Registering the socket spares the kernel looking it up
+    // with every operation.
+    if (-1 == ::syscall(__NR_io_uring_register, m_iRingFd, IORING_REGISTER_FILES, &fd, 1))
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void CIOUring::close()
+{
+    if (m_pSqes != MAP_FAILED)
+        ::munmap(m_pSqes, m_zSqesSize);
+    if (m_pRingMem != MAP_FAILED)
+        ::munmap(m_pRingMem, m_zRingMemSize);
+    if (m_iRingFd != -1)
+        ::close(m_iRingFd);
+
+    m_pSqes = (io_uring_sqe*)MAP_FAILED;
+    m_pRingMem = MAP_FAILED;
+    m_iRingFd = -1;
+}
+
+io_uring_sqe* CIOUring::getSqe()
+{
+    if (m_uSqeTail - load_acquire(m_puSqHead) >= m_uSqEntries)
+        return NULL;
+
+    const unsigned index = m_uSqeTail & m_uSqMask;
+    io_uring_sqe* sqe = &m_pSqes[index];
+    memset(sqe, 0, sizeof *sqe);
+    m_puSqArray[index] = index;
+    ++ m_uSqeTail;
+    return sqe;
+}
+
+bool CIOUring::prepRecvmsg(msghdr* mh, uint64_t data)
+{
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = 0; // index of the registered socket
+    sqe->addr = (uint64_t)(uintptr_t)mh;
+    sqe->len = 1;
+    sqe->user_data = data;
+    return true;
+}
+
+bool CIOUring::prepSendmsg(const msghdr* mh, uint64_t data)
+{
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->fd = 0;
+    sqe->addr = (uint64_t)(uintptr_t)mh;
+    sqe->len = 1;
+    sqe->msg_flags = MSG_DONTWAIT; // fail when the socket buffer is full, as sendmsg() would
+    sqe->user_data = data;
+    return true;
+}
+
+bool CIOUring::prepCancel(uint64_t target, uint64_t data)
+{
+    io_uring_sqe* sqe = getSqe();
+    if (!sqe)
+        return false;
+
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = target;
+    sqe->user_data = data;
+    return true;
+}
+
+int CIOUring::submit(unsigned wait_nr, int timeout_us)
+{
+    const unsigned count = m_uSqeTail - m_uSqeSubmitted;
+    store_release(m_puSqTail, m_uSqeTail);
+    m_uSqeSubmitted = m_uSqeTail;
+
+    unsigned flags = 0;
+    void* arg = NULL;
+    size_t argsize = 0;
+
+    __kernel_timespec ts;
+    io_uring_getevents_arg ext;
+    if (wait_nr > 0)
+    {
+        flags |= IORING_ENTER_GETEVENTS;
+        if (timeout_us >= 0)
+        {
+            ts.tv_sec = timeout_us / 1000000;
+            ts.tv_nsec = (timeout_us % 1000000) * 1000;
+            memset(&ext, 0, sizeof ext);
+            ext.ts = (uint64_t)(uintptr_t)&ts;
+            flags |= IORING_ENTER_EXT_ARG;
+            arg = &ext;
+            argsize = sizeof ext;
+        }
+    }
+
+    if (count == 0 && wait_nr == 0)
+        return 0;
+
+    const int res = (int)::syscall(__NR_io_uring_enter, m_iRingFd, count, wait_nr, flags, arg, argsize);
+    return res == -1 ? -errno : res;
+}
+
+const io_uring_cqe* CIOUring::peekCompletion() const
+{
+    const unsigned head = *m_puCqHead;
+    if (head == load_acquire(m_puCqTail))
+        return NULL;
+
+    return &m_pCqes[head & m_uCqMask];
+}
+
+void CIOUring::seenCompletion()
+{
+    store_release(m_puCqHead, *m_puCqHead + 1);
+}
@@ -0,0 +1,108 @@
+/*
+ * SRT - Secure, Reliable, Transport
+ * Copyright (c) 2020 Haivision Systems Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ */
+#pragma once
+#ifndef INC_SRT_URING_H
+#define INC_SRT_URING_H
+
+// Minimal io_uring ring for the UDP channel (built with ENABLE_IOURING).
+// The ring is driven directly with the system calls, so liburing is not
+// needed. All operations of a ring work on one socket, registered with the
+// ring as a fixed file. A ring is not thread-safe: it must be used by one
+// thread at a time.
+
+#include <cstddef>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <linux/io_uring.h>
+
+class CIOUring
+{
+public:
+   CIOUring();
+   ~CIOUring();
+
+      /// Set up the ring and register the socket with it.
+      /// @param [in] entries number of submission queue entries
+      /// @param [in] fd socket for all operations of the ring
+      /// @return true if the ring is ready, false if the system doesn't support it.
+
+   bool open(unsigned entries, int fd);
+
+      /// Release the ring. Operations still in progress are abandoned.
+
+   void close();
+
+      /// Prepare a recvmsg() operation on the socket.
+      /// @param [in] mh message header, which must stay valid until the operation completes
+      /// @param [in] data value reported back with the completion
+      /// @return false if the submission queue is full.
+
+   bool prepRecvmsg(msghdr* mh, uint64_t data);
+
+      /// Prepare a sendmsg() operation on the socket. It fails rather than
+      /// waits if the socket buffer is full.
+      /// @param [in] mh message header, which must stay valid until the operation completes
+      /// @param [in] data value reported back with the completion
+      /// @return false if the submission queue is full.
+
+   bool prepSendmsg(const msghdr* mh, uint64_t data);
+
+      /// Prepare the cancellation of an operation.
+      /// @param [in] target value given to the operation to be cancelled
+      /// @param [in] data value reported back with the completion of the cancellation
+      /// @return false if the submission queue is full.
+
+   bool prepCancel(uint64_t target, uint64_t data);
+
+      /// Submit the prepared operations and wait for completions.
+      /// @param [in] wait_nr number of completions to wait for
+      /// @param [in] timeout_us maximum time to wait, in microseconds (-1: no limit)
+      /// @return Number of operations submitted, or -errno (-ETIME on timeout).
+
+   int submit(unsigned wait_nr = 0, int timeout_us = -1);
+
+      /// Get the oldest completion not yet consumed.
+      /// @return Pointer to the completion, or NULL if there is none.
+
+   const io_uring_cqe* peekCompletion() const;
+
+      /// Consume the completion returned by peekCompletion().
+
+   void seenCompletion();
+
+private:
+   io_uring_sqe* getSqe();
+
+private:
+   int m_iRingFd;                  // ring descriptor (-1 if not open)
+   void* m_pRingMem;               // mapped submission and completion rings
+   size_t m_zRingMemSize;
+   io_uring_sqe* m_pSqes;          // mapped submission queue entries
+   size_t m_zSqesSize;
+
+   unsigned* m_puSqHead;
+   unsigned* m_puSqTail;
+   unsigned* m_puSqArray;
+   unsigned m_uSqMask;
+   unsigned m_uSqEntries;
+   unsigned m_uSqeTail;            // end of the prepared entries
+   unsigned m_uSqeSubmitted;       // end of the submitted entries
+
+   unsigned* m_puCqHead;
+   unsigned* m_puCqTail;
+   unsigned m_uCqMask;
+   io_uring_cqe* m_pCqes;
+
+private:
+   CIOUring(const CIOUring&);
+   CIOUring& operator=(const CIOUring&);
+};
+
+#endif
@@ -209,13 +209,22 @@ public:
    /// Record time information of an arrived packet.
 
    void onPktArrival(int pktsz = 0)
+   {
+       onPktArrival(pktsz, srt::sync::steady_clock::now());
+   }
+
+   /// Record time information of a packet that arrived at the given time.
+
+   void onPktArrival(int pktsz, const srt::sync::steady_clock::time_point& arrival)
    {
        srt::sync::ScopedLock cg(m_lockPktWindow);
 
-       m_tsCurrArrTime = srt::sync::steady_clock::now();
+       m_tsCurrArrTime = arrival;
 
        // record the packet interval between the current and the last one
-       m_aPktWindow[m_iPktWindowPtr] = srt::sync::count_microseconds(m_tsCurrArrTime - m_tsLastArrTime);
+       // (at least 1us: packets read together share the arrival time, while
+       // zero intervals make the median filter reject the whole window)
+       m_aPktWindow[m_iPktWindowPtr] = std::max<int>(1, srt::sync::count_microseconds(m_tsCurrArrTime - m_tsLastArrTime));
        m_aBytesWindow[m_iPktWindowPtr] = pktsz;
 
        // the window is logically circular
@@ -229,13 +238,19 @@ public:
 
    /// Shortcut to test a packet for possible probe 1 or 2
    void probeArrival(const CPacket& pkt, bool unordered)
+   {
+       probeArrival(pkt, unordered, srt::sync::steady_clock::now());
+   }
+
+   /// Shortcut to test a packet that arrived at the given time for possible probe 1 or 2
+   void probeArrival(const CPacket& pkt, bool unordered, const srt::sync::steady_clock::time_point& arrival)
    {
        const int inorder16 = pkt.m_iSeqNo & PUMASK_SEQNO_PROBE;
 
        // for probe1, we want 16th packet
        if (inorder16 == 0)
        {
-           probe1Arrival(pkt, unordered);
+           probe1Arrival(pkt, unordered, arrival);
        }
 
        if (unordered)
@@ -244,12 +259,12 @@ public:
        // for probe2, we want 17th packet
        if (inorder16 == 1)
        {
-           probe2Arrival(pkt);
+           probe2Arrival(pkt, arrival);
        }
    }
 
    /// Record the arrival time of the first probing packet.
-   void probe1Arrival(const CPacket& pkt, bool unordered)
+   void probe1Arrival(const CPacket& pkt, bool unordered, const srt::sync::steady_clock::time_point& arrival)
    {
        if (unordered && pkt.m_iSeqNo == m_Probe1Sequence)
        {
@@ -260,13 +275,13 @@ public:
            return;
        }
 
-       m_tsProbeTime = srt::sync::steady_clock::now();
+       m_tsProbeTime = arrival;
        m_Probe1Sequence = pkt.m_iSeqNo; // Record the sequence where 16th packet probe was taken
    }
 
    /// Record the arrival time of the second probing packet and the interval between packet pairs.
 
-   void probe2Arrival(const CPacket& pkt)
+   void probe2Arrival(const CPacket& pkt, const srt::sync::steady_clock::time_point& arrival)
    {
        // Reject probes that don't refer to the very next packet
        // towards the one that was lately notified by probe1Arrival.
@@ -279,15 +294,10 @@ public:
        if (m_Probe1Sequence == SRT_SEQNO_NONE || CSeqNo::incseq(m_Probe1Sequence) != pkt.m_iSeqNo)
            return;
 
-       // Grab the current time before trying to acquire
-       // a mutex. This might add extra delay and therefore
-       // screw up the measurement.
-       const srt::sync::steady_clock::time_point now = srt::sync::steady_clock::now();
-
        // Lock access to the packet Window
        srt::sync::ScopedLock cg(m_lockProbeWindow);
 
-       m_tsCurrArrTime = now;
+       m_tsCurrArrTime = arrival;
 
        // Reset the starting probe to prevent checking if the
        // measurement was already taken.
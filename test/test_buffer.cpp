@@ -1,4 +1,8 @@
 #include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
 #include "gtest/gtest.h"
 #include "buffer.h"
 
@@ -158,3 +162,292 @@ TEST(CRcvBuffer, AddData)
 }
 
 
+TEST(CRcvBuffer, ReadMsgScatter)
+{
+    const int buffer_size_pkts = 16;
+    CUnitQueue unit_queue;
+    unit_queue.init(buffer_size_pkts, 1500, AF_INET);
+    CRcvBuffer rcv_buffer(&unit_queue, buffer_size_pkts);
+
+    // A message of three packets, filled with their positions in it.
+    const int payload_size = 1000;
+    for (int i = 0; i < 3; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        unit->m_Packet.setLength(payload_size);
+        for (int j = 0; j < payload_size; ++j)
+            unit->m_Packet.m_pcData[j] = char((i * payload_size + j) % 251);
+        unit->m_Packet.m_iSeqNo = 100 + i;
+        unit->m_Packet.m_iMsgNo = 1
+            | PacketBoundaryBits(i == 0 ? PB_FIRST : i == 2 ? PB_LAST : PB_SUBSEQUENT);
+        EXPECT_EQ(rcv_buffer.addData(unit, i), 0);
+    }
+    rcv_buffer.ackData(3);
+
+    // Segment boundaries do not follow the packet boundaries.
+    std::vector<char> a(700), b(0), c(1800), d(1000);
+    const SRT_IOVEC iov[] = { {&a[0], 700}, {NULL, 0}, {&c[0], 1800}, {&d[0], 1000} };
+    SRT_MSGCTRL mctrl = srt_msgctrl_default;
+    EXPECT_EQ(rcv_buffer.readMsg(iov, 4, (mctrl), -1), 3 * payload_size);
+    EXPECT_EQ(mctrl.pktseq, 100);
+    EXPECT_EQ(mctrl.msgno, 1);
+
+    std::vector<char> msg(a);
+    msg.insert(msg.end(), c.begin(), c.end());
+    msg.insert(msg.end(), d.begin(), d.begin() + 500);
+    for (int j = 0; j < 3 * payload_size; ++j)
+        ASSERT_EQ(msg[j], char(j % 251)) << "at " << j;
+
+    EXPECT_EQ(rcv_buffer.getAvailBufSize(), buffer_size_pkts - 1);
+}
+
+TEST(CRcvBuffer, LoanMsg)
+{
+    using namespace srt::sync;
+
+    const int buffer_size_pkts = 16;
+    CUnitQueue unit_queue;
+    unit_queue.init(buffer_size_pkts, 1500, AF_INET);
+    {
+        CRcvBuffer rcv_buffer(&unit_queue, buffer_size_pkts);
+        rcv_buffer.setRcvTsbPdMode(steady_clock::now() - seconds_from(1), milliseconds_from(0));
+
+        // Three live messages, all ready to play.
+        const int payload_size = 1000;
+        CUnit* units[3];
+        for (int i = 0; i < 3; ++i)
+        {
+            units[i] = unit_queue.getNextAvailUnit();
+            ASSERT_NE(units[i], nullptr);
+            units[i]->m_Packet.setLength(payload_size);
+            units[i]->m_Packet.m_iSeqNo = 100 + i;
+            units[i]->m_Packet.m_iMsgNo = (1 + i) | PacketBoundaryBits(PB_SOLO);
+            units[i]->m_Packet.m_iTimeStamp = 0;
+            EXPECT_EQ(rcv_buffer.addData(units[i], i), 0);
+        }
+        rcv_buffer.ackData(3);
+        EXPECT_EQ(unit_queue.size(), unit_queue.capacity() - 3);
+
+        SRT_MSGCTRL mctrl = srt_msgctrl_default;
+        EXPECT_EQ(rcv_buffer.loanMsg((mctrl), -1), units[0]);
+        EXPECT_EQ(mctrl.pktseq, 100);
+        EXPECT_EQ(mctrl.msgno, 1);
+        EXPECT_EQ(rcv_buffer.loanMsg((mctrl), -1), units[1]);
+        EXPECT_EQ(mctrl.msgno, 2);
+
+        // The loaned units left the receiver window, but not the unit queue.
+        EXPECT_EQ(rcv_buffer.getLoanCount(), 2);
+        EXPECT_EQ(rcv_buffer.getRcvDataSize(), 1);
+        EXPECT_EQ(unit_queue.size(), unit_queue.capacity() - 3);
+
+        EXPECT_TRUE(rcv_buffer.returnLoan(units[0]));
+        EXPECT_FALSE(rcv_buffer.returnLoan(units[0]));
+        EXPECT_FALSE(rcv_buffer.returnLoan(units[2]));
+        EXPECT_EQ(rcv_buffer.getLoanCount(), 1);
+        EXPECT_EQ(unit_queue.size(), unit_queue.capacity() - 2);
+    }
+
+    // The loan not returned ends with the buffer.
+    EXPECT_EQ(unit_queue.size(), unit_queue.capacity());
+}
+
+
+
+
+// Adds a packet of the given length filled with the lowest byte of its sequence number.
+static void addSndPacket(CSndBuffer& buf, int32_t& w_seqno, int len)
+{
+    std::vector<char> data(len, char(w_seqno));
+    SRT_MSGCTRL mctrl = srt_msgctrl_default;
+    mctrl.pktseq = w_seqno;
+    buf.addBuffer(&data[0], len, (mctrl));
+    w_seqno = mctrl.pktseq;
+}
+
+static int sndPacketLength(int32_t seqno)
+{
+    return 100 + seqno % 50;
+}
+
+TEST(CSndBuffer, RexmitAfterGrowth)
+{
+    CSndBuffer buf(16, 1500);
+    int32_t seqno = 1000;
+    srt::sync::steady_clock::time_point origin;
+    CPacket pkt;
+
+    // Send some packets and acknowledge most of them, so that the first
+    // block in use is not at the beginning of the ring when it grows.
+    for (int i = 0; i < 10; ++i)
+        addSndPacket(buf, seqno, sndPacketLength(seqno));
+    for (int i = 0; i < 10; ++i)
+    {
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), sndPacketLength(1000 + i));
+        EXPECT_EQ(pkt.m_iSeqNo, 1000 + i);
+    }
+    std::vector<CSndRelease> released;
+    buf.ackData(7, (released));
+    EXPECT_EQ(buf.getCurrBufSize(), 3);
+
+    for (int i = 0; i < 30; ++i)
+        addSndPacket(buf, seqno, sndPacketLength(seqno));
+
+    int bytes = 0, timespan = 0;
+    EXPECT_EQ(buf.getCurrBufSize((bytes), (timespan)), 33);
+    int expected_bytes = 0;
+    for (int32_t s = 1007; s < 1040; ++s)
+        expected_bytes += sndPacketLength(s);
+    EXPECT_EQ(bytes, expected_bytes);
+
+    // Every packet is found by its offset from the ACK point.
+    for (int offset = 0; offset < 33; ++offset)
+    {
+        int msglen = 0;
+        const int32_t s = 1007 + offset;
+        ASSERT_EQ(buf.readData(offset, (pkt), (origin), (msglen)), sndPacketLength(s));
+        EXPECT_EQ(pkt.m_pcData[0], char(s));
+        EXPECT_EQ(buf.getMsgNoAt(offset), s - 1000 + 1);
+        EXPECT_FALSE(srt::sync::is_zero(buf.getPacketRexmitTime(offset)));
+    }
+
+    // The packets added later are sent in order.
+    for (int32_t s = 1010; s < 1040; ++s)
+    {
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), sndPacketLength(s));
+        EXPECT_EQ(pkt.m_iSeqNo, s);
+        EXPECT_EQ(pkt.m_pcData[0], char(s));
+    }
+    EXPECT_EQ(buf.readData((pkt), (origin), 0), 0);
+
+    buf.ackData(33, (released));
+    EXPECT_EQ(buf.getCurrBufSize((bytes), (timespan)), 0);
+    EXPECT_TRUE(released.empty());
+    EXPECT_EQ(bytes, 0);
+}
+
+// Measures the retransmission of packets at random offsets in the flight window.
+// Returns the time per retransmitted packet in ns.
+static double rexmitTime(int window)
+{
+    CSndBuffer buf(32, 1500);
+    int32_t seqno = 0;
+    srt::sync::steady_clock::time_point origin;
+    CPacket pkt;
+    for (int i = 0; i < window; ++i)
+    {
+        addSndPacket(buf, seqno, 1316);
+        buf.readData((pkt), (origin), 0);
+    }
+
+    const int count = 100000;
+    std::srand(1);
+    std::vector<int> offsets(count);
+    for (int i = 0; i < count; ++i)
+        offsets[i] = std::rand() % window;
+
+    int64_t total = 0;
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+    {
+        int msglen;
+        buf.getPacketRexmitTime(offsets[i]);
+        total += buf.readData(offsets[i], (pkt), (origin), (msglen));
+    }
+    const std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(total, int64_t(count) * 1316);
+    return double(std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count()) / count;
+}
+
+// Timing only, run with --gtest_also_run_disabled_tests.
+TEST(CSndBuffer, DISABLED_RexmitBenchmark)
+{
+    const int windows[] = { 100, 1000, 20000 };
+    for (size_t i = 0; i < sizeof windows / sizeof windows[0]; ++i)
+    {
+        std::cout << "Retransmission in a window of " << windows[i] << " packets: "
+            << rexmitTime(windows[i]) << " ns per packet" << std::endl;
+    }
+}
+
+// Records the user data blocks released by the sender buffer.
+static void recordRelease(void* opaque, const char* buf, int len)
+{
+    std::vector<std::pair<const char*, int> >* released = (std::vector<std::pair<const char*, int> >*)opaque;
+    released->push_back(std::make_pair(buf, len));
+}
+
+TEST(CSndBuffer, ZeroCopy)
+{
+    std::vector<std::pair<const char*, int> > released;
+    std::vector<char> first(3200, 'a'), second(1000, 'b');
+    srt::sync::steady_clock::time_point origin;
+    CPacket pkt;
+
+    {
+        CSndBuffer buf(16, 1500);
+        SRT_MSGCTRL mctrl = srt_msgctrl_default;
+        mctrl.pktseq = 1000;
+        buf.addBuffer(&first[0], int(first.size()), (mctrl), &recordRelease, &released);
+        buf.addBuffer(&second[0], int(second.size()), (mctrl), &recordRelease, &released);
+
+        // The packets are read right from the user data blocks.
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), 1500);
+        EXPECT_EQ(pkt.m_pcData, &first[0]);
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), 1500);
+        EXPECT_EQ(pkt.m_pcData, &first[1500]);
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), 200);
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), 1000);
+        EXPECT_EQ(pkt.m_pcData, &second[0]);
+
+        int msglen = 0;
+        EXPECT_EQ(buf.readData(1, (pkt), (origin), (msglen)), 1500);
+        EXPECT_EQ(pkt.m_pcData, &first[1500]);
+
+        // The block is released only with the last of its packets,
+        // by the caller, when no packet being sent points to it.
+        std::vector<CSndRelease> done;
+        buf.ackData(2, (done));
+        EXPECT_TRUE(done.empty());
+        buf.ackData(1, (done));
+        ASSERT_EQ(done.size(), 1U);
+        EXPECT_TRUE(released.empty());
+        done[0].call();
+        ASSERT_EQ(released.size(), 1U);
+        EXPECT_EQ(released[0].first, &first[0]);
+        EXPECT_EQ(released[0].second, 3200);
+
+        // Copied data do not interfere with the referenced ones.
+        std::vector<char> copied(100, 'c');
+        buf.addBuffer(&copied[0], int(copied.size()), (mctrl));
+        EXPECT_EQ(buf.readData((pkt), (origin), 0), 100);
+        EXPECT_NE(pkt.m_pcData, &copied[0]);
+        EXPECT_EQ(pkt.m_pcData[0], 'c');
+
+        // The remaining blocks are released with the buffer.
+    }
+    ASSERT_EQ(released.size(), 2U);
+    EXPECT_EQ(released[1].first, &second[0]);
+    EXPECT_EQ(released[1].second, 1000);
+}
+
+TEST(CSndBuffer, ZeroCopyDrop)
+{
+    std::vector<std::pair<const char*, int> > released;
+    std::vector<char> data(1000, 'a');
+    CSndBuffer buf(16, 1500);
+    SRT_MSGCTRL mctrl = srt_msgctrl_default;
+    mctrl.pktseq = 1000;
+    buf.addBuffer(&data[0], int(data.size()), (mctrl), &recordRelease, &released);
+
+    int bytes = 0;
+    int32_t msgno = 0;
+    std::vector<CSndRelease> done;
+    EXPECT_EQ(buf.dropLateData((bytes), (msgno), srt::sync::steady_clock::now() + srt::sync::seconds_from(1), (done)), 1);
+    EXPECT_EQ(bytes, 1000);
+    ASSERT_EQ(done.size(), 1U);
+    done[0].call();
+    ASSERT_EQ(released.size(), 1U);
+    EXPECT_EQ(released[0].first, &data[0]);
+}
@@ -18,9 +18,12 @@
 
 #include "srt.h"
 
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <fstream>
 #include <ctime>
+#include <functional>
 #include <vector>
 
 //#pragma comment (lib, "ws2_32.lib")
@@ -174,3 +177,393 @@ TEST(Transmission, FileUpload)
 
     (void)srt_cleanup();
 }
+
+namespace
+{
+
+// Connects a caller to a listener on the given port of the local host, both
+// configured by 'setopt', and runs 'transmit' with the caller and the socket
+// accepted for it. All three sockets are closed afterwards.
+void TransmitConnected(int port, const std::function<void(SRTSOCKET)>& setopt,
+        const std::function<void(SRTSOCKET, SRTSOCKET)>& transmit)
+{
+    SRTSOCKET sock_lsn = srt_create_socket(), sock_clr = srt_create_socket();
+    setopt(sock_lsn);
+    setopt(sock_clr);
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, 1), SRT_ERROR);
+
+    ASSERT_NE(srt_connect(sock_clr, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    sockaddr_in remote;
+    int len = sizeof remote;
+    const SRTSOCKET accepted_sock = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+    ASSERT_NE(accepted_sock, SRT_INVALID_SOCK);
+
+    transmit(sock_clr, accepted_sock);
+
+    srt_close(sock_clr);
+    srt_close(accepted_sock);
+    srt_close(sock_lsn);
+}
+
+void SetFileMessageMode(SRTSOCKET sock)
+{
+    int tt = SRTT_FILE;
+    srt_setsockflag(sock, SRTO_TRANSTYPE, &tt, sizeof tt);
+    bool yes = true;
+    srt_setsockflag(sock, SRTO_MESSAGEAPI, &yes, sizeof yes);
+}
+
+void countRelease(void* opaque, const char*, int)
+{
+    ++*(std::atomic<int>*)opaque;
+}
+
+// A block sent with srt_sendmsg_zc that counts its releases. Once released
+// it's overwritten, so that a packet still sent from it arrives corrupted.
+struct ZeroCopyBlock
+{
+    std::vector<char> data;
+    std::atomic<int> released;
+};
+
+void releaseBlock(void* opaque, const char*, int)
+{
+    ZeroCopyBlock* block = (ZeroCopyBlock*)opaque;
+    std::fill(block->data.begin(), block->data.end(), char(0xFF));
+    ++block->released;
+}
+
+}
+
+TEST(Transmission, ZeroCopySend)
+{
+    srt_startup();
+
+    TransmitConnected(5630, SetFileMessageMode, [](SRTSOCKET sock_clr, SRTSOCKET accepted_sock)
+    {
+        const int count = 200, size = 10000;
+        int received = 0, corrupted = 0;
+
+        std::thread receiver([&]
+        {
+            std::vector<char> buf(size);
+            while (received < count)
+            {
+                const int n = srt_recvmsg(accepted_sock, buf.data(), size);
+                if (n <= 0)
+                    break;
+                if (n != size || buf[0] != char(received) || buf[n - 1] != char(received))
+                    ++corrupted;
+                ++received;
+            }
+        });
+
+        // The release function is required.
+        std::vector<char> data(size);
+        EXPECT_EQ(srt_sendmsg_zc(sock_clr, data.data(), size, NULL, NULL, NULL), SRT_ERROR);
+        EXPECT_EQ(srt_getlasterror(NULL), SRT_EINVPARAM);
+
+        // Every message is sent from its own block, which must stay
+        // untouched until the library releases it.
+        std::vector< std::vector<char> > blocks(count);
+        std::atomic<int> released(0);
+        for (int i = 0; i < count; ++i)
+        {
+            blocks[i].assign(size, char(i));
+            EXPECT_EQ(srt_sendmsg_zc(sock_clr, blocks[i].data(), size, NULL, &countRelease, &released), size);
+        }
+
+        receiver.join();
+        for (int i = 0; i < 100 && released < count; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        EXPECT_EQ(released, count);
+        EXPECT_EQ(received, count);
+        EXPECT_EQ(corrupted, 0);
+    });
+
+    (void)srt_cleanup();
+}
+
+TEST(Transmission, ZeroCopyBatchedSend)
+{
+    srt_startup();
+
+    // The acknowledged blocks are released while the sending thread may be
+    // in the middle of a batch; they must be given back only after it.
+    TransmitConnected(5634, [](SRTSOCKET sock)
+    {
+        SetFileMessageMode(sock);
+        const int batch = 16;
+        srt_setsockflag(sock, SRTO_UDP_SNDBATCH, &batch, sizeof batch);
+    },
+    [](SRTSOCKET sock_clr, SRTSOCKET accepted_sock)
+    {
+        const int count = 500, size = 10000;
+        int received = 0, corrupted = 0;
+
+        std::thread receiver([&]
+        {
+            std::vector<char> buf(size);
+            while (received < count)
+            {
+                const int n = srt_recvmsg(accepted_sock, buf.data(), size);
+                if (n <= 0)
+                    break;
+                if (n != size || std::count(buf.begin(), buf.end(), char(received % 127)) != size)
+                    ++corrupted;
+                ++received;
+            }
+        });
+
+        std::vector<ZeroCopyBlock> blocks(count);
+        for (int i = 0; i < count; ++i)
+        {
+            blocks[i].data.assign(size, char(i % 127));
+            blocks[i].released = 0;
+            EXPECT_EQ(srt_sendmsg_zc(sock_clr, blocks[i].data.data(), size, NULL, &releaseBlock, &blocks[i]), size);
+        }
+
+        receiver.join();
+        int released = 0;
+        for (int i = 0; i < 100 && released < count; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            released = 0;
+            for (int j = 0; j < count; ++j)
+                released += blocks[j].released;
+        }
+
+        SRT_TRACEBSTATS stats;
+        EXPECT_NE(srt_bstats(sock_clr, &stats, 0), SRT_ERROR);
+#ifdef HAVE_SENDMMSG
+        EXPECT_GT(stats.sndBatchDepthMax, 1);
+#endif
+
+        EXPECT_EQ(received, count);
+        EXPECT_EQ(corrupted, 0);
+        for (int i = 0; i < count; ++i)
+            EXPECT_EQ(blocks[i].released, 1) << "block " << i;
+    });
+
+    (void)srt_cleanup();
+}
+
+TEST(Transmission, VectoredReceive)
+{
+    srt_startup();
+
+    // An unconnected socket is reported before the arguments are checked.
+    SRTSOCKET sock = srt_create_socket();
+    SRT_MMSGHDR empty = SRT_MMSGHDR();
+    EXPECT_EQ(srt_recvmmsg(sock, &empty, 1), SRT_ERROR);
+    EXPECT_EQ(srt_getlasterror(NULL), SRT_ENOCONN);
+    srt_close(sock);
+
+    TransmitConnected(5631, SetFileMessageMode, [](SRTSOCKET sock_clr, SRTSOCKET accepted_sock)
+    {
+        // Messages of 7 TS packets.
+        const int count = 2000, size = 7 * 188;
+        std::vector<char> buf(size);
+        for (int i = 0; i < count; ++i)
+        {
+            std::fill(buf.begin(), buf.end(), char(i));
+            ASSERT_EQ(srt_sendmsg2(sock_clr, buf.data(), size, NULL), size);
+        }
+
+        // When everything is acknowledged, all the messages are ready to read.
+        for (int i = 0; i < 100; ++i)
+        {
+            size_t blocks = 0;
+            ASSERT_NE(srt_getsndbuffer(sock_clr, &blocks, NULL), SRT_ERROR);
+            if (blocks == 0)
+                break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        // The TS packets of a message land in separate buffers.
+        std::vector< std::vector<char> > ts(7, std::vector<char>(188));
+        SRT_IOVEC iov[7];
+        for (int j = 0; j < 7; ++j)
+        {
+            iov[j].buf = ts[j].data();
+            iov[j].len = 188;
+        }
+        SRT_MSGCTRL mctrl = srt_msgctrl_default;
+        ASSERT_EQ(srt_recvmsgv(accepted_sock, iov, 7, &mctrl), size);
+        EXPECT_EQ(mctrl.msgno, 1);
+        for (int j = 0; j < 7; ++j)
+            EXPECT_EQ(std::count(ts[j].begin(), ts[j].end(), char(0)), 188);
+
+        // The rest is read in batches of ready messages.
+        const int batch = 64;
+        std::vector< std::vector<char> > bufs(batch, std::vector<char>(size));
+        std::vector<SRT_MMSGHDR> msgs(batch);
+        int received = 1, corrupted = 0;
+        while (received < count)
+        {
+            for (int j = 0; j < batch; ++j)
+            {
+                msgs[j].buf = bufs[j].data();
+                msgs[j].len = size;
+                msgs[j].mctrl = srt_msgctrl_default;
+            }
+
+            const int n = srt_recvmmsg(accepted_sock, msgs.data(), batch);
+            ASSERT_EQ(n, std::min(batch, count - received));
+            for (int j = 0; j < n; ++j)
+            {
+                if (msgs[j].msg_len != size || msgs[j].mctrl.msgno != received + 1
+                        || std::count(bufs[j].begin(), bufs[j].end(), char(received)) != size)
+                    ++corrupted;
+                ++received;
+            }
+        }
+
+        EXPECT_EQ(received, count);
+        EXPECT_EQ(corrupted, 0);
+    });
+
+    (void)srt_cleanup();
+}
+
+TEST(Transmission, BatchedSend)
+{
+    srt_startup();
+
+    TransmitConnected(5632, SetFileMessageMode, [](SRTSOCKET sock_clr, SRTSOCKET accepted_sock)
+    {
+        // More messages than the sender buffer can hold.
+        const int count = 20000, size = 7 * 188;
+        int received = 0, corrupted = 0;
+
+        // Stop at the last message, before the sender closes the connection.
+        std::thread receiver([&]
+        {
+            std::vector<char> buf(size);
+            while (received < count)
+            {
+                SRT_MSGCTRL mctrl = srt_msgctrl_default;
+                const int n = srt_recvmsg2(accepted_sock, buf.data(), size, &mctrl);
+                if (n <= 0)
+                    break;
+                if (n != size || mctrl.msgno != received + 1
+                        || std::count(buf.begin(), buf.end(), char(received)) != size)
+                    ++corrupted;
+                ++received;
+            }
+        });
+
+        std::vector< std::vector<char> > data(count, std::vector<char>(size));
+        std::vector<SRT_MMSGHDR> msgs(count);
+        for (int i = 0; i < count; ++i)
+        {
+            std::fill(data[i].begin(), data[i].end(), char(i));
+            msgs[i].buf = data[i].data();
+            msgs[i].len = size;
+            msgs[i].mctrl = srt_msgctrl_default;
+        }
+
+        // The messages are accepted up to the free space in the buffer.
+        int sent = srt_sendmmsg(sock_clr, msgs.data(), count);
+        EXPECT_GT(sent, 0);
+        EXPECT_LT(sent, count);
+        if (sent > 0 && sent < count)
+        {
+            EXPECT_EQ(msgs[sent - 1].msg_len, size);
+            EXPECT_EQ(msgs[sent - 1].mctrl.msgno, sent);
+            EXPECT_EQ(msgs[sent].msg_len, 0);
+        }
+
+        // Then the call waits for space for the first message.
+        while (sent < count)
+        {
+            const int n = srt_sendmmsg(sock_clr, &msgs[sent], count - sent);
+            if (n <= 0)
+                break;
+            sent += n;
+        }
+
+        receiver.join();
+        EXPECT_EQ(sent, count);
+        EXPECT_EQ(received, count);
+        EXPECT_EQ(corrupted, 0);
+    });
+
+    (void)srt_cleanup();
+}
+
+TEST(Transmission, LoanedReceive)
+{
+    srt_startup();
+
+    // Live mode; at most 4 packets loaned at a time.
+    const int loans = 4;
+    TransmitConnected(5633, [&](SRTSOCKET sock)
+    {
+        srt_setsockflag(sock, SRTO_RCVLOANS, &loans, sizeof loans);
+        const int timeout_ms = 3000;
+        srt_setsockflag(sock, SRTO_RCVTIMEO, &timeout_ms, sizeof timeout_ms);
+    },
+    [&](SRTSOCKET sock_clr, SRTSOCKET accepted_sock)
+    {
+        const int count = 10, size = 7 * 188;
+        std::vector<char> buf(size);
+        for (int i = 0; i < count; ++i)
+        {
+            std::fill(buf.begin(), buf.end(), char(i));
+            ASSERT_EQ(srt_sendmsg2(sock_clr, buf.data(), size, NULL), size);
+        }
+
+        std::vector<SRT_LOAN> loaned(loans + 1);
+        SRT_MSGCTRL mctrl = srt_msgctrl_default;
+        for (int i = 0; i < loans; ++i)
+        {
+            ASSERT_EQ(srt_recvmsg_loan(accepted_sock, &loaned[i], &mctrl), size);
+            EXPECT_EQ(mctrl.msgno, i + 1);
+            EXPECT_EQ(loaned[i].len, size);
+            EXPECT_EQ(std::count(loaned[i].buf, loaned[i].buf + size, char(i)), size);
+        }
+
+        // No more loans until one is given back.
+        EXPECT_EQ(srt_recvmsg_loan(accepted_sock, &loaned[loans], &mctrl), SRT_ERROR);
+        EXPECT_EQ(srt_getlasterror(NULL), SRT_ENOBUF);
+
+        ASSERT_EQ(srt_loan_return(accepted_sock, &loaned[0]), 0);
+        EXPECT_EQ(loaned[0].handle, nullptr);
+        EXPECT_EQ(srt_loan_return(accepted_sock, &loaned[0]), SRT_ERROR);
+        EXPECT_EQ(srt_getlasterror(NULL), SRT_EINVPARAM);
+
+        ASSERT_EQ(srt_recvmsg_loan(accepted_sock, &loaned[loans], &mctrl), size);
+        EXPECT_EQ(mctrl.msgno, loans + 1);
+
+        SRT_TRACEBSTATS stats;
+        ASSERT_NE(srt_bstats(accepted_sock, &stats, 0), SRT_ERROR);
+        EXPECT_EQ(stats.pktRcvLoaned, loans);
+        EXPECT_EQ(stats.pktRcvLoanedMax, loans);
+        EXPECT_EQ(stats.pktRcvLoanRefusedTotal, 1);
+
+        for (int i = 1; i <= loans; ++i)
+            EXPECT_EQ(srt_loan_return(accepted_sock, &loaned[i]), 0);
+
+        // The rest is read the usual way.
+        for (int i = loans + 1; i < count; ++i)
+        {
+            ASSERT_EQ(srt_recvmsg2(accepted_sock, buf.data(), size, &mctrl), size);
+            EXPECT_EQ(mctrl.msgno, i + 1);
+        }
+
+        ASSERT_NE(srt_bstats(accepted_sock, &stats, 0), SRT_ERROR);
+        EXPECT_EQ(stats.pktRcvLoaned, 0);
+        EXPECT_EQ(stats.pktRcvLoanedMax, loans);
+    });
+
+    (void)srt_cleanup();
+}
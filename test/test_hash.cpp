@@ -0,0 +1,181 @@
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "queue.h"
+
+using namespace std;
+
+// The socket instances are never accessed by the table,
+// so any distinct addresses will do.
+static CUDT* fakeSocket(int i)
+{
+    return reinterpret_cast<CUDT*>(uintptr_t(0x1000 + 16 * i));
+}
+
+// Socket IDs are handed out decreasing from a random start.
+static int32_t socketID(int i)
+{
+    return 0x2A5C3B41 - i;
+}
+
+TEST(CHash, InsertLookupRemove)
+{
+    CHash hash;
+    hash.init(16);
+
+    EXPECT_EQ(hash.lookup(socketID(0)), nullptr);
+
+    for (int i = 0; i < 10; ++i)
+        hash.insert(socketID(i), fakeSocket(i));
+    EXPECT_EQ(hash.size(), 10);
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(hash.lookup(socketID(i)), fakeSocket(i));
+    EXPECT_EQ(hash.lookup(socketID(10)), nullptr);
+
+    // Replace an entry.
+    hash.insert(socketID(3), fakeSocket(100));
+    EXPECT_EQ(hash.size(), 10);
+    EXPECT_EQ(hash.lookup(socketID(3)), fakeSocket(100));
+
+    for (int i = 0; i < 10; i += 2)
+        hash.remove(socketID(i));
+    hash.remove(socketID(10));
+    EXPECT_EQ(hash.size(), 5);
+
+    for (int i = 0; i < 10; ++i)
+        EXPECT_EQ(hash.lookup(socketID(i)), i % 2 ? (i == 3 ? fakeSocket(100) : fakeSocket(i)) : nullptr);
+}
+
+/// The table grows to keep at most half of the slots used,
+/// and the slots of removed entries are reused.
+TEST(CHash, Grow)
+{
+    CHash hash;
+    hash.init(4);
+    const int initial = hash.capacity();
+
+    const int count = 1000;
+    for (int i = 0; i < count; ++i)
+        hash.insert(socketID(i), fakeSocket(i));
+    EXPECT_GE(hash.capacity(), 2 * count);
+    for (int i = 0; i < count; ++i)
+        ASSERT_EQ(hash.lookup(socketID(i)), fakeSocket(i));
+
+    for (int i = 0; i < count; ++i)
+        hash.remove(socketID(i));
+    EXPECT_EQ(hash.size(), 0);
+
+    // Connections keep coming and going, but the table doesn't grow.
+    const int capacity = hash.capacity();
+    for (int i = count; i < 50 * count; ++i)
+    {
+        hash.insert(socketID(i), fakeSocket(i));
+        hash.remove(socketID(i));
+    }
+    EXPECT_LE(hash.capacity(), capacity);
+    EXPECT_GE(hash.capacity(), initial);
+}
+
+namespace
+{
+// The former socket lookup table, as a reference for the benchmark:
+// an array of lists of buckets allocated with each insertion.
+class CListHash
+{
+public:
+    explicit CListHash(int size) : m_vBucket(size, NULL) {}
+    ~CListHash()
+    {
+        for (size_t i = 0; i < m_vBucket.size(); ++i)
+        {
+            while (m_vBucket[i])
+            {
+                CBucket* n = m_vBucket[i]->m_pNext;
+                delete m_vBucket[i];
+                m_vBucket[i] = n;
+            }
+        }
+    }
+
+    CUDT* lookup(int32_t id) const
+    {
+        for (const CBucket* b = m_vBucket[id % m_vBucket.size()]; b; b = b->m_pNext)
+            if (b->m_iID == id)
+                return b->m_pUDT;
+        return NULL;
+    }
+
+    void insert(int32_t id, CUDT* u)
+    {
+        CBucket* n = new CBucket;
+        n->m_iID = id;
+        n->m_pUDT = u;
+        n->m_pNext = m_vBucket[id % m_vBucket.size()];
+        m_vBucket[id % m_vBucket.size()] = n;
+    }
+
+private:
+    struct CBucket
+    {
+        int32_t m_iID;
+        CUDT* m_pUDT;
+        CBucket* m_pNext;
+    };
+    std::vector<CBucket*> m_vBucket;
+};
+
+template <class Table>
+double lookupTime(const Table& table, const vector<int32_t>& order, int rounds)
+{
+    size_t found = 0;
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+        for (size_t i = 0; i < order.size(); ++i)
+            found += table.lookup(order[i]) != NULL;
+    const chrono::steady_clock::time_point end = chrono::steady_clock::now();
+
+    EXPECT_EQ(found, order.size() * rounds);
+    return chrono::duration<double, nano>(end - start).count() / (order.size() * rounds);
+}
+}
+
+/// Lookups of 10000 sockets, in the order in which the packets
+/// of many connections arrive, with the size of the table
+/// used by the multiplexer. Timing only, run with
+/// --gtest_also_run_disabled_tests.
+TEST(CHash, DISABLED_Benchmark10k)
+{
+    const int sockets = 10000;
+    const int rounds = 50;
+
+    CHash hash;
+    hash.init(1024);
+    CListHash list_hash(1024);
+
+    // Insert in random order, so that the buckets of the former table
+    // are allocated like for the sockets that connect over time.
+    vector<int32_t> ids;
+    for (int i = 0; i < sockets; ++i)
+        ids.push_back(socketID(i));
+    std::srand(1);
+    for (int i = sockets - 1; i > 0; --i)
+        std::swap(ids[i], ids[std::rand() % (i + 1)]);
+
+    for (int i = 0; i < sockets; ++i)
+    {
+        hash.insert(ids[i], fakeSocket(i));
+        list_hash.insert(ids[i], fakeSocket(i));
+    }
+
+    vector<int32_t> order(ids);
+    for (int i = sockets - 1; i > 0; --i)
+        std::swap(order[i], order[std::rand() % (i + 1)]);
+
+    const double ns_list = lookupTime(list_hash, order, rounds);
+    const double ns_hash = lookupTime(hash, order, rounds);
+
+    cout << "Lookup of " << sockets << " sockets: lists of buckets " << ns_list << " ns, open addressing "
+        << ns_hash << " ns" << endl;
+}
@@ -0,0 +1,1017 @@
+/*
+ * SRT - Secure, Reliable, Transport
+ * Copyright (c) 2020 Haivision Systems Inc.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ */
+
+#include <gtest/gtest.h>
+
+#ifdef _WIN32
+#define INC_SRT_WIN_WINTIME // exclude gettimeofday from srt headers
+#endif
+
+#include "srt.h"
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Not available in older googletest releases.
+#ifndef GTEST_SKIP
+#define GTEST_SKIP() return
+#endif
+
+namespace
+{
+
+typedef std::vector< std::pair<SRT_SOCKOPT, int> > OptionList;
+
+// Transfers 'count' messages of 'size' bytes from a caller to an accepted
+// socket, both configured with the given options, and checks the content.
+// Statistics of the sending and receiving side are returned in 'w_sndstats'
+// and 'w_rcvstats'; the latter stay zero unless all messages arrive.
+void TransmitWithOptions(int port, const OptionList& opts, size_t count, size_t size,
+        SRT_TRACEBSTATS& w_sndstats, SRT_TRACEBSTATS& w_rcvstats)
+{
+    w_sndstats = SRT_TRACEBSTATS();
+    w_rcvstats = SRT_TRACEBSTATS();
+
+    SRTSOCKET sock_lsn = srt_create_socket(), sock_clr = srt_create_socket();
+
+    int tt = SRTT_FILE;
+    ASSERT_NE(srt_setsockflag(sock_lsn, SRTO_TRANSTYPE, &tt, sizeof tt), SRT_ERROR);
+    ASSERT_NE(srt_setsockflag(sock_clr, SRTO_TRANSTYPE, &tt, sizeof tt), SRT_ERROR);
+
+    bool yes = true;
+    ASSERT_NE(srt_setsockflag(sock_lsn, SRTO_MESSAGEAPI, &yes, sizeof yes), SRT_ERROR);
+    ASSERT_NE(srt_setsockflag(sock_clr, SRTO_MESSAGEAPI, &yes, sizeof yes), SRT_ERROR);
+
+    for (OptionList::const_iterator i = opts.begin(); i != opts.end(); ++i)
+    {
+        ASSERT_NE(srt_setsockflag(sock_lsn, i->first, &i->second, sizeof i->second), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(sock_clr, i->first, &i->second, sizeof i->second), SRT_ERROR);
+    }
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, 1), SRT_ERROR);
+
+    size_t received = 0;
+    size_t corrupted = 0;
+
+    std::thread receiver([&]
+    {
+        sockaddr_in remote;
+        int len = sizeof remote;
+        const SRTSOCKET accepted_sock = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+        if (accepted_sock == SRT_INVALID_SOCK)
+            return;
+
+        std::vector<char> buf(size);
+        for (;;)
+        {
+            const int n = srt_recvmsg(accepted_sock, &buf[0], int(size));
+            if (n <= 0)
+                break;
+
+            const char expected = char(received);
+            for (int i = 0; i < n; ++i)
+            {
+                if (buf[i] != expected)
+                {
+                    ++corrupted;
+                    break;
+                }
+            }
+            ++received;
+
+            if (received == count)
+                srt_bstats(accepted_sock, &w_rcvstats, 0);
+        }
+
+        srt_close(accepted_sock);
+    });
+
+    ASSERT_NE(srt_connect(sock_clr, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+
+    std::vector<char> buf(size);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::fill(buf.begin(), buf.end(), char(i));
+        ASSERT_EQ(srt_sendmsg(sock_clr, &buf[0], int(size), -1, true), int(size));
+    }
+
+    // Wait until everything is acknowledged before closing.
+    for (int i = 0; i < 100; ++i)
+    {
+        size_t blocks = 0;
+        ASSERT_NE(srt_getsndbuffer(sock_clr, &blocks, NULL), SRT_ERROR);
+        if (blocks == 0)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    ASSERT_NE(srt_bstats(sock_clr, &w_sndstats, 0), SRT_ERROR);
+
+    srt_close(sock_clr);
+    receiver.join();
+    srt_close(sock_lsn);
+
+    ASSERT_EQ(received, count);
+    EXPECT_EQ(corrupted, 0u);
+}
+
+// Tells if the system supports a feature of the multiplexer, which is then
+// reported as on by a socket bound with the given options.
+bool MuxSupports(const OptionList& opts, SRT_SOCKOPT feature)
+{
+    SRTSOCKET sock = srt_create_socket();
+    for (OptionList::const_iterator i = opts.begin(); i != opts.end(); ++i)
+        srt_setsockflag(sock, i->first, &i->second, sizeof i->second);
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr);
+
+    bool value = false;
+    int optlen = sizeof value;
+    if (srt_bind(sock, (sockaddr*)&sa, sizeof sa) == SRT_ERROR
+            || srt_getsockflag(sock, feature, &value, &optlen) == SRT_ERROR)
+        value = false;
+
+    srt_close(sock);
+    return value;
+}
+
+// A multiplexer option with its default, a valid value to set and the values
+// out of range. The boolean options have no invalid values.
+struct MuxOption
+{
+    SRT_SOCKOPT opt;
+    const char* name;
+    bool boolean;
+    int defval;
+    int valid;
+    std::vector<int> invalid;
+};
+
+const MuxOption g_MuxOptions[] = {
+    { SRTO_UDP_SNDBATCH,     "SRTO_UDP_SNDBATCH",     false, 1, 32, { 0, 65 } },
+    { SRTO_UDP_RCVBATCH,     "SRTO_UDP_RCVBATCH",     false, 1, 8, { 0, 65 } },
+    { SRTO_UDP_GSO,          "SRTO_UDP_GSO",          true, 0, 1, {} },
+    { SRTO_UDP_GRO,          "SRTO_UDP_GRO",          true, 0, 1, {} },
+    { SRTO_UDP_RCVSHARDS,    "SRTO_UDP_RCVSHARDS",    false, 1, 4, { 0, 17 } },
+    { SRTO_UDP_SNDSHARDS,    "SRTO_UDP_SNDSHARDS",    false, 1, 4, { 0, 17 } },
+    { SRTO_UDP_IOURING,      "SRTO_UDP_IOURING",      true, 0, 1, {} },
+    { SRTO_UDP_TXTIME,       "SRTO_UDP_TXTIME",       true, 0, 1, {} },
+    { SRTO_UDP_TIMESTAMP,    "SRTO_UDP_TIMESTAMP",    true, 0, 1, {} },
+    { SRTO_UDP_RCVPOOLHOLD,  "SRTO_UDP_RCVPOOLHOLD",  false, 10000, -1, { -2 } },
+    { SRTO_BUFALLOC,         "SRTO_BUFALLOC",         false, SRT_BUFALLOC_DEFAULT, SRT_BUFALLOC_HUGEPAGES_NUMA, { 3 } },
+    { SRTO_UDP_SNDSCHED,     "SRTO_UDP_SNDSCHED",     false, SRT_SNDSCHED_HEAP, SRT_SNDSCHED_WHEEL, { 2 } },
+    { SRTO_UDP_SINGLETHREAD, "SRTO_UDP_SINGLETHREAD", true, 0, 1, {} },
+    { SRTO_UDP_NOTHREADS,    "SRTO_UDP_NOTHREADS",    true, 0, 1, {} }
+};
+
+int GetMuxOption(SRTSOCKET sock, const MuxOption& o)
+{
+    if (o.boolean)
+    {
+        bool value = !o.defval;
+        int optlen = sizeof value;
+        EXPECT_NE(srt_getsockflag(sock, o.opt, &value, &optlen), SRT_ERROR) << o.name;
+        return value;
+    }
+
+    int value = -100;
+    int optlen = sizeof value;
+    EXPECT_NE(srt_getsockflag(sock, o.opt, &value, &optlen), SRT_ERROR) << o.name;
+    return value;
+}
+
+int SetMuxOption(SRTSOCKET sock, const MuxOption& o, int value)
+{
+    if (o.boolean)
+    {
+        const bool b = value != 0;
+        return srt_setsockflag(sock, o.opt, &b, sizeof b);
+    }
+    return srt_setsockflag(sock, o.opt, &value, sizeof value);
+}
+
+}
+
+TEST(Multiplexer, Options)
+{
+    srt_startup();
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    for (size_t i = 0; i < sizeof g_MuxOptions / sizeof g_MuxOptions[0]; ++i)
+    {
+        const MuxOption& o = g_MuxOptions[i];
+        SRTSOCKET sock = srt_create_socket();
+
+        EXPECT_EQ(GetMuxOption(sock, o), o.defval) << o.name;
+
+        for (size_t v = 0; v < o.invalid.size(); ++v)
+            EXPECT_EQ(SetMuxOption(sock, o, o.invalid[v]), SRT_ERROR) << o.name << " = " << o.invalid[v];
+
+        EXPECT_NE(SetMuxOption(sock, o, o.valid), SRT_ERROR) << o.name;
+        EXPECT_EQ(GetMuxOption(sock, o), o.valid) << o.name;
+
+        // Multiplexer options can't be changed once the socket is bound.
+        ASSERT_NE(srt_bind(sock, (sockaddr*)&sa, sizeof sa), SRT_ERROR) << o.name;
+        EXPECT_EQ(SetMuxOption(sock, o, o.valid), SRT_ERROR) << o.name;
+
+        srt_close(sock);
+    }
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, SndBatchTransmission)
+{
+#ifndef HAVE_SENDMMSG
+    GTEST_SKIP();
+#endif
+    srt_startup();
+
+    const int batch = 16;
+    SRT_TRACEBSTATS stats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5610, OptionList(1, std::make_pair(SRTO_UDP_SNDBATCH, batch)),
+            2000, 1316, stats, rcvstats));
+
+    EXPECT_GE(stats.pktSndBatchTotal, stats.pktSentTotal);
+    EXPECT_GT(stats.sndBatchCallsTotal, 0);
+    EXPECT_LT(stats.sndBatchCallsTotal, stats.pktSndBatchTotal);
+    EXPECT_GT(stats.sndBatchDepthMax, 1);
+    EXPECT_LE(stats.sndBatchDepthMax, batch);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, RcvBatchTransmission)
+{
+#ifndef HAVE_RECVMMSG
+    GTEST_SKIP();
+#endif
+    srt_startup();
+
+    const int batch = 32;
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5611, OptionList(1, std::make_pair(SRTO_UDP_RCVBATCH, batch)),
+            2000, 1316, sndstats, rcvstats));
+
+    // Includes also the packets for the listener socket.
+    EXPECT_GE(rcvstats.pktRcvBatchTotal, rcvstats.pktRecvTotal);
+    EXPECT_GT(rcvstats.rcvBatchCallsTotal, 0);
+    EXPECT_LE(rcvstats.rcvBatchCallsTotal, rcvstats.pktRcvBatchTotal);
+    EXPECT_GT(rcvstats.rcvBatchDepthMax, 1);
+    EXPECT_LE(rcvstats.rcvBatchDepthMax, batch);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, GsoTransmission)
+{
+    srt_startup();
+
+    const int batch = 16;
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, batch));
+    opts.push_back(std::make_pair(SRTO_UDP_GSO, 1));
+
+    if (!MuxSupports(opts, SRTO_UDP_GSO))
+    {
+        srt_cleanup();
+        GTEST_SKIP();
+    }
+
+    SRT_TRACEBSTATS stats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5612, opts, 2000, 1316, stats, rcvstats));
+
+    EXPECT_GE(stats.pktSndBatchTotal, stats.pktSentTotal);
+    EXPECT_GT(stats.pktSndGsoTotal, 0);
+    EXPECT_LE(stats.pktSndGsoTotal, stats.pktSndBatchTotal);
+    EXPECT_LE(stats.sndBatchDepthMax, batch);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, GroTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, 16));
+    opts.push_back(std::make_pair(SRTO_UDP_GSO, 1));
+    opts.push_back(std::make_pair(SRTO_UDP_GRO, 1));
+
+    // Only the datagrams sent with segmentation offload arrive coalesced.
+    if (!MuxSupports(opts, SRTO_UDP_GSO) || !MuxSupports(opts, SRTO_UDP_GRO))
+    {
+        srt_cleanup();
+        GTEST_SKIP();
+    }
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5613, opts, 2000, 1316, sndstats, rcvstats));
+
+    EXPECT_GE(rcvstats.pktRcvBatchTotal, rcvstats.pktRecvTotal);
+    EXPECT_GT(rcvstats.pktRcvGroTotal, 0);
+    EXPECT_LE(rcvstats.pktRcvGroTotal, rcvstats.pktRcvBatchTotal);
+    // Every segment of a coalesced datagram has the datagram's arrival time.
+    EXPECT_EQ(rcvstats.pktRcvTimestampTotal, rcvstats.pktRcvBatchTotal);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, RcvShardsManyCallers)
+{
+    srt_startup();
+
+    const int shards = 4;
+    const int callers = 8;
+    const int count = 200;
+    const int size = 1316;
+
+    // The senders burst faster than live mode expects; keep late packets
+    // instead of dropping them so that the byte count is deterministic.
+    const bool no = false;
+
+    SRTSOCKET sock_lsn = srt_create_socket();
+    ASSERT_NE(srt_setsockflag(sock_lsn, SRTO_UDP_RCVSHARDS, &shards, sizeof shards), SRT_ERROR);
+    ASSERT_NE(srt_setsockflag(sock_lsn, SRTO_TLPKTDROP, &no, sizeof no), SRT_ERROR);
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5614);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, callers), SRT_ERROR);
+
+    // Another socket may share the listener's port, but can't connect through it.
+    SRTSOCKET sock_same = srt_create_socket();
+    ASSERT_NE(srt_setsockflag(sock_same, SRTO_UDP_RCVSHARDS, &shards, sizeof shards), SRT_ERROR);
+    ASSERT_NE(srt_bind(sock_same, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    EXPECT_EQ(srt_connect(sock_same, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    srt_close(sock_same);
+
+    std::vector<size_t> received(callers, 0);
+    std::vector<SRTSOCKET> sock_acc;
+    std::vector<std::thread> readers;
+
+    std::thread acceptor([&]
+    {
+        for (int c = 0; c < callers; ++c)
+        {
+            sockaddr_in remote;
+            int len = sizeof remote;
+            const SRTSOCKET accepted_sock = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+            if (accepted_sock == SRT_INVALID_SOCK)
+                return;
+
+            sock_acc.push_back(accepted_sock);
+            readers.push_back(std::thread([&received, accepted_sock, c]
+            {
+                std::vector<char> buf(size);
+                for (;;)
+                {
+                    const int n = srt_recvmsg(accepted_sock, &buf[0], size);
+                    if (n <= 0)
+                        break;
+                    received[c] += n;
+                }
+                srt_close(accepted_sock);
+            }));
+        }
+    });
+
+    std::vector<SRTSOCKET> sock_clr(callers);
+    for (int c = 0; c < callers; ++c)
+    {
+        sock_clr[c] = srt_create_socket();
+        ASSERT_NE(srt_setsockflag(sock_clr[c], SRTO_TLPKTDROP, &no, sizeof no), SRT_ERROR);
+        ASSERT_NE(srt_connect(sock_clr[c], (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    }
+
+    acceptor.join();
+
+    std::vector<char> buf(size, 'x');
+    for (int i = 0; i < count; ++i)
+    {
+        for (int c = 0; c < callers; ++c)
+            ASSERT_EQ(srt_sendmsg(sock_clr[c], &buf[0], size, -1, true), size);
+    }
+
+    // Live mode: give the last packets some time to be delivered.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+#ifdef __linux__
+    // Every accepted socket is served by the receiving socket that its
+    // packets are steered to, and the traffic is spread over them.
+    std::vector<int64_t> shard_pkts(shards, 0);
+    for (size_t a = 0; a < sock_acc.size(); ++a)
+    {
+        SRT_TRACEBSTATS stats;
+        ASSERT_NE(srt_bstats(sock_acc[a], &stats, 0), SRT_ERROR);
+        EXPECT_EQ(stats.rcvShard, int(sock_acc[a] % shards)) << "@" << sock_acc[a];
+        EXPECT_GE(stats.pktRcvBatchTotal, stats.pktRecvTotal) << "@" << sock_acc[a];
+        if (stats.rcvShard >= 0 && stats.rcvShard < shards)
+            shard_pkts[stats.rcvShard] = stats.pktRcvBatchTotal;
+    }
+    EXPECT_GT(shards - std::count(shard_pkts.begin(), shard_pkts.end(), 0), 1);
+#endif
+
+    for (int c = 0; c < callers; ++c)
+        srt_close(sock_clr[c]);
+    for (size_t r = 0; r < readers.size(); ++r)
+        readers[r].join();
+    srt_close(sock_lsn);
+
+    EXPECT_EQ(readers.size(), size_t(callers));
+    size_t total = 0;
+    for (int c = 0; c < callers; ++c)
+        total += received[c];
+    EXPECT_EQ(total, size_t(callers) * count * size);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, SndShardsTransmission)
+{
+    srt_startup();
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5615, OptionList(1, std::make_pair(SRTO_UDP_SNDSHARDS, 4)),
+            2000, 1316, sndstats, rcvstats));
+
+    // The caller is alone on its multiplexer, while the accepted socket
+    // goes to another thread than the listener.
+    EXPECT_EQ(sndstats.sndShard, 0);
+    EXPECT_EQ(sndstats.sndShardSockets, 1);
+    EXPECT_GT(sndstats.usSndShardBusyTotal, 0);
+    EXPECT_EQ(rcvstats.sndShard, 1);
+    EXPECT_EQ(rcvstats.sndShardSockets, 1);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, IOUringTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, 16));
+    opts.push_back(std::make_pair(SRTO_UDP_IOURING, 1));
+
+    if (!MuxSupports(opts, SRTO_UDP_IOURING))
+    {
+        srt_cleanup();
+        GTEST_SKIP();
+    }
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5616, opts, 2000, 1316, sndstats, rcvstats));
+
+    // The ring keeps several receptions posted at once.
+    EXPECT_LE(sndstats.sndBatchCallsTotal, sndstats.pktSndBatchTotal);
+    EXPECT_GE(rcvstats.pktRcvBatchTotal, rcvstats.pktRecvTotal);
+    EXPECT_GT(rcvstats.rcvBatchDepthMax, 1);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, TxTimeTransmission)
+{
+    srt_startup();
+
+    const int batch = 16;
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, batch));
+    opts.push_back(std::make_pair(SRTO_UDP_TXTIME, 1));
+
+    if (!MuxSupports(opts, SRTO_UDP_TXTIME))
+    {
+        srt_cleanup();
+        GTEST_SKIP();
+    }
+
+    SRT_TRACEBSTATS stats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5617, opts, 2000, 1316, stats, rcvstats));
+
+    // Without an fq qdisc on the interface the packets leave immediately,
+    // but they are still handed over with their departure times.
+    EXPECT_GE(stats.pktSndBatchTotal, stats.pktSentTotal);
+    EXPECT_GT(stats.pktSndTxTimeTotal, 0);
+    EXPECT_LE(stats.pktSndTxTimeTotal, stats.pktSndBatchTotal);
+    EXPECT_LE(stats.sndBatchDepthMax, batch);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, TimestampTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, 16));
+    opts.push_back(std::make_pair(SRTO_UDP_RCVBATCH, 16));
+    opts.push_back(std::make_pair(SRTO_UDP_TIMESTAMP, 1));
+
+    if (!MuxSupports(opts, SRTO_UDP_TIMESTAMP))
+    {
+        srt_cleanup();
+        GTEST_SKIP();
+    }
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5618, opts, 2000, 1316, sndstats, rcvstats));
+
+    // Every packet carries its arrival time taken from the system.
+    EXPECT_GE(rcvstats.pktRcvBatchTotal, rcvstats.pktRecvTotal);
+    EXPECT_EQ(rcvstats.pktRcvTimestampTotal, rcvstats.pktRcvBatchTotal);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, BufAllocTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_BUFALLOC, int(SRT_BUFALLOC_HUGEPAGES_NUMA)));
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5619, opts, 2000, 1316, sndstats, rcvstats));
+
+#ifdef __linux__
+    // The pool is allocated in whole huge pages.
+    EXPECT_GE(rcvstats.rcvUnitsCapacity, 1024);
+#endif
+    EXPECT_LE(rcvstats.rcvUnitsAvail, rcvstats.rcvUnitsCapacity);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, SndSchedTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SNDSCHED, int(SRT_SNDSCHED_WHEEL)));
+    opts.push_back(std::make_pair(SRTO_UDP_SNDSHARDS, 2));
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5620, opts, 2000, 1316, sndstats, rcvstats));
+
+    // Every sending thread of the multiplexer uses the timing wheel.
+    EXPECT_EQ(sndstats.sndSched, SRT_SNDSCHED_WHEEL);
+    EXPECT_EQ(rcvstats.sndSched, SRT_SNDSCHED_WHEEL);
+    EXPECT_EQ(rcvstats.sndShard, 1);
+    EXPECT_GT(sndstats.usSndShardBusyTotal, 0);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, SingleThreadTransmission)
+{
+    srt_startup();
+
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SINGLETHREAD, 1));
+    opts.push_back(std::make_pair(SRTO_UDP_SNDSHARDS, 2));
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5627, opts, 2000, 1316, sndstats, rcvstats));
+
+    // The receiving thread sends the packets of all sockets itself,
+    // so no other sending thread is started.
+    EXPECT_EQ(rcvstats.sndShard, 0);
+    EXPECT_EQ(rcvstats.sndShardSockets, 2);
+    EXPECT_GT(sndstats.usSndShardBusyTotal, 0);
+    EXPECT_EQ(sndstats.sndBatchDepthMax, 1);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, SingleThreadBatchTransmission)
+{
+    srt_startup();
+
+    const int batch = 16;
+    OptionList opts;
+    opts.push_back(std::make_pair(SRTO_UDP_SINGLETHREAD, 1));
+    opts.push_back(std::make_pair(SRTO_UDP_SNDBATCH, batch));
+    opts.push_back(std::make_pair(SRTO_UDP_RCVBATCH, batch));
+    opts.push_back(std::make_pair(SRTO_UDP_SNDSHARDS, 2));
+
+    SRT_TRACEBSTATS sndstats, rcvstats;
+    ASSERT_NO_FATAL_FAILURE(TransmitWithOptions(5628, opts, 2000, 1316, sndstats, rcvstats));
+
+    EXPECT_EQ(rcvstats.sndShard, 0);
+    EXPECT_EQ(rcvstats.sndShardSockets, 2);
+    EXPECT_LE(sndstats.sndBatchDepthMax, batch);
+    EXPECT_LE(rcvstats.rcvBatchDepthMax, batch);
+#ifdef HAVE_SENDMMSG
+    EXPECT_GT(sndstats.sndBatchDepthMax, 1);
+    EXPECT_LT(sndstats.sndBatchCallsTotal, sndstats.pktSndBatchTotal);
+#endif
+#ifdef HAVE_RECVMMSG
+    EXPECT_GT(rcvstats.rcvBatchDepthMax, 1);
+#endif
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, NoThreadsDriven)
+{
+    srt_startup();
+
+    SRTSOCKET sock = srt_create_socket(), sock_thr = srt_create_socket();
+
+    const bool yes = true;
+    ASSERT_NE(srt_setsockflag(sock, SRTO_UDP_NOTHREADS, &yes, sizeof yes), SRT_ERROR);
+
+    // Not bound to any multiplexer yet
+    SYSSOCKET fd = SYSSOCKET(-1);
+    EXPECT_EQ(srt_mux_fd(sock, &fd), SRT_ERROR);
+    EXPECT_EQ(srt_mux_process(sock), SRT_ERROR);
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+    ASSERT_NE(srt_bind(sock, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_bind(sock_thr, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+
+    EXPECT_EQ(srt_mux_fd(sock, &fd), 0);
+    EXPECT_NE(fd, SYSSOCKET(-1));
+    EXPECT_EQ(srt_mux_process(sock), 0);
+
+    // Nothing to do, but the timers are checked at least as often as by a worker.
+    const int64_t now = srt_time_now();
+    const int64_t deadline = srt_mux_next_deadline(sock);
+    EXPECT_GE(deadline, now - 1000);
+    EXPECT_LE(deadline, now + 20000);
+
+    // The multiplexer driven by its threads can't be driven by the application.
+    EXPECT_EQ(srt_mux_fd(sock_thr, &fd), SRT_ERROR);
+    EXPECT_EQ(srt_mux_process(sock_thr), SRT_ERROR);
+    EXPECT_EQ(srt_mux_next_deadline(sock_thr), SRT_ERROR);
+
+    srt_close(sock);
+    srt_close(sock_thr);
+    srt_cleanup();
+}
+
+// Processes the multiplexers of the given sockets until 'done' returns true,
+// waiting for their UDP sockets in between as an event loop of the application
+// would. Returns false if the time was out before.
+static bool DriveMuxes(const std::vector<SRTSOCKET>& socks, const std::function<bool()>& done, int timeout_ms)
+{
+    const int64_t end = srt_time_now() + int64_t(timeout_ms) * 1000;
+    while (!done())
+    {
+        fd_set set;
+        FD_ZERO(&set);
+        int nfds = 0;
+        int64_t deadline = end;
+        for (size_t i = 0; i < socks.size(); ++i)
+        {
+            SYSSOCKET fd;
+            if (srt_mux_process(socks[i]) == SRT_ERROR || srt_mux_fd(socks[i], &fd) == SRT_ERROR)
+                return false;
+
+            FD_SET(fd, &set);
+            nfds = std::max(nfds, int(fd) + 1);
+            deadline = std::min(deadline, srt_mux_next_deadline(socks[i]));
+        }
+
+        const int64_t now = srt_time_now();
+        if (now >= end)
+            return false;
+
+        const int64_t wait_us = std::max<int64_t>(0, deadline - now);
+        timeval tv;
+        tv.tv_sec = long(wait_us / 1000000);
+        tv.tv_usec = long(wait_us % 1000000);
+        ::select(nfds, &set, NULL, NULL, &tv);
+    }
+    return true;
+}
+
+TEST(Multiplexer, NoThreadsTransmission)
+{
+    srt_startup();
+
+    SRTSOCKET sock_lsn = srt_create_socket(), sock_clr = srt_create_socket();
+
+    int tt = SRTT_FILE;
+    bool yes = true, no = false;
+    const SRTSOCKET socks[] = { sock_lsn, sock_clr };
+    for (size_t i = 0; i < 2; ++i)
+    {
+        ASSERT_NE(srt_setsockflag(socks[i], SRTO_TRANSTYPE, &tt, sizeof tt), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(socks[i], SRTO_MESSAGEAPI, &yes, sizeof yes), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(socks[i], SRTO_UDP_NOTHREADS, &yes, sizeof yes), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(socks[i], SRTO_RCVSYN, &no, sizeof no), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(socks[i], SRTO_SNDSYN, &no, sizeof no), SRT_ERROR);
+    }
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5629);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, 1), SRT_ERROR);
+    ASSERT_NE(srt_connect(sock_clr, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+
+    // The accepted socket shares the multiplexer of the listener.
+    std::vector<SRTSOCKET> muxes;
+    muxes.push_back(sock_lsn);
+    muxes.push_back(sock_clr);
+
+    const size_t count = 1000, size = 1316;
+    SRTSOCKET sock_acc = SRT_INVALID_SOCK;
+    size_t sent = 0, received = 0, corrupted = 0;
+    std::vector<char> sndbuf(size), rcvbuf(size);
+
+    const bool done = DriveMuxes(muxes, [&]() -> bool
+    {
+        if (sock_acc == SRT_INVALID_SOCK)
+        {
+            sockaddr_in remote;
+            int len = sizeof remote;
+            sock_acc = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+            if (sock_acc == SRT_INVALID_SOCK)
+                return false;
+        }
+
+        while (sent < count && srt_getsockstate(sock_clr) == SRTS_CONNECTED)
+        {
+            std::fill(sndbuf.begin(), sndbuf.end(), char(sent));
+            if (srt_sendmsg(sock_clr, &sndbuf[0], int(size), -1, true) == SRT_ERROR)
+                break;
+            ++sent;
+        }
+
+        for (;;)
+        {
+            const int n = srt_recvmsg(sock_acc, &rcvbuf[0], int(size));
+            if (n <= 0)
+                break;
+
+            for (int i = 0; i < n; ++i)
+            {
+                if (rcvbuf[i] != char(received))
+                {
+                    ++corrupted;
+                    break;
+                }
+            }
+            ++received;
+        }
+        return received == count;
+    }, 10000);
+
+    EXPECT_TRUE(done);
+    EXPECT_EQ(received, count);
+    EXPECT_EQ(corrupted, 0u);
+
+    srt_close(sock_acc);
+    srt_close(sock_clr);
+    srt_close(sock_lsn);
+    srt_cleanup();
+}
+
+TEST(Multiplexer, IdleTimerChecks)
+{
+    srt_startup();
+
+    const int callers = 16;
+
+    SRTSOCKET sock_lsn = srt_create_socket();
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5621);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, callers), SRT_ERROR);
+
+    std::vector<SRTSOCKET> sock_clr(callers);
+    for (int c = 0; c < callers; ++c)
+    {
+        sock_clr[c] = srt_create_socket();
+        ASSERT_NE(srt_connect(sock_clr[c], (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    }
+
+    std::vector<SRTSOCKET> sock_acc;
+    for (int c = 0; c < callers; ++c)
+    {
+        sockaddr_in remote;
+        int len = sizeof remote;
+        const SRTSOCKET accepted_sock = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+        ASSERT_NE(accepted_sock, SRT_INVALID_SOCK);
+        sock_acc.push_back(accepted_sock);
+    }
+
+    // Let the connections idle, exchanging only keepalives.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2500));
+
+    SRT_TRACEBSTATS stats;
+    ASSERT_NE(srt_bstats(sock_acc[0], &stats, 0), SRT_ERROR);
+
+    // Checking every socket every 10 ms would make 100 checks per second each.
+    EXPECT_GT(stats.timerChecksTotal, 0);
+    EXPECT_GT(stats.timerChecksRate, 0);
+    EXPECT_LT(stats.timerChecksRate, callers * 20);
+
+    for (int c = 0; c < callers; ++c)
+    {
+        srt_close(sock_clr[c]);
+        srt_close(sock_acc[c]);
+    }
+    srt_close(sock_lsn);
+
+    srt_cleanup();
+}
+
+// Waits until none of the sockets is connecting any more, for at most the given time.
+static void WaitConnected(const std::vector<SRTSOCKET>& socks, int timeout_ms)
+{
+    for (int t = 0; t < timeout_ms; t += 10)
+    {
+        size_t connecting = 0;
+        for (size_t i = 0; i < socks.size(); ++i)
+        {
+            if (srt_getsockstate(socks[i]) == SRTS_CONNECTING)
+                ++connecting;
+        }
+        if (connecting == 0)
+            return;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+}
+
+TEST(Multiplexer, ManyAsyncConnects)
+{
+    srt_startup();
+
+    const int callers = 200;
+    const bool no = false;
+
+    SRTSOCKET sock_lsn = srt_create_socket();
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5622);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, callers), SRT_ERROR);
+
+    std::vector<SRTSOCKET> sock_acc;
+    std::thread acceptor([&]
+    {
+        for (int c = 0; c < callers; ++c)
+        {
+            sockaddr_in remote;
+            int len = sizeof remote;
+            const SRTSOCKET accepted_sock = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+            if (accepted_sock == SRT_INVALID_SOCK)
+                return;
+            sock_acc.push_back(accepted_sock);
+        }
+    });
+
+    // All the callers share one multiplexer and are pending at the same time.
+    sockaddr_in local = sa;
+    local.sin_port = htons(5623);
+
+    std::vector<SRTSOCKET> sock_clr(callers);
+    for (int c = 0; c < callers; ++c)
+    {
+        sock_clr[c] = srt_create_socket();
+        ASSERT_NE(srt_setsockflag(sock_clr[c], SRTO_RCVSYN, &no, sizeof no), SRT_ERROR);
+        ASSERT_NE(srt_bind(sock_clr[c], (sockaddr*)&local, sizeof local), SRT_ERROR);
+        ASSERT_NE(srt_connect(sock_clr[c], (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    }
+
+    WaitConnected(sock_clr, 5000);
+    acceptor.join();
+
+    int connected = 0;
+    for (int c = 0; c < callers; ++c)
+    {
+        if (srt_getsockstate(sock_clr[c]) == SRTS_CONNECTED)
+            ++connected;
+    }
+    EXPECT_EQ(connected, callers);
+    EXPECT_EQ(sock_acc.size(), size_t(callers));
+
+    for (size_t i = 0; i < sock_acc.size(); ++i)
+        srt_close(sock_acc[i]);
+    for (int c = 0; c < callers; ++c)
+        srt_close(sock_clr[c]);
+    srt_close(sock_lsn);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, ManyAsyncConnectsTimeout)
+{
+    srt_startup();
+
+    const int callers = 200;
+    const bool no = false;
+    const int timeout_ms = 1000;
+
+    // Nobody listens there.
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5624);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    sockaddr_in local = sa;
+    local.sin_port = htons(5625);
+
+    std::vector<SRTSOCKET> sock_clr(callers);
+    for (int c = 0; c < callers; ++c)
+    {
+        sock_clr[c] = srt_create_socket();
+        ASSERT_NE(srt_setsockflag(sock_clr[c], SRTO_RCVSYN, &no, sizeof no), SRT_ERROR);
+        ASSERT_NE(srt_setsockflag(sock_clr[c], SRTO_CONNTIMEO, &timeout_ms, sizeof timeout_ms), SRT_ERROR);
+        ASSERT_NE(srt_bind(sock_clr[c], (sockaddr*)&local, sizeof local), SRT_ERROR);
+        ASSERT_NE(srt_connect(sock_clr[c], (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    }
+
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    WaitConnected(sock_clr, 5000);
+    const int64_t passed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    // Every one of them expires about its TTL.
+    for (int c = 0; c < callers; ++c)
+    {
+        EXPECT_NE(srt_getsockstate(sock_clr[c]), SRTS_CONNECTING);
+        EXPECT_EQ(srt_getrejectreason(sock_clr[c]), SRT_REJ_TIMEOUT);
+    }
+    EXPECT_LT(passed_ms, timeout_ms + 1000);
+
+    for (int c = 0; c < callers; ++c)
+        srt_close(sock_clr[c]);
+
+    srt_cleanup();
+}
+
+TEST(Multiplexer, EarlyPacketUnits)
+{
+    srt_startup();
+
+    SRTSOCKET sock_lsn = srt_create_socket(), sock_clr = srt_create_socket();
+
+    sockaddr_in sa = sockaddr_in();
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(5626);
+    ASSERT_EQ(inet_pton(AF_INET, "127.0.0.1", &sa.sin_addr), 1);
+
+    ASSERT_NE(srt_bind(sock_lsn, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+    ASSERT_NE(srt_listen(sock_lsn, 1), SRT_ERROR);
+
+    // The handshake responses to a blocking caller are kept in the
+    // units of its receiver pool until the connecting thread reads them.
+    ASSERT_NE(srt_connect(sock_clr, (sockaddr*)&sa, sizeof sa), SRT_ERROR);
+
+    sockaddr_in remote;
+    int len = sizeof remote;
+    const SRTSOCKET sock_acc = srt_accept(sock_lsn, (sockaddr*)&remote, &len);
+    ASSERT_NE(sock_acc, SRT_INVALID_SOCK);
+
+    // All of them have been given back.
+    SRT_TRACEBSTATS stats;
+    ASSERT_NE(srt_bstats(sock_clr, &stats, 0), SRT_ERROR);
+    EXPECT_GT(stats.rcvUnitsCapacity, 0);
+    EXPECT_EQ(stats.rcvUnitsAvail, stats.rcvUnitsCapacity);
+
+    srt_close(sock_acc);
+    srt_close(sock_clr);
+    srt_close(sock_lsn);
+
+    srt_cleanup();
+}
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include "gtest/gtest.h"
+#include "queue.h"
+
+using namespace std;
+using namespace srt::sync;
+
+// The schedules never access the sockets, the nodes alone will do.
+static vector<CSNode> makeNodes(int count)
+{
+    vector<CSNode> nodes(count);
+    for (int i = 0; i < count; ++i)
+    {
+        nodes[i].m_pUDT = NULL;
+        nodes[i].m_iHeapLoc = -1;
+        nodes[i].m_pPrev = NULL;
+        nodes[i].m_pNext = NULL;
+    }
+    return nodes;
+}
+
+static CSndSchedule* makeSchedule(int sched)
+{
+    if (sched == SRT_SNDSCHED_WHEEL)
+        return new CSndWheel;
+    return new CSndHeap;
+}
+
+class CSndScheduleTest: public ::testing::TestWithParam<int>
+{
+};
+
+TEST_P(CSndScheduleTest, Order)
+{
+    CSndSchedule* s = makeSchedule(GetParam());
+    const steady_clock::time_point base = steady_clock::now();
+
+    // Times from microseconds to beyond the reach of the timing wheel.
+    const int count = 2000;
+    vector<CSNode> nodes = makeNodes(count);
+    vector<int64_t> offsets;
+    std::srand(1);
+    for (int i = 0; i < count; ++i)
+    {
+        int64_t us = std::rand() % 1000;
+        if (i % 4 == 1)
+            us = int64_t(std::rand()) * 1000 % 10000000;
+        else if (i % 4 == 2)
+            us = int64_t(std::rand() % 100) * 60 * 1000000;
+        offsets.push_back(us);
+        s->insert(base + microseconds_from(us), &nodes[i]);
+        EXPECT_GE(nodes[i].m_iHeapLoc, 0);
+    }
+
+    // Take out some of the nodes and put them back elsewhere.
+    for (int i = 0; i < count; i += 7)
+    {
+        s->remove(&nodes[i]);
+        EXPECT_EQ(nodes[i].m_iHeapLoc, -1);
+        offsets[i] = std::rand() % 5000000;
+        s->insert(base + microseconds_from(offsets[i]), &nodes[i]);
+    }
+
+    std::sort(offsets.begin(), offsets.end());
+
+    // Nothing is due before the first node.
+    const steady_clock::time_point first = base + microseconds_from(offsets[0]);
+    EXPECT_EQ(s->top(first - microseconds_from(1)), (CSNode*)NULL);
+    EXPECT_LE(s->nextTime(), first);
+
+    for (int i = 0; i < count; ++i)
+    {
+        const steady_clock::time_point ts = base + microseconds_from(offsets[i]);
+        EXPECT_LE(s->nextTime(), ts);
+
+        CSNode* n = s->top(ts);
+        ASSERT_NE(n, (CSNode*)NULL);
+        EXPECT_EQ(n->m_tsTimeStamp, ts);
+        s->remove(n);
+    }
+
+    EXPECT_EQ(s->top(base + microseconds_from(int64_t(200) * 60 * 1000000)), (CSNode*)NULL);
+    EXPECT_TRUE(is_zero(s->nextTime()));
+    delete s;
+}
+
+TEST_P(CSndScheduleTest, First)
+{
+    CSndSchedule* s = makeSchedule(GetParam());
+    const steady_clock::time_point base = steady_clock::now();
+    vector<CSNode> nodes = makeNodes(4);
+
+    EXPECT_TRUE(s->insert(base + milliseconds_from(10), &nodes[0]));
+    EXPECT_FALSE(s->insert(base + milliseconds_from(20), &nodes[1]));
+    EXPECT_TRUE(s->insert(base + milliseconds_from(5), &nodes[2]));
+    EXPECT_LE(s->nextTime(), base + milliseconds_from(5));
+    EXPECT_EQ(s->top(base + milliseconds_from(5) - microseconds_from(1)), (CSNode*)NULL);
+
+    // A node already due stays first.
+    EXPECT_EQ(s->top(base + milliseconds_from(6)), &nodes[2]);
+    EXPECT_FALSE(s->insert(base + milliseconds_from(7), &nodes[3]));
+    EXPECT_EQ(s->top(base + milliseconds_from(8)), &nodes[2]);
+    s->remove(&nodes[2]);
+    EXPECT_EQ(s->top(base + milliseconds_from(8)), &nodes[3]);
+
+    delete s;
+}
+
+INSTANTIATE_TEST_CASE_P(CSndSchedule, CSndScheduleTest,
+        ::testing::Values(int(SRT_SNDSCHED_HEAP), int(SRT_SNDSCHED_WHEEL)));
+
+// Simulates the sending of a given number of sockets, every one with its own
+// packet interval, for some time of the virtual clock. Every tenth packet
+// the application reschedules a socket, as sendmsg does when the sender
+// buffer was empty. Returns the time per operation on the schedule in ns.
+static double sendingTime(CSndSchedule& s, int sockets, int64_t duration_us, int64_t& w_sent)
+{
+    vector<CSNode> nodes = makeNodes(sockets);
+    vector<int64_t> interval;
+    std::srand(1);
+    const steady_clock::time_point base = steady_clock::now();
+    for (int i = 0; i < sockets; ++i)
+    {
+        interval.push_back(100 + std::rand() % 2000);
+        s.insert(base + microseconds_from(std::rand() % 1000), &nodes[i]);
+    }
+
+    steady_clock::time_point now = base;
+    const steady_clock::time_point end = base + microseconds_from(duration_us);
+    int64_t ops = 0;
+    w_sent = 0;
+
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    while (now < end)
+    {
+        CSNode* n = s.top(now);
+        ++ops;
+        if (!n)
+        {
+            now = s.nextTime();
+            continue;
+        }
+
+        const int i = int(n - &nodes[0]);
+        s.remove(n);
+        s.insert(now + microseconds_from(interval[i]), n);
+        ops += 2;
+        ++w_sent;
+
+        if (w_sent % 10 == 0)
+        {
+            CSNode* r = &nodes[std::rand() % sockets];
+            s.remove(r);
+            s.insert(now, r);
+            ops += 2;
+        }
+    }
+    const chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+
+    return double(chrono::duration_cast<chrono::nanoseconds>(stop - start).count()) / double(ops);
+}
+
+// Timing only, run with --gtest_also_run_disabled_tests.
+TEST(CSndSchedule, DISABLED_Benchmark5k)
+{
+    const int sockets = 5000;
+    const int64_t duration_us = 1000000;
+
+    CSndHeap heap;
+    CSndWheel wheel;
+    int64_t sent_heap = 0, sent_wheel = 0;
+
+    const double ns_heap = sendingTime(heap, sockets, duration_us, (sent_heap));
+    const double ns_wheel = sendingTime(wheel, sockets, duration_us, (sent_wheel));
+
+    cout << "Scheduling of " << sockets << " sockets (" << sent_heap << " packets): heap " << ns_heap
+        << " ns, timing wheel " << ns_wheel << " ns per operation" << endl;
+
+    // Both send the same packets, only possibly in a different
+    // order within the same microsecond.
+    EXPECT_NEAR(double(sent_wheel), double(sent_heap), sent_heap * 0.01);
+}
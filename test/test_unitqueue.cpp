@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <array>
+#include <cstring>
 #include <vector>
 #include "gtest/gtest.h"
 #include "queue.h"
@@ -86,3 +88,129 @@ TEST(CUnitQueue, IncreaseAndFreeGrouped)
             << "Buffer capacity should not exceed two queues of 4 units";
     }
 }
+
+/// Units can be taken in a different order than they are
+/// offered by getNextAvailUnit(), like when the receiver
+/// dispatches a batch of packets. Free units must be found
+/// without growing the queue, and the pool statistics must
+/// follow the units taken and returned.
+TEST(CUnitQueue, TakeOutOfOrder)
+{
+    const int buffer_size_pkts = 8;
+    CUnitQueue unit_queue;
+    unit_queue.init(buffer_size_pkts, 1500, AF_INET);
+
+    vector<CUnit*> taken_units;
+    for (int i = 0; i < buffer_size_pkts / 2; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        unit_queue.makeUnitGood(unit);
+        taken_units.push_back(unit);
+    }
+
+    // Return all of them, then take them again starting from the last one.
+    for_each(taken_units.begin(), taken_units.end(),
+        [&unit_queue](CUnit* u) { unit_queue.makeUnitFree(u); });
+    for_each(taken_units.rbegin(), taken_units.rend(),
+        [&unit_queue](CUnit* u) { unit_queue.makeUnitGood(u); });
+
+    int free_units = 0, capacity = 0;
+    int64_t grown = 0, released = 0;
+    unit_queue.getPoolStats((free_units), (capacity), (grown), (released));
+    EXPECT_EQ(free_units, buffer_size_pkts / 2);
+    EXPECT_EQ(capacity, buffer_size_pkts);
+    EXPECT_EQ(grown, 0);
+
+    // None of the taken units can be offered again.
+    for (int i = 0; i < buffer_size_pkts / 2; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        EXPECT_EQ(find(taken_units.begin(), taken_units.end(), unit), taken_units.end());
+        unit_queue.makeUnitGood(unit);
+    }
+
+    // The queue is full now, so it gets extended.
+    EXPECT_NE(unit_queue.getNextAvailUnit(), nullptr);
+    unit_queue.getPoolStats((free_units), (capacity), (grown), (released));
+    EXPECT_EQ(free_units, buffer_size_pkts);
+    EXPECT_EQ(capacity, 2 * buffer_size_pkts);
+    EXPECT_EQ(grown, 1);
+}
+
+/// Extend the queue by taking many units, then return them all.
+/// The added blocks are released only after the hold-down period,
+/// and the first block is kept.
+TEST(CUnitQueue, Shrink)
+{
+    const int buffer_size_pkts = 4;
+    const int mss = 1500;
+    CUnitQueue unit_queue;
+    unit_queue.init(buffer_size_pkts, mss, AF_INET);
+    unit_queue.setHoldDown(srt::sync::seconds_from(10));
+
+    vector<CUnit*> taken_units;
+    for (int i = 0; i < 5 * buffer_size_pkts; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        unit_queue.makeUnitGood(unit);
+        taken_units.push_back(unit);
+    }
+    const int capacity = unit_queue.capacity();
+    EXPECT_GT(capacity, 5 * buffer_size_pkts);
+
+    // Nothing is released while the units are in use.
+    EXPECT_EQ(unit_queue.shrink(), 0);
+
+    for_each(taken_units.begin(), taken_units.end(),
+        [&unit_queue](CUnit* u) { unit_queue.makeUnitFree(u); });
+
+    // Nor before the hold-down period expires. The check is done at most
+    // every 100 ms, so the queue is released with the next check.
+    EXPECT_EQ(unit_queue.shrink(), 0);
+    unit_queue.setHoldDown(srt::sync::milliseconds_from(0));
+    srt::sync::this_thread::sleep_for(srt::sync::milliseconds_from(150));
+    EXPECT_EQ(unit_queue.shrink(), capacity - buffer_size_pkts);
+    EXPECT_EQ(unit_queue.capacity(), buffer_size_pkts);
+
+    int free_units = 0, pool_size = 0;
+    int64_t grown = 0, released = 0;
+    unit_queue.getPoolStats((free_units), (pool_size), (grown), (released));
+    EXPECT_EQ(free_units, buffer_size_pkts);
+    EXPECT_EQ(released, int64_t(capacity - buffer_size_pkts) * int64_t(mss + sizeof(CUnit)));
+
+    // The remaining units can still be used and the queue extended again.
+    for (int i = 0; i < 2 * buffer_size_pkts; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        unit_queue.makeUnitGood(unit);
+    }
+    EXPECT_EQ(unit_queue.capacity(), 2 * buffer_size_pkts);
+}
+
+/// With huge pages, every block of units takes whole 2 MB pages.
+TEST(CUnitQueue, HugePages)
+{
+    const int buffer_size_pkts = 4;
+    const int mss = 1500;
+    CUnitQueue unit_queue;
+    unit_queue.setAllocPolicy(SRT_BUFALLOC_HUGEPAGES);
+    ASSERT_EQ(unit_queue.init(buffer_size_pkts, mss, AF_INET), 0);
+
+#ifdef __linux__
+    EXPECT_EQ(unit_queue.capacity(), int(2 * 1024 * 1024 / mss));
+#endif
+
+    const int capacity = unit_queue.capacity();
+    for (int i = 0; i <= capacity; ++i)
+    {
+        CUnit* unit = unit_queue.getNextAvailUnit();
+        ASSERT_NE(unit, nullptr);
+        memset(unit->m_Packet.m_pcData, 0xAA, mss);
+        unit_queue.makeUnitGood(unit);
+    }
+    EXPECT_EQ(unit_queue.capacity(), 2 * capacity);
+}